@@ -11,16 +11,36 @@
 
 #include "store-app-tile.h"
 
+/* Only the rows in view plus a margin have tiles, these are rebound to other apps as the view scrolls */
+#define N_COLUMNS   3
+#define MARGIN_ROWS 2
+
 struct _StoreAppGrid
 {
-    GtkGrid parent_instance;
-
-    GtkGrid *app_grid;
+    GtkContainer parent_instance;
 
+    GPtrArray *apps;
+    gint column_spacing;
+    guint first_index;
     StoreModel *model;
+    gint row_height;
+    gint row_height_width;
+    gint row_spacing;
+    GtkScrolledWindow *scrolled_window;
+    GPtrArray *spare_tiles;
+    guint update_source;
+    GPtrArray *visible_tiles;
 };
 
-G_DEFINE_TYPE (StoreAppGrid, store_app_grid, GTK_TYPE_GRID)
+enum
+{
+    PROP_0,
+    PROP_COLUMN_SPACING,
+    PROP_ROW_SPACING,
+    PROP_LAST
+};
+
+G_DEFINE_TYPE (StoreAppGrid, store_app_grid, GTK_TYPE_CONTAINER)
 
 enum
 {
@@ -36,23 +56,401 @@ app_activated_cb (StoreAppGrid *self, StoreAppTile *tile)
     g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, store_app_tile_get_app (tile));
 }
 
+static guint
+get_n_rows (StoreAppGrid *self)
+{
+    return (self->apps->len + N_COLUMNS - 1) / N_COLUMNS;
+}
+
+static gint
+get_column_width (StoreAppGrid *self, gint width)
+{
+    return MAX ((width - (N_COLUMNS - 1) * self->column_spacing) / N_COLUMNS, 0);
+}
+
+static void
+get_visible_range (StoreAppGrid *self, guint *first_index, guint *last_index)
+{
+    guint n_rows = get_n_rows (self);
+    guint first_row = 0, last_row = n_rows;
+
+    /* Without a known row height only show enough rows to measure one */
+    if (self->scrolled_window != NULL && self->row_height <= 0)
+        last_row = MIN (MARGIN_ROWS + 1, n_rows);
+    else if (self->scrolled_window != NULL) {
+        GtkWidget *content = gtk_bin_get_child (GTK_BIN (self->scrolled_window));
+        if (GTK_IS_VIEWPORT (content))
+            content = gtk_bin_get_child (GTK_BIN (content));
+
+        gint x, y;
+        if (gtk_widget_translate_coordinates (GTK_WIDGET (self), content, 0, 0, &x, &y)) {
+            GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment (self->scrolled_window);
+            gint top = MAX ((gint) gtk_adjustment_get_value (adjustment) - y, 0);
+            gint bottom = MAX (top, (gint) (gtk_adjustment_get_value (adjustment) + gtk_adjustment_get_page_size (adjustment)) - y);
+            gint row_stride = self->row_height + self->row_spacing;
+            first_row = CLAMP (top / row_stride - MARGIN_ROWS, 0, (gint) n_rows);
+            last_row = CLAMP ((bottom + row_stride - 1) / row_stride + MARGIN_ROWS, (gint) first_row, (gint) n_rows);
+        }
+        else
+            last_row = MIN (MARGIN_ROWS + 1, n_rows);
+    }
+
+    *first_index = first_row * N_COLUMNS;
+    *last_index = MIN (last_row * N_COLUMNS, self->apps->len);
+}
+
+static StoreAppTile *
+get_spare_tile (StoreAppGrid *self)
+{
+    if (self->spare_tiles->len > 0) {
+        StoreAppTile *tile = g_ptr_array_index (self->spare_tiles, self->spare_tiles->len - 1);
+        g_ptr_array_remove_index_fast (self->spare_tiles, self->spare_tiles->len - 1);
+        return tile;
+    }
+
+    StoreAppTile *tile = store_app_tile_new ();
+    gtk_widget_show (GTK_WIDGET (tile));
+    g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
+    store_app_tile_set_model (tile, self->model);
+    gtk_widget_set_parent (GTK_WIDGET (tile), GTK_WIDGET (self));
+    return tile;
+}
+
+static void set_scrolled_window (StoreAppGrid *self, GtkScrolledWindow *scrolled_window);
+
+static void
+update_tiles (StoreAppGrid *self)
+{
+    if (self->scrolled_window == NULL)
+        set_scrolled_window (self, GTK_SCROLLED_WINDOW (gtk_widget_get_ancestor (GTK_WIDGET (self), GTK_TYPE_SCROLLED_WINDOW)));
+
+    guint first_index, last_index;
+    get_visible_range (self, &first_index, &last_index);
+
+    /* Keep tiles that are still in view, the rest become spare */
+    g_autoptr(GPtrArray) tiles = g_ptr_array_new ();
+    g_ptr_array_set_size (tiles, last_index - first_index);
+    for (guint i = 0; i < self->visible_tiles->len; i++) {
+        StoreAppTile *tile = g_ptr_array_index (self->visible_tiles, i);
+        guint index = self->first_index + i;
+        if (index >= first_index && index < last_index && store_app_tile_get_app (tile) == g_ptr_array_index (self->apps, index))
+            g_ptr_array_index (tiles, index - first_index) = tile;
+        else {
+            gtk_widget_set_child_visible (GTK_WIDGET (tile), FALSE);
+            g_ptr_array_add (self->spare_tiles, tile);
+        }
+    }
+
+    /* Rebind spare tiles to the newly visible apps */
+    for (guint i = 0; i < tiles->len; i++) {
+        if (g_ptr_array_index (tiles, i) != NULL)
+            continue;
+
+        guint index = first_index + i;
+        StoreAppTile *tile = get_spare_tile (self);
+        store_app_tile_set_app (tile, g_ptr_array_index (self->apps, index));
+        store_app_tile_set_prefetch (tile, index < N_COLUMNS); /* First row */
+        gtk_widget_set_child_visible (GTK_WIDGET (tile), TRUE);
+        g_ptr_array_index (tiles, i) = tile;
+    }
+
+    g_ptr_array_set_size (self->visible_tiles, 0);
+    for (guint i = 0; i < tiles->len; i++)
+        g_ptr_array_add (self->visible_tiles, g_ptr_array_index (tiles, i));
+    self->first_index = first_index;
+}
+
+static gint
+measure_row_height (StoreAppGrid *self, gint column_width)
+{
+    gint height = 0;
+    for (guint i = 0; i < self->visible_tiles->len; i++) {
+        GtkWidget *tile = g_ptr_array_index (self->visible_tiles, i);
+        gint minimum_height, natural_height;
+        gtk_widget_get_preferred_height_for_width (tile, column_width, &minimum_height, &natural_height);
+        height = MAX (height, natural_height);
+    }
+
+    return height;
+}
+
+/* Rows are as tall as the tallest tile seen at this width, so the height only grows as tiles come into view
+ * and the visible range (which depends on it) can't oscillate */
+static void
+update_row_height (StoreAppGrid *self, gint column_width)
+{
+    if (column_width != self->row_height_width) {
+        self->row_height = 0;
+        self->row_height_width = column_width;
+    }
+    self->row_height = MAX (self->row_height, measure_row_height (self, column_width));
+}
+
+static gboolean
+is_range_current (StoreAppGrid *self)
+{
+    guint first_index, last_index;
+    get_visible_range (self, &first_index, &last_index);
+    return first_index == self->first_index && last_index == self->first_index + self->visible_tiles->len;
+}
+
+static gboolean
+update_idle_cb (StoreAppGrid *self)
+{
+    self->update_source = 0;
+
+    update_tiles (self);
+
+    /* Not laid out yet, rows are measured when it is */
+    if (!gtk_widget_get_realized (GTK_WIDGET (self))) {
+        gtk_widget_queue_resize (GTK_WIDGET (self));
+        return G_SOURCE_REMOVE;
+    }
+
+    gint row_height = self->row_height;
+    update_row_height (self, get_column_width (self, gtk_widget_get_allocated_width (GTK_WIDGET (self))));
+    if (self->row_height != row_height)
+        gtk_widget_queue_resize (GTK_WIDGET (self));
+    else
+        gtk_widget_queue_allocate (GTK_WIDGET (self));
+
+    return G_SOURCE_REMOVE;
+}
+
+/* Tiles are created and rebound outside of size allocation */
+static void
+schedule_update (StoreAppGrid *self)
+{
+    if (self->update_source != 0)
+        return;
+
+    self->update_source = g_idle_add_full (GTK_PRIORITY_RESIZE - 1, (GSourceFunc) update_idle_cb, self, NULL);
+}
+
+static void
+adjustment_changed_cb (StoreAppGrid *self)
+{
+    if (!is_range_current (self))
+        schedule_update (self);
+}
+
+static void
+set_scrolled_window (StoreAppGrid *self, GtkScrolledWindow *scrolled_window)
+{
+    if (self->scrolled_window == scrolled_window)
+        return;
+
+    if (self->scrolled_window != NULL)
+        g_signal_handlers_disconnect_by_data (gtk_scrolled_window_get_vadjustment (self->scrolled_window), self);
+    self->scrolled_window = scrolled_window;
+    if (scrolled_window != NULL) {
+        GtkAdjustment *adjustment = gtk_scrolled_window_get_vadjustment (scrolled_window);
+        g_signal_connect_object (adjustment, "value-changed", G_CALLBACK (adjustment_changed_cb), self, G_CONNECT_SWAPPED);
+        g_signal_connect_object (adjustment, "changed", G_CALLBACK (adjustment_changed_cb), self, G_CONNECT_SWAPPED);
+    }
+}
+
 static void
 store_app_grid_dispose (GObject *object)
 {
     StoreAppGrid *self = STORE_APP_GRID (object);
 
+    g_clear_handle_id (&self->update_source, g_source_remove);
+    set_scrolled_window (self, NULL);
+    if (self->visible_tiles != NULL) {
+        for (guint i = 0; i < self->visible_tiles->len; i++)
+            gtk_widget_unparent (g_ptr_array_index (self->visible_tiles, i));
+    }
+    if (self->spare_tiles != NULL) {
+        for (guint i = 0; i < self->spare_tiles->len; i++)
+            gtk_widget_unparent (g_ptr_array_index (self->spare_tiles, i));
+    }
+    g_clear_pointer (&self->apps, g_ptr_array_unref);
     g_clear_object (&self->model);
+    g_clear_pointer (&self->spare_tiles, g_ptr_array_unref);
+    g_clear_pointer (&self->visible_tiles, g_ptr_array_unref);
 
     G_OBJECT_CLASS (store_app_grid_parent_class)->dispose (object);
 }
 
+static void
+store_app_grid_get_property (GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    StoreAppGrid *self = STORE_APP_GRID (object);
+
+    switch (prop_id)
+    {
+    case PROP_COLUMN_SPACING:
+        g_value_set_int (value, self->column_spacing);
+        break;
+    case PROP_ROW_SPACING:
+        g_value_set_int (value, self->row_spacing);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+store_app_grid_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    StoreAppGrid *self = STORE_APP_GRID (object);
+
+    switch (prop_id)
+    {
+    case PROP_COLUMN_SPACING:
+        self->column_spacing = g_value_get_int (value);
+        gtk_widget_queue_resize (GTK_WIDGET (self));
+        break;
+    case PROP_ROW_SPACING:
+        self->row_spacing = g_value_get_int (value);
+        gtk_widget_queue_resize (GTK_WIDGET (self));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static GtkSizeRequestMode
+store_app_grid_get_request_mode (GtkWidget *widget G_GNUC_UNUSED)
+{
+    return GTK_SIZE_REQUEST_HEIGHT_FOR_WIDTH;
+}
+
+static void
+store_app_grid_get_preferred_width (GtkWidget *widget, gint *minimum_width, gint *natural_width)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+
+    gint tile_minimum_width = 0, tile_natural_width = 0;
+    for (guint i = 0; i < self->visible_tiles->len; i++) {
+        GtkWidget *tile = g_ptr_array_index (self->visible_tiles, i);
+        gint minimum, natural;
+        gtk_widget_get_preferred_width (tile, &minimum, &natural);
+        tile_minimum_width = MAX (tile_minimum_width, minimum);
+        tile_natural_width = MAX (tile_natural_width, natural);
+    }
+
+    *minimum_width = N_COLUMNS * tile_minimum_width + (N_COLUMNS - 1) * self->column_spacing;
+    *natural_width = N_COLUMNS * tile_natural_width + (N_COLUMNS - 1) * self->column_spacing;
+}
+
+static void
+store_app_grid_get_preferred_height_for_width (GtkWidget *widget, gint width, gint *minimum_height, gint *natural_height)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+
+    guint n_rows = get_n_rows (self);
+    update_row_height (self, get_column_width (self, width));
+    gint height = n_rows > 0 ? n_rows * self->row_height + (n_rows - 1) * self->row_spacing : 0;
+    *minimum_height = *natural_height = height;
+}
+
+static void
+store_app_grid_get_preferred_height (GtkWidget *widget, gint *minimum_height, gint *natural_height)
+{
+    gint minimum_width, natural_width;
+    store_app_grid_get_preferred_width (widget, &minimum_width, &natural_width);
+    store_app_grid_get_preferred_height_for_width (widget, minimum_width, minimum_height, natural_height);
+}
+
+static void
+store_app_grid_size_allocate (GtkWidget *widget, GtkAllocation *allocation)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+
+    gtk_widget_set_allocation (widget, allocation);
+
+    gint column_width = get_column_width (self, allocation->width);
+    gint row_height = self->row_height;
+    for (guint i = 0; i < self->visible_tiles->len; i++) {
+        GtkWidget *tile = g_ptr_array_index (self->visible_tiles, i);
+        guint index = self->first_index + i;
+        gint minimum_width, natural_width;
+        gtk_widget_get_preferred_width (tile, &minimum_width, &natural_width);
+        GtkAllocation child_allocation;
+        child_allocation.x = allocation->x + (index % N_COLUMNS) * (column_width + self->column_spacing);
+        child_allocation.y = allocation->y + (index / N_COLUMNS) * (row_height + self->row_spacing);
+        child_allocation.width = column_width;
+        child_allocation.height = row_height;
+        gtk_widget_size_allocate (tile, &child_allocation);
+    }
+
+    /* Resizing may have brought other rows into view */
+    if (!is_range_current (self))
+        schedule_update (self);
+}
+
+static void
+store_app_grid_hierarchy_changed (GtkWidget *widget, GtkWidget *previous_toplevel G_GNUC_UNUSED)
+{
+    StoreAppGrid *self = STORE_APP_GRID (widget);
+    set_scrolled_window (self, GTK_SCROLLED_WINDOW (gtk_widget_get_ancestor (widget, GTK_TYPE_SCROLLED_WINDOW)));
+    schedule_update (self);
+}
+
+static void
+store_app_grid_forall (GtkContainer *container, gboolean include_internals G_GNUC_UNUSED, GtkCallback callback, gpointer callback_data)
+{
+    StoreAppGrid *self = STORE_APP_GRID (container);
+
+    /* Callback may remove the tile */
+    g_autoptr(GPtrArray) tiles = g_ptr_array_new ();
+    for (guint i = 0; self->visible_tiles != NULL && i < self->visible_tiles->len; i++)
+        g_ptr_array_add (tiles, g_ptr_array_index (self->visible_tiles, i));
+    for (guint i = 0; self->spare_tiles != NULL && i < self->spare_tiles->len; i++)
+        g_ptr_array_add (tiles, g_ptr_array_index (self->spare_tiles, i));
+    for (guint i = 0; i < tiles->len; i++)
+        callback (g_ptr_array_index (tiles, i), callback_data);
+}
+
+static void
+store_app_grid_remove (GtkContainer *container, GtkWidget *widget)
+{
+    StoreAppGrid *self = STORE_APP_GRID (container);
+
+    /* Visible tiles are indexed by position, so make them all spare and lay out again */
+    if (!g_ptr_array_remove (self->spare_tiles, widget)) {
+        if (!g_ptr_array_remove (self->visible_tiles, widget))
+            return;
+        for (guint i = 0; i < self->visible_tiles->len; i++) {
+            GtkWidget *tile = g_ptr_array_index (self->visible_tiles, i);
+            gtk_widget_set_child_visible (tile, FALSE);
+            g_ptr_array_add (self->spare_tiles, tile);
+        }
+        g_ptr_array_set_size (self->visible_tiles, 0);
+        gtk_widget_queue_resize (GTK_WIDGET (self));
+    }
+
+    gtk_widget_unparent (widget);
+}
+
 static void
 store_app_grid_class_init (StoreAppGridClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_app_grid_dispose;
+    G_OBJECT_CLASS (klass)->get_property = store_app_grid_get_property;
+    G_OBJECT_CLASS (klass)->set_property = store_app_grid_set_property;
+    GTK_WIDGET_CLASS (klass)->get_request_mode = store_app_grid_get_request_mode;
+    GTK_WIDGET_CLASS (klass)->get_preferred_height = store_app_grid_get_preferred_height;
+    GTK_WIDGET_CLASS (klass)->get_preferred_height_for_width = store_app_grid_get_preferred_height_for_width;
+    GTK_WIDGET_CLASS (klass)->get_preferred_width = store_app_grid_get_preferred_width;
+    GTK_WIDGET_CLASS (klass)->hierarchy_changed = store_app_grid_hierarchy_changed;
+    GTK_WIDGET_CLASS (klass)->size_allocate = store_app_grid_size_allocate;
+    GTK_CONTAINER_CLASS (klass)->forall = store_app_grid_forall;
+    GTK_CONTAINER_CLASS (klass)->remove = store_app_grid_remove;
 
     gtk_widget_class_set_template_from_resource (GTK_WIDGET_CLASS (klass), "/io/snapcraft/Store/store-app-grid.ui");
 
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_COLUMN_SPACING,
+                                     g_param_spec_int ("column-spacing", NULL, NULL, 0, G_MAXINT, 0, G_PARAM_READWRITE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_ROW_SPACING,
+                                     g_param_spec_int ("row-spacing", NULL, NULL, 0, G_MAXINT, 0, G_PARAM_READWRITE));
+
     signals[SIGNAL_APP_ACTIVATED] = g_signal_new ("app-activated",
                                                   G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
                                                   G_SIGNAL_RUN_LAST,
@@ -66,7 +464,12 @@ store_app_grid_class_init (StoreAppGridClass *klass)
 static void
 store_app_grid_init (StoreAppGrid *self)
 {
+    gtk_widget_set_has_window (GTK_WIDGET (self), FALSE);
     gtk_widget_init_template (GTK_WIDGET (self));
+
+    self->apps = g_ptr_array_new_with_free_func (g_object_unref);
+    self->spare_tiles = g_ptr_array_new ();
+    self->visible_tiles = g_ptr_array_new ();
 }
 
 StoreAppGrid *
@@ -80,32 +483,15 @@ store_app_grid_set_apps (StoreAppGrid *self, GPtrArray *apps)
 {
     g_return_if_fail (STORE_IS_APP_GRID (self));
 
-    /* Ensure correct number of app tiles */
-    // FIXME: Make a new widget that does this
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self));
-    guint n_tiles = g_list_length (children);
-    while (n_tiles < apps->len) {
-        StoreAppTile *tile = store_app_tile_new ();
-        gtk_widget_show (GTK_WIDGET (tile));
-        g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
-        store_app_tile_set_model (tile, self->model);
-        gtk_grid_attach (GTK_GRID (self), GTK_WIDGET (tile), n_tiles % 3, n_tiles / 3, 1, 1);
-        n_tiles++;
-    }
-    for (GList *link = children; link != NULL; link = link->next) {
-        GtkWidget *child = link->data;
-        int left_attach, top_attach;
-        gtk_container_child_get (GTK_CONTAINER (self), child, "left-attach", &left_attach, "top-attach", &top_attach, NULL);
-        guint index = top_attach * 3 + left_attach;
-        if (index >= apps->len)
-            gtk_container_remove (GTK_CONTAINER (self), child);
-    }
+    g_ptr_array_set_size (self->apps, 0);
+    for (guint i = 0; i < apps->len; i++)
+        g_ptr_array_add (self->apps, g_object_ref (g_ptr_array_index (apps, i)));
 
-    for (guint i = 0; i < apps->len; i++) {
-        StoreApp *app = g_ptr_array_index (apps, i);
-        StoreAppTile *tile = STORE_APP_TILE (gtk_grid_get_child_at (GTK_GRID (self), i % 3, i / 3));
-        store_app_tile_set_app (tile, app);
-    }
+    /* Measure the rows again */
+    self->row_height = 0;
+
+    update_tiles (self);
+    gtk_widget_queue_resize (GTK_WIDGET (self));
 }
 
 void
@@ -114,9 +500,8 @@ store_app_grid_set_model (StoreAppGrid *self, StoreModel *model)
     g_return_if_fail (STORE_IS_APP_GRID (self));
 
     g_set_object (&self->model, model);
-    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self));
-    for (GList *link = children; link != NULL; link = link->next) {
-        StoreAppTile *tile = link->data;
-        store_app_tile_set_model (tile, model);
-    }
+    for (guint i = 0; i < self->visible_tiles->len; i++)
+        store_app_tile_set_model (g_ptr_array_index (self->visible_tiles, i), model);
+    for (guint i = 0; i < self->spare_tiles->len; i++)
+        store_app_tile_set_model (g_ptr_array_index (self->spare_tiles, i), model);
 }
@@ -16,7 +16,7 @@
 
 G_BEGIN_DECLS
 
-G_DECLARE_FINAL_TYPE (StoreAppGrid, store_app_grid, STORE, APP_GRID, GtkGrid)
+G_DECLARE_FINAL_TYPE (StoreAppGrid, store_app_grid, STORE, APP_GRID, GtkContainer)
 
 StoreAppGrid *store_app_grid_new       (void);
 
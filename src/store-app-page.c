@@ -52,7 +52,10 @@ struct _StoreAppPage
     GtkButton *write_review_button;
 
     StoreApp *app;
-    GCancellable *cancellable;
+    GCancellable *details_cancellable;
+    StoreProgress *progress;
+    guint progress_tick_id;
+    GCancellable *reviews_cancellable;
 };
 
 enum
@@ -140,10 +143,16 @@ progress_to_install_label (GBinding *binding G_GNUC_UNUSED, const GValue *from_v
 }
 
 static gboolean
-progress_to_remove_label (GBinding *binding G_GNUC_UNUSED, const GValue *from_value, GValue *to_value, gpointer user_data G_GNUC_UNUSED)
+progress_to_remove_label (GBinding *binding G_GNUC_UNUSED, const GValue *from_value, GValue *to_value, gpointer user_data)
 {
+    StoreAppPage *self = user_data;
+
     StoreProgress *progress = g_value_get_object (from_value);
-    if (progress != NULL)
+    if (progress != NULL && store_app_get_state (self->app) == STORE_APP_STATE_UPDATING)
+        g_value_set_string (to_value,
+                            /* Label on remove button when the app is being updated */
+                            _("Updating…"));
+    else if (progress != NULL)
         g_value_set_string (to_value,
                             /* Label on remove button when removeing */
                             _("Removing…"));
@@ -162,16 +171,92 @@ progress_to_spinner_visible (GBinding *binding G_GNUC_UNUSED, const GValue *from
     return TRUE;
 }
 
+static gboolean
+progress_tick_cb (StoreAppPage *self, GdkFrameClock *frame_clock G_GNUC_UNUSED, gpointer user_data G_GNUC_UNUSED)
+{
+    self->progress_tick_id = 0;
+
+    if (self->progress == NULL)
+        return G_SOURCE_REMOVE;
+
+    if (store_app_get_state (self->app) == STORE_APP_STATE_QUEUED) {
+        g_autofree gchar *label = g_strdup_printf (/* Label on install/remove button when waiting for other operations to complete */
+                                                   _("Queued (%d)"), store_app_get_queue_position (self->app));
+        gtk_label_set_label (store_app_get_installed (self->app) ? self->remove_label : self->install_label, label);
+        return G_SOURCE_REMOVE;
+    }
+
+    gint percent = 0;
+    if (store_progress_get_total (self->progress) > 0)
+        percent = store_progress_get_done (self->progress) * 100 / store_progress_get_total (self->progress);
+    g_autofree gchar *label = NULL;
+    if (store_app_get_state (self->app) == STORE_APP_STATE_UPDATING)
+        label = g_strdup_printf (/* Label on remove button when updating, showing percentage complete */
+                                 _("Updating… %d%%"), percent);
+    else if (store_app_get_installed (self->app))
+        label = g_strdup_printf (/* Label on remove button when removing, showing percentage complete */
+                                 _("Removing… %d%%"), percent);
+    else
+        label = g_strdup_printf (/* Label on install button when installing, showing percentage complete */
+                                 _("Installing… %d%%"), percent);
+    gtk_label_set_label (store_app_get_installed (self->app) ? self->remove_label : self->install_label, label);
+
+    return G_SOURCE_REMOVE;
+}
+
 static void
-refresh_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+progress_changed_cb (StoreAppPage *self)
+{
+    /* snapd may report progress faster than we draw, so only update once per frame */
+    if (self->progress_tick_id == 0)
+        self->progress_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), (GtkTickCallback) progress_tick_cb, NULL, NULL);
+}
+
+static void
+set_progress (StoreAppPage *self, StoreProgress *progress)
+{
+    if (self->progress != NULL)
+        g_signal_handlers_disconnect_by_func (self->progress, progress_changed_cb, self);
+    g_set_object (&self->progress, progress);
+    if (self->progress != NULL)
+        g_signal_connect_object (self->progress, "notify", G_CALLBACK (progress_changed_cb), self, G_CONNECT_SWAPPED);
+}
+
+static void
+app_progress_changed_cb (StoreAppPage *self)
+{
+    set_progress (self, store_app_get_progress (self->app));
+}
+
+static void
+refresh_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GError) error = NULL;
-    if (!store_model_refresh_finish (STORE_MODEL (object), result, &error)) {
-        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            return;
+    gboolean refreshed = store_model_refresh_finish (STORE_MODEL (object), result, &error);
+    if (!refreshed && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+
+    /* Done, so leaving the page doesn't cause a reload */
+    StoreAppPage *self = user_data;
+    g_clear_object (&self->details_cancellable);
+
+    if (!refreshed)
         g_warning ("Failed to refresh app: %s", error->message);
+}
+
+static void
+reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GError) error = NULL;
+    gboolean updated = store_model_update_reviews_finish (STORE_MODEL (object), result, &error);
+    if (!updated && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
         return;
-    }
+
+    StoreAppPage *self = user_data;
+    g_clear_object (&self->reviews_cancellable);
+
+    if (!updated)
+        g_warning ("Failed to update reviews: %s", error->message);
 }
 
 static void
@@ -254,14 +339,40 @@ review_cb (StoreAppPage *self)
     gtk_dialog_run (GTK_DIALOG (dialog));
 }
 
+/* Cancelled if the page is left before they complete */
+static void
+load_details (StoreAppPage *self)
+{
+    g_cancellable_cancel (self->details_cancellable);
+    g_clear_object (&self->details_cancellable);
+    self->details_cancellable = store_page_new_cancellable (STORE_PAGE (self));
+    store_model_refresh_async (store_page_get_model (STORE_PAGE (self)), self->app, self->details_cancellable, refresh_cb, self);
+}
+
+static void
+load_reviews (StoreAppPage *self)
+{
+    g_cancellable_cancel (self->reviews_cancellable);
+    g_clear_object (&self->reviews_cancellable);
+    self->reviews_cancellable = store_page_new_cancellable (STORE_PAGE (self));
+    store_model_update_reviews_async (store_page_get_model (STORE_PAGE (self)), self->app, self->reviews_cancellable, reviews_cb, self); // FIXME: Update when appstream ID changes
+}
+
 static void
 store_app_page_dispose (GObject *object)
 {
     StoreAppPage *self = STORE_APP_PAGE (object);
 
     g_clear_object (&self->app);
-    g_cancellable_cancel (self->cancellable);
-    g_clear_object (&self->cancellable);
+    g_cancellable_cancel (self->details_cancellable);
+    g_clear_object (&self->details_cancellable);
+    g_cancellable_cancel (self->reviews_cancellable);
+    g_clear_object (&self->reviews_cancellable);
+    set_progress (self, NULL);
+    if (self->progress_tick_id != 0) {
+        gtk_widget_remove_tick_callback (GTK_WIDGET (self), self->progress_tick_id);
+        self->progress_tick_id = 0;
+    }
 
     G_OBJECT_CLASS (store_app_page_parent_class)->dispose (object);
 }
@@ -300,12 +411,29 @@ store_app_page_set_model (StorePage *page, StoreModel *model)
     STORE_PAGE_CLASS (store_app_page_parent_class)->set_model (page, model);
 }
 
+static void
+store_app_page_map (GtkWidget *widget)
+{
+    StoreAppPage *self = STORE_APP_PAGE (widget);
+
+    GTK_WIDGET_CLASS (store_app_page_parent_class)->map (widget);
+
+    /* Shown again after being left before the details or reviews were loaded */
+    if (self->app == NULL)
+        return;
+    if (self->details_cancellable != NULL && g_cancellable_is_cancelled (self->details_cancellable))
+        load_details (self);
+    if (self->reviews_cancellable != NULL && g_cancellable_is_cancelled (self->reviews_cancellable))
+        load_reviews (self);
+}
+
 static void
 store_app_page_class_init (StoreAppPageClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_app_page_dispose;
     G_OBJECT_CLASS (klass)->get_property = store_app_page_get_property;
     G_OBJECT_CLASS (klass)->set_property = store_app_page_set_property;
+    GTK_WIDGET_CLASS (klass)->map = store_app_page_map;
     STORE_PAGE_CLASS (klass)->set_model = store_app_page_set_model;
 
     g_object_class_install_property (G_OBJECT_CLASS (klass),
@@ -368,11 +496,18 @@ store_app_page_set_app (StoreAppPage *self, StoreApp *app)
     if (self->app == app)
         return;
 
+    if (self->app != NULL) {
+        g_signal_handlers_disconnect_by_func (self->app, app_progress_changed_cb, self);
+        g_signal_handlers_disconnect_by_func (self->app, progress_changed_cb, self);
+    }
     g_set_object (&self->app, app);
+    g_signal_connect_object (app, "notify::progress", G_CALLBACK (app_progress_changed_cb), self, G_CONNECT_SWAPPED);
+    g_signal_connect_object (app, "notify::queue-position", G_CALLBACK (progress_changed_cb), self, G_CONNECT_SWAPPED);
+    g_signal_connect_object (app, "notify::state", G_CALLBACK (progress_changed_cb), self, G_CONNECT_SWAPPED);
+    set_progress (self, store_app_get_progress (app));
 
-    g_cancellable_cancel (self->cancellable);
-    self->cancellable = g_cancellable_new ();
-    store_model_refresh_async (store_page_get_model (STORE_PAGE (self)), app, self->cancellable, refresh_cb, self);
+    load_details (self);
+    load_reviews (self);
 
     g_object_bind_property (app, "title", self->title_label, "label", G_BINDING_SYNC_CREATE);
     g_object_bind_property (app, "publisher", self->publisher_label, "label", G_BINDING_SYNC_CREATE);
@@ -414,7 +549,7 @@ store_app_page_set_app (StoreAppPage *self, StoreApp *app)
 
     g_object_bind_property (app, "installed", self->remove_button, "visible", G_BINDING_SYNC_CREATE);
     g_object_bind_property_full (app, "progress", self->remove_button, "sensitive", G_BINDING_SYNC_CREATE, progress_to_button_sensitive, NULL, NULL, NULL);
-    g_object_bind_property_full (app, "progress", self->remove_label, "label", G_BINDING_SYNC_CREATE, progress_to_remove_label, NULL, NULL, NULL);
+    g_object_bind_property_full (app, "progress", self->remove_label, "label", G_BINDING_SYNC_CREATE, progress_to_remove_label, NULL, self, NULL);
     g_object_bind_property_full (app, "progress", self->remove_spinner, "visible", G_BINDING_SYNC_CREATE, progress_to_spinner_visible, NULL, NULL, NULL);
 
     g_object_bind_property (app, "installed", self->install_button, "visible", G_BINDING_SYNC_CREATE | G_BINDING_INVERT_BOOLEAN);
@@ -424,8 +559,6 @@ store_app_page_set_app (StoreAppPage *self, StoreApp *app)
 
     gtk_widget_hide (GTK_WIDGET (self->reviews_box));
 
-    store_model_update_reviews_async (store_page_get_model (STORE_PAGE (self)), app, self->cancellable, NULL, NULL); // FIXME: Update when appstream ID changes
-
     store_screenshot_view_set_app (self->screenshot_view, app);
     GPtrArray *screenshots = store_app_get_screenshots (app);
     gtk_widget_set_visible (GTK_WIDGET (self->screenshot_view), screenshots->len > 0);
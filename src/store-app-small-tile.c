@@ -19,6 +19,9 @@ struct _StoreAppSmallTile
     GtkLabel *title_label;
 
     StoreApp *app;
+    GPtrArray *bindings;
+    StoreModel *model;
+    gboolean prefetch;
 };
 
 G_DEFINE_TYPE (StoreAppSmallTile, store_app_small_tile, GTK_TYPE_EVENT_BOX)
@@ -31,6 +34,20 @@ enum
 
 static guint signals[SIGNAL_LAST] = { 0 };
 
+static void
+start_prefetch (StoreAppSmallTile *self)
+{
+    if (self->model != NULL && self->app != NULL)
+        store_model_prefetch_app (self->model, self->app);
+}
+
+static void
+cancel_prefetch (StoreAppSmallTile *self)
+{
+    if (self->model != NULL && self->app != NULL)
+        store_model_cancel_prefetch_app (self->model, self->app);
+}
+
 static gboolean
 button_release_event_cb (StoreAppSmallTile *self)
 {
@@ -38,20 +55,52 @@ button_release_event_cb (StoreAppSmallTile *self)
     return TRUE;
 }
 
+static gboolean
+enter_notify_event_cb (StoreAppSmallTile *self)
+{
+    start_prefetch (self);
+    return FALSE;
+}
+
 static void
 store_app_small_tile_dispose (GObject *object)
 {
     StoreAppSmallTile *self = STORE_APP_SMALL_TILE (object);
 
     g_clear_object (&self->app);
+    g_clear_pointer (&self->bindings, g_ptr_array_unref);
+    g_clear_object (&self->model);
 
     G_OBJECT_CLASS (store_app_small_tile_parent_class)->dispose (object);
 }
 
+static void
+store_app_small_tile_map (GtkWidget *widget)
+{
+    StoreAppSmallTile *self = STORE_APP_SMALL_TILE (widget);
+
+    GTK_WIDGET_CLASS (store_app_small_tile_parent_class)->map (widget);
+
+    if (self->prefetch)
+        start_prefetch (self);
+}
+
+static void
+store_app_small_tile_unmap (GtkWidget *widget)
+{
+    StoreAppSmallTile *self = STORE_APP_SMALL_TILE (widget);
+
+    cancel_prefetch (self);
+
+    GTK_WIDGET_CLASS (store_app_small_tile_parent_class)->unmap (widget);
+}
+
 static void
 store_app_small_tile_class_init (StoreAppSmallTileClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_app_small_tile_dispose;
+    GTK_WIDGET_CLASS (klass)->map = store_app_small_tile_map;
+    GTK_WIDGET_CLASS (klass)->unmap = store_app_small_tile_unmap;
 
     gtk_widget_class_set_template_from_resource (GTK_WIDGET_CLASS (klass), "/io/snapcraft/Store/store-app-small-tile.ui");
 
@@ -59,6 +108,7 @@ store_app_small_tile_class_init (StoreAppSmallTileClass *klass)
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreAppSmallTile, title_label);
 
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), button_release_event_cb);
+    gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), enter_notify_event_cb);
 
     signals[SIGNAL_ACTIVATED] = g_signal_new ("activated",
                                               G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
@@ -75,6 +125,8 @@ store_app_small_tile_init (StoreAppSmallTile *self)
 {
     store_image_get_type ();
     gtk_widget_init_template (GTK_WIDGET (self));
+
+    self->bindings = g_ptr_array_new ();
 }
 
 StoreAppSmallTile *
@@ -91,12 +143,21 @@ store_app_small_tile_set_app (StoreAppSmallTile *self, StoreApp *app)
     if (self->app == app)
         return;
 
+    cancel_prefetch (self);
+
+    /* Tiles are reused for other apps */
+    for (guint i = 0; i < self->bindings->len; i++)
+        g_binding_unbind (g_ptr_array_index (self->bindings, i));
+    g_ptr_array_set_size (self->bindings, 0);
+
     g_clear_object (&self->app);
     if (app != NULL)
         self->app = g_object_ref (app);
+    if (self->prefetch && gtk_widget_get_mapped (GTK_WIDGET (self)))
+        start_prefetch (self);
 
-    g_object_bind_property (app, "icon", self->icon_image, "media", G_BINDING_SYNC_CREATE);
-    g_object_bind_property (app, "title", self->title_label, "label", G_BINDING_SYNC_CREATE);
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "icon", self->icon_image, "media", G_BINDING_SYNC_CREATE));
+    g_ptr_array_add (self->bindings, g_object_bind_property (app, "title", self->title_label, "label", G_BINDING_SYNC_CREATE));
 }
 
 StoreApp *
@@ -110,5 +171,25 @@ void
 store_app_small_tile_set_model (StoreAppSmallTile *self, StoreModel *model)
 {
     g_return_if_fail (STORE_IS_APP_SMALL_TILE (self));
+
+    cancel_prefetch (self);
+    g_set_object (&self->model, model);
     store_image_set_model (self->icon_image, model);
 }
+
+void
+store_app_small_tile_set_prefetch (StoreAppSmallTile *self, gboolean prefetch)
+{
+    g_return_if_fail (STORE_IS_APP_SMALL_TILE (self));
+
+    if (self->prefetch == prefetch)
+        return;
+
+    self->prefetch = prefetch;
+    if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+        return;
+    if (prefetch)
+        start_prefetch (self);
+    else
+        cancel_prefetch (self);
+}
@@ -18,12 +18,14 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (StoreAppSmallTile, store_app_small_tile, STORE, APP_SMALL_TILE, GtkEventBox)
 
-StoreAppSmallTile *store_app_small_tile_new       (void);
+StoreAppSmallTile *store_app_small_tile_new          (void);
 
-void               store_app_small_tile_set_app   (StoreAppSmallTile *tile, StoreApp *app);
+void               store_app_small_tile_set_app      (StoreAppSmallTile *tile, StoreApp *app);
 
-StoreApp          *store_app_small_tile_get_app   (StoreAppSmallTile *tile);
+StoreApp          *store_app_small_tile_get_app      (StoreAppSmallTile *tile);
 
-void               store_app_small_tile_set_model (StoreAppSmallTile *tile, StoreModel *model);
+void               store_app_small_tile_set_model    (StoreAppSmallTile *tile, StoreModel *model);
+
+void               store_app_small_tile_set_prefetch (StoreAppSmallTile *tile, gboolean prefetch);
 
 G_END_DECLS
@@ -18,12 +18,14 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (StoreAppTile, store_app_tile, STORE, APP_TILE, GtkEventBox)
 
-StoreAppTile *store_app_tile_new       (void);
+StoreAppTile *store_app_tile_new          (void);
 
-void          store_app_tile_set_model (StoreAppTile *tile, StoreModel *model);
+void          store_app_tile_set_model    (StoreAppTile *tile, StoreModel *model);
 
-void          store_app_tile_set_app   (StoreAppTile *tile, StoreApp *app);
+void          store_app_tile_set_app      (StoreAppTile *tile, StoreApp *app);
 
-StoreApp     *store_app_tile_get_app   (StoreAppTile *tile);
+StoreApp     *store_app_tile_get_app      (StoreAppTile *tile);
+
+void          store_app_tile_set_prefetch (StoreAppTile *tile, gboolean prefetch);
 
 G_END_DECLS
@@ -26,6 +26,7 @@ typedef struct
     StoreProgress *progress;
     gchar *publisher;
     gboolean publisher_validated;
+    gint queue_position;
     gint64 review_count_one_star;
     gint64 review_count_two_star;
     gint64 review_count_three_star;
@@ -34,6 +35,7 @@ typedef struct
     gchar *review_key;
     GPtrArray *reviews;
     GPtrArray *screenshots;
+    StoreAppState state;
     gchar *summary;
     gchar *title;
     GDateTime *updated_date;
@@ -55,6 +57,7 @@ enum
     PROP_PROGRESS,
     PROP_PUBLISHER,
     PROP_PUBLISHER_VALIDATED,
+    PROP_QUEUE_POSITION,
     PROP_REVIEW_AVERAGE,
     PROP_REVIEW_COUNT,
     PROP_REVIEW_COUNT_ONE_STAR,
@@ -65,6 +68,7 @@ enum
     PROP_REVIEWS,
     PROP_REVIEW_KEY,
     PROP_SCREENSHOTS,
+    PROP_STATE,
     PROP_SUMMARY,
     PROP_TITLE,
     PROP_UPDATED_DATE,
@@ -74,6 +78,79 @@ enum
 
 G_DEFINE_TYPE_WITH_PRIVATE (StoreApp, store_app, G_TYPE_OBJECT)
 
+GType
+store_app_state_get_type (void)
+{
+    static gsize type = 0;
+
+    if (g_once_init_enter (&type)) {
+        static const GEnumValue values[] = {
+            { STORE_APP_STATE_IDLE, "STORE_APP_STATE_IDLE", "idle" },
+            { STORE_APP_STATE_QUEUED, "STORE_APP_STATE_QUEUED", "queued" },
+            { STORE_APP_STATE_INSTALLING, "STORE_APP_STATE_INSTALLING", "installing" },
+            { STORE_APP_STATE_REMOVING, "STORE_APP_STATE_REMOVING", "removing" },
+            { STORE_APP_STATE_UPDATING, "STORE_APP_STATE_UPDATING", "updating" },
+            { 0, NULL, NULL }
+        };
+        g_once_init_leave (&type, g_enum_register_static ("StoreAppState", values));
+    }
+
+    return type;
+}
+
+static gboolean
+date_equal (GDateTime *a, GDateTime *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return g_date_time_equal (a, b);
+}
+
+static gboolean
+media_equal (StoreMedia *a, StoreMedia *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    return g_strcmp0 (store_media_get_uri (a), store_media_get_uri (b)) == 0 &&
+           store_media_get_width (a) == store_media_get_width (b) &&
+           store_media_get_height (a) == store_media_get_height (b);
+}
+
+static gboolean
+media_array_equal (GPtrArray *a, GPtrArray *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    if (a->len != b->len)
+        return FALSE;
+    for (guint i = 0; i < a->len; i++)
+        if (!media_equal (g_ptr_array_index (a, i), g_ptr_array_index (b, i)))
+            return FALSE;
+    return TRUE;
+}
+
+static gboolean
+channel_equal (StoreChannel *a, StoreChannel *b)
+{
+    return g_strcmp0 (store_channel_get_name (a), store_channel_get_name (b)) == 0 &&
+           g_strcmp0 (store_channel_get_version (a), store_channel_get_version (b)) == 0 &&
+           store_channel_get_size (a) == store_channel_get_size (b) &&
+           date_equal (store_channel_get_release_date (a), store_channel_get_release_date (b));
+}
+
+static gboolean
+channel_array_equal (GPtrArray *a, GPtrArray *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+    if (a->len != b->len)
+        return FALSE;
+    for (guint i = 0; i < a->len; i++)
+        if (!channel_equal (g_ptr_array_index (a, i), g_ptr_array_index (b, i)))
+            return FALSE;
+    return TRUE;
+}
+
 static void
 store_app_dispose (GObject *object)
 {
@@ -145,6 +222,9 @@ store_app_get_property (GObject *object, guint prop_id, GValue *value, GParamSpe
     case PROP_PUBLISHER_VALIDATED:
         g_value_set_boolean (value, priv->publisher_validated);
         break;
+    case PROP_QUEUE_POSITION:
+        g_value_set_int (value, priv->queue_position);
+        break;
     case PROP_REVIEWS:
         g_value_set_boxed (value, priv->reviews);
         break;
@@ -175,6 +255,9 @@ store_app_get_property (GObject *object, guint prop_id, GValue *value, GParamSpe
     case PROP_SCREENSHOTS:
         g_value_set_boxed (value, priv->screenshots);
         break;
+    case PROP_STATE:
+        g_value_set_enum (value, priv->state);
+        break;
     case PROP_SUMMARY:
         g_value_set_string (value, priv->summary);
         break;
@@ -236,6 +319,9 @@ store_app_set_property (GObject *object, guint prop_id, const GValue *value, GPa
     case PROP_PUBLISHER_VALIDATED:
         store_app_set_publisher_validated (self, g_value_get_boolean (value));
         break;
+    case PROP_QUEUE_POSITION:
+        store_app_set_queue_position (self, g_value_get_int (value));
+        break;
     case PROP_REVIEWS:
         store_app_set_reviews (self, g_value_get_boxed (value));
         break;
@@ -260,6 +346,9 @@ store_app_set_property (GObject *object, guint prop_id, const GValue *value, GPa
     case PROP_SCREENSHOTS:
         store_app_set_screenshots (self, g_value_get_boxed (value));
         break;
+    case PROP_STATE:
+        store_app_set_state (self, g_value_get_enum (value));
+        break;
     case PROP_SUMMARY:
         store_app_set_summary (self, g_value_get_string (value));
         break;
@@ -321,6 +410,9 @@ store_app_class_init (StoreAppClass *klass)
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_PUBLISHER_VALIDATED,
                                      g_param_spec_boolean ("publisher-validated", NULL, NULL, FALSE, G_PARAM_READWRITE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_QUEUE_POSITION,
+                                     g_param_spec_int ("queue-position", NULL, NULL, 0, G_MAXINT, 0, G_PARAM_READWRITE));
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_REVIEW_AVERAGE,
                                      g_param_spec_int ("review-average", NULL, NULL, G_MININT, G_MAXINT, 0, G_PARAM_READABLE));
@@ -351,6 +443,9 @@ store_app_class_init (StoreAppClass *klass)
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_SCREENSHOTS,
                                      g_param_spec_boxed ("screenshots", NULL, NULL, G_TYPE_PTR_ARRAY, G_PARAM_READWRITE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_STATE,
+                                     g_param_spec_enum ("state", NULL, NULL, store_app_state_get_type (), STORE_APP_STATE_IDLE, G_PARAM_READWRITE));
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_SUMMARY,
                                      g_param_spec_string ("summary", NULL, NULL, NULL, G_PARAM_READWRITE));
@@ -393,7 +488,26 @@ void
 store_app_update_from_cache (StoreApp *self, StoreCache *cache)
 {
     g_return_if_fail (STORE_IS_APP (self));
+    store_app_begin_update (self);
     STORE_APP_GET_CLASS (self)->update_from_cache (self, cache);
+    store_app_end_update (self);
+}
+
+void
+store_app_begin_update (StoreApp *self)
+{
+    g_return_if_fail (STORE_IS_APP (self));
+
+    /* Setters only notify on change, and while frozen each property is only notified once */
+    g_object_freeze_notify (G_OBJECT (self));
+}
+
+void
+store_app_end_update (StoreApp *self)
+{
+    g_return_if_fail (STORE_IS_APP (self));
+
+    g_object_thaw_notify (G_OBJECT (self));
 }
 
 void
@@ -403,6 +517,9 @@ store_app_set_appstream_id (StoreApp *self, const gchar *appstream_id)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->appstream_id, appstream_id) == 0)
+        return;
+
     g_clear_pointer (&priv->appstream_id, g_free);
     priv->appstream_id = g_strdup (appstream_id);
 }
@@ -424,6 +541,9 @@ store_app_set_banner (StoreApp *self, StoreMedia *banner)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (media_equal (priv->banner, banner))
+        return;
+
     g_clear_object (&priv->banner);
     if (banner != NULL)
         priv->banner = g_object_ref (banner);
@@ -448,6 +568,9 @@ store_app_set_channels (StoreApp *self, GPtrArray *channels)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (channel_array_equal (priv->channels, channels))
+        return;
+
     g_clear_pointer (&priv->channels, g_ptr_array_unref);
     if (channels != NULL)
         priv->channels = g_ptr_array_ref (channels);
@@ -472,6 +595,9 @@ store_app_set_contact (StoreApp *self, const gchar *contact)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->contact, contact) == 0)
+        return;
+
     g_clear_pointer (&priv->contact, g_free);
     priv->contact = g_strdup (contact);
 
@@ -495,6 +621,9 @@ store_app_set_description (StoreApp *self, const gchar *description)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->description, description) == 0)
+        return;
+
     g_clear_pointer (&priv->description, g_free);
     priv->description = g_strdup (description);
 
@@ -518,6 +647,9 @@ store_app_set_icon (StoreApp *self, StoreMedia *icon)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (media_equal (priv->icon, icon))
+        return;
+
     g_clear_object (&priv->icon);
     if (icon != NULL)
         priv->icon = g_object_ref (icon);
@@ -542,6 +674,9 @@ store_app_set_installed (StoreApp *self, gboolean installed)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->installed == installed)
+        return;
+
     priv->installed = installed;
 
     g_object_notify (G_OBJECT (self), "installed");
@@ -564,6 +699,9 @@ store_app_set_installed_size (StoreApp *self, gint64 size)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->installed_size == size)
+        return;
+
     priv->installed_size = size;
 
     g_object_notify (G_OBJECT (self), "installed-size");
@@ -586,6 +724,9 @@ store_app_set_license (StoreApp *self, const gchar *license)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->license, license) == 0)
+        return;
+
     g_clear_pointer (&priv->license, g_free);
     priv->license = g_strdup (license);
 
@@ -609,6 +750,9 @@ store_app_set_name (StoreApp *self, const gchar *name)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->name, name) == 0)
+        return;
+
     g_clear_pointer (&priv->name, g_free);
     priv->name = g_strdup (name);
 
@@ -653,6 +797,9 @@ store_app_set_publisher (StoreApp *self, const gchar *publisher)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->publisher, publisher) == 0)
+        return;
+
     g_clear_pointer (&priv->publisher, g_free);
     priv->publisher = g_strdup (publisher);
 
@@ -676,7 +823,12 @@ store_app_set_publisher_validated (StoreApp *self, gboolean validated)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->publisher_validated == validated)
+        return;
+
     priv->publisher_validated = validated;
+
+    g_object_notify (G_OBJECT (self), "publisher-validated");
 }
 
 gboolean
@@ -689,6 +841,31 @@ store_app_get_publisher_validated (StoreApp *self)
     return priv->publisher_validated;
 }
 
+void
+store_app_set_queue_position (StoreApp *self, gint position)
+{
+    StoreAppPrivate *priv = store_app_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_APP (self));
+
+    if (priv->queue_position == position)
+        return;
+
+    priv->queue_position = position;
+
+    g_object_notify (G_OBJECT (self), "queue-position");
+}
+
+gint
+store_app_get_queue_position (StoreApp *self)
+{
+    StoreAppPrivate *priv = store_app_get_instance_private (self);
+
+    g_return_val_if_fail (STORE_IS_APP (self), 0);
+
+    return priv->queue_position;
+}
+
 static gdouble
 pnormaldist (gdouble qn)
 {
@@ -766,6 +943,9 @@ store_app_set_review_count_one_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_one_star == count)
+        return;
+
     priv->review_count_one_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-one-star");
@@ -780,6 +960,9 @@ store_app_set_review_count_two_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_two_star == count)
+        return;
+
     priv->review_count_two_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-two-star");
@@ -794,6 +977,9 @@ store_app_set_review_count_three_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_three_star == count)
+        return;
+
     priv->review_count_three_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-three-star");
@@ -808,6 +994,9 @@ store_app_set_review_count_four_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_four_star == count)
+        return;
+
     priv->review_count_four_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-four-star");
@@ -822,6 +1011,9 @@ store_app_set_review_count_five_star (StoreApp *self, gint64 count)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->review_count_five_star == count)
+        return;
+
     priv->review_count_five_star = count;
 
     g_object_notify (G_OBJECT (self), "review-count-five-star");
@@ -829,6 +1021,20 @@ store_app_set_review_count_five_star (StoreApp *self, gint64 count)
     g_object_notify (G_OBJECT (self), "review-average");
 }
 
+void
+store_app_set_review_counts (StoreApp *self, const gint64 *counts)
+{
+    g_return_if_fail (STORE_IS_APP (self));
+
+    store_app_begin_update (self);
+    store_app_set_review_count_one_star (self, counts != NULL ? counts[0] : 0);
+    store_app_set_review_count_two_star (self, counts != NULL ? counts[1] : 0);
+    store_app_set_review_count_three_star (self, counts != NULL ? counts[2] : 0);
+    store_app_set_review_count_four_star (self, counts != NULL ? counts[3] : 0);
+    store_app_set_review_count_five_star (self, counts != NULL ? counts[4] : 0);
+    store_app_end_update (self);
+}
+
 void
 store_app_set_review_key (StoreApp *self, const gchar *key)
 {
@@ -836,6 +1042,9 @@ store_app_set_review_key (StoreApp *self, const gchar *key)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->review_key, key) == 0)
+        return;
+
     g_clear_pointer (&priv->review_key, g_free);
     priv->review_key = g_strdup (key);
 
@@ -859,6 +1068,9 @@ store_app_set_reviews (StoreApp *self, GPtrArray *reviews)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (priv->reviews == reviews)
+        return;
+
     g_clear_pointer (&priv->reviews, g_ptr_array_unref);
     if (reviews != NULL)
         priv->reviews = g_ptr_array_ref (reviews);
@@ -883,6 +1095,9 @@ store_app_set_screenshots (StoreApp *self, GPtrArray *screenshots)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (media_array_equal (priv->screenshots, screenshots))
+        return;
+
     g_clear_pointer (&priv->screenshots, g_ptr_array_unref);
     if (screenshots != NULL)
         priv->screenshots = g_ptr_array_ref (screenshots);
@@ -900,6 +1115,31 @@ store_app_get_screenshots (StoreApp *self)
     return priv->screenshots;
 }
 
+void
+store_app_set_state (StoreApp *self, StoreAppState state)
+{
+    StoreAppPrivate *priv = store_app_get_instance_private (self);
+
+    g_return_if_fail (STORE_IS_APP (self));
+
+    if (priv->state == state)
+        return;
+
+    priv->state = state;
+
+    g_object_notify (G_OBJECT (self), "state");
+}
+
+StoreAppState
+store_app_get_state (StoreApp *self)
+{
+    StoreAppPrivate *priv = store_app_get_instance_private (self);
+
+    g_return_val_if_fail (STORE_IS_APP (self), STORE_APP_STATE_IDLE);
+
+    return priv->state;
+}
+
 void
 store_app_set_summary (StoreApp *self, const gchar *summary)
 {
@@ -907,6 +1147,9 @@ store_app_set_summary (StoreApp *self, const gchar *summary)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->summary, summary) == 0)
+        return;
+
     g_clear_pointer (&priv->summary, g_free);
     priv->summary = g_strdup (summary);
 
@@ -930,6 +1173,9 @@ store_app_set_title (StoreApp *self, const gchar *title)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->title, title) == 0)
+        return;
+
     g_clear_pointer (&priv->title, g_free);
     priv->title = g_strdup (title);
 
@@ -953,6 +1199,9 @@ store_app_set_updated_date (StoreApp *self, GDateTime *date)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (date_equal (priv->updated_date, date))
+        return;
+
     g_clear_pointer (&priv->updated_date, g_date_time_unref);
     if (date != NULL)
         priv->updated_date = g_date_time_ref (date);
@@ -977,6 +1226,9 @@ store_app_set_version (StoreApp *self, const gchar *version)
 
     g_return_if_fail (STORE_IS_APP (self));
 
+    if (g_strcmp0 (priv->version, version) == 0)
+        return;
+
     g_clear_pointer (&priv->version, g_free);
     priv->version = g_strdup (version);
 
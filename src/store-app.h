@@ -18,6 +18,17 @@
 
 G_BEGIN_DECLS
 
+typedef enum
+{
+    STORE_APP_STATE_IDLE,
+    STORE_APP_STATE_QUEUED,
+    STORE_APP_STATE_INSTALLING,
+    STORE_APP_STATE_REMOVING,
+    STORE_APP_STATE_UPDATING
+} StoreAppState;
+
+GType          store_app_state_get_type (void);
+
 G_DECLARE_DERIVABLE_TYPE (StoreApp, store_app, STORE, APP, GObject)
 
 struct _StoreAppClass
@@ -35,6 +46,10 @@ void           store_app_save_to_cache               (StoreApp *app, StoreCache
 
 void           store_app_update_from_cache           (StoreApp *app, StoreCache *cache);
 
+void           store_app_begin_update                (StoreApp *app);
+
+void           store_app_end_update                  (StoreApp *app);
+
 void           store_app_set_appstream_id            (StoreApp *app, const gchar *appstream_id);
 
 const gchar   *store_app_get_appstream_id            (StoreApp *app);
@@ -87,6 +102,10 @@ void           store_app_set_publisher_validated     (StoreApp *app, gboolean va
 
 gboolean       store_app_get_publisher_validated     (StoreApp *app);
 
+void           store_app_set_queue_position          (StoreApp *app, gint position);
+
+gint           store_app_get_queue_position          (StoreApp *app);
+
 gint           store_app_get_review_average          (StoreApp *app);
 
 gint64         store_app_get_review_count            (StoreApp *app);
@@ -101,6 +120,8 @@ void           store_app_set_review_count_four_star  (StoreApp *app, const gint6
 
 void           store_app_set_review_count_five_star  (StoreApp *app, const gint64 count);
 
+void           store_app_set_review_counts           (StoreApp *app, const gint64 *counts);
+
 void           store_app_set_review_key              (StoreApp *app, const gchar *key);
 
 const gchar   *store_app_get_review_key              (StoreApp *app);
@@ -113,6 +134,10 @@ void           store_app_set_screenshots             (StoreApp *app, GPtrArray *
 
 GPtrArray     *store_app_get_screenshots             (StoreApp *app);
 
+void           store_app_set_state                   (StoreApp *app, StoreAppState state);
+
+StoreAppState  store_app_get_state                   (StoreApp *app);
+
 void           store_app_set_summary                 (StoreApp *app, const gchar *summary);
 
 const gchar   *store_app_get_summary                 (StoreApp *app);
@@ -14,6 +14,8 @@
 #include "store-application.h"
 #include "store-category.h"
 #include "store-model.h"
+#include "store-stats.h"
+#include "store-trace.h"
 #include "store-window.h"
 
 struct _StoreApplication
@@ -23,12 +25,98 @@ struct _StoreApplication
     StoreWindow *window;
 
     GCancellable *cancellable;
+    gboolean configured;
     GtkCssProvider *css_provider;
+    SoupCache *http_cache;
+    gboolean loaded;
     StoreModel *model;
+    gboolean prewarm_pages;
+    guint refresh_source;
+    guint search_provider_registration_id;
+    GHashTable *search_results;
+    gboolean service;
+    gboolean show_stats;
+    guint stats_registration_id;
 };
 
 G_DEFINE_TYPE (StoreApplication, store_application, GTK_TYPE_APPLICATION)
 
+#define HTTP_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+/* How often a resident instance refreshes the model, in seconds */
+#define SERVICE_REFRESH_INTERVAL (60 * 60)
+
+/* How long an instance started by D-Bus activation keeps running after its last request, in milliseconds */
+#define SERVICE_INACTIVITY_TIMEOUT (60 * 1000)
+
+/* --prefetch downloads images for this many snaps by default, with a few requests in flight at once */
+#define PREFETCH_DEFAULT_LIMIT 100
+#define PREFETCH_MAX_ACTIVE    4
+
+typedef struct
+{
+    StoreApplication *self;
+    GMainLoop *loop;
+    gint limit;
+    gboolean screenshots;
+    guint n_pending_steps;
+    GQueue *uris;
+    guint n_active;
+    guint n_images;
+    guint n_unchanged;
+    guint n_failed;
+    guint n_failed_steps;
+} PrefetchData;
+
+static void
+prefetch_data_free (PrefetchData *data)
+{
+    g_main_loop_unref (data->loop);
+    g_queue_free_full (data->uris, g_free);
+    g_free (data);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PrefetchData, prefetch_data_free)
+
+/* Cache and network counters, so they can be scraped from a running instance */
+static const gchar stats_introspection_xml[] =
+    "<node>"
+    "  <interface name='io.snapcraft.Store.Stats'>"
+    "    <method name='GetStats'>"
+    "      <arg type='a{sa{st}}' name='stats' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+/* Lets GNOME Shell search snaps without opening the window, answered from the cached snap metadata */
+static const gchar search_provider_introspection_xml[] =
+    "<node>"
+    "  <interface name='org.gnome.Shell.SearchProvider2'>"
+    "    <method name='GetInitialResultSet'>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='as' name='results' direction='out'/>"
+    "    </method>"
+    "    <method name='GetSubsearchResultSet'>"
+    "      <arg type='as' name='previous_results' direction='in'/>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='as' name='results' direction='out'/>"
+    "    </method>"
+    "    <method name='GetResultMetas'>"
+    "      <arg type='as' name='identifiers' direction='in'/>"
+    "      <arg type='aa{sv}' name='metas' direction='out'/>"
+    "    </method>"
+    "    <method name='ActivateResult'>"
+    "      <arg type='s' name='identifier' direction='in'/>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='u' name='timestamp' direction='in'/>"
+    "    </method>"
+    "    <method name='LaunchSearch'>"
+    "      <arg type='as' name='terms' direction='in'/>"
+    "      <arg type='u' name='timestamp' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
 static void
 store_application_dispose (GObject *object)
 {
@@ -36,8 +124,16 @@ store_application_dispose (GObject *object)
 
     g_cancellable_cancel (self->cancellable);
     g_clear_object (&self->cancellable);
+    g_clear_handle_id (&self->refresh_source, g_source_remove);
     g_clear_object (&self->css_provider);
+    if (self->http_cache != NULL) {
+        soup_cache_flush (self->http_cache);
+        soup_cache_dump (self->http_cache);
+    }
+    g_clear_object (&self->http_cache);
     g_clear_object (&self->model);
+    g_clear_pointer (&self->search_results, g_hash_table_unref);
+    store_trace_close ();
 
     G_OBJECT_CLASS (store_application_parent_class)->dispose (object);
 }
@@ -48,15 +144,405 @@ theme_changed_cb (StoreApplication *self)
     gtk_css_provider_load_from_resource (self->css_provider, "/io/snapcraft/Store/gtk-style.css");
 }
 
-static int
-store_application_command_line (GApplication *application, GApplicationCommandLine *command_line)
+static void
+enable_http_cache (StoreApplication *self)
 {
-    StoreApplication *self = STORE_APPLICATION (application);
+    if (self->http_cache != NULL)
+        return;
+
+    g_autofree gchar *cache_dir = g_build_filename (g_get_user_cache_dir (), "snap-store", "http", NULL);
+    self->http_cache = soup_cache_new (cache_dir, SOUP_CACHE_SINGLE_USER);
+    soup_cache_set_max_size (self->http_cache, HTTP_CACHE_MAX_SIZE);
+    soup_cache_load (self->http_cache);
+    soup_session_add_feature (store_model_get_soup_session (self->model), SOUP_SESSION_FEATURE (self->http_cache));
+}
 
-    GVariantDict *options = g_application_command_line_get_options_dict (command_line);
+static void
+load_model (StoreApplication *self)
+{
+    if (self->loaded)
+        return;
+    self->loaded = TRUE;
+
+    /* Only reads the cache, network updates start once the window is shown */
+    store_model_load (self->model);
+}
+
+static gboolean
+refresh_cb (StoreApplication *self)
+{
+    store_model_update_categories_async (self->model, self->cancellable, NULL, NULL);
+    store_model_update_ratings_async (self->model, self->cancellable, NULL, NULL);
+    store_model_update_installed_async (self->model, self->cancellable, NULL, NULL);
+    store_model_update_updates_async (self->model, self->cancellable, NULL, NULL);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/* Keep running with no windows so the model, ratings and images stay in memory between openings */
+static void
+start_service (StoreApplication *self)
+{
+    if (self->service)
+        return;
+    self->service = TRUE;
+
+    g_application_hold (G_APPLICATION (self));
+    refresh_cb (self);
+    self->refresh_source = g_timeout_add_seconds (SERVICE_REFRESH_INTERVAL, (GSourceFunc) refresh_cb, self);
+
+    if (self->window != NULL)
+        g_signal_connect (self->window, "delete-event", G_CALLBACK (gtk_widget_hide_on_delete), NULL);
+}
+
+static void
+window_destroy_cb (StoreApplication *self)
+{
+    self->window = NULL;
+}
+
+static void
+ensure_window (StoreApplication *self)
+{
+    if (self->window != NULL) {
+        /* snapd may have changed while hidden */
+        store_model_update_installed_async (self->model, self->cancellable, NULL, NULL);
+        return;
+    }
+
+    load_model (self);
+
+    self->window = store_window_new (self);
+    g_signal_connect_object (self->window, "destroy", G_CALLBACK (window_destroy_cb), self, G_CONNECT_SWAPPED);
+    /* Hide rather than destroy, so reopening is instant */
+    if (self->service)
+        g_signal_connect (self->window, "delete-event", G_CALLBACK (gtk_widget_hide_on_delete), NULL);
+    store_window_set_model (self->window, self->model);
+    store_window_set_prewarm_pages (self->window, self->prewarm_pages);
+    store_window_load (self->window);
+}
+
+static void
+prefetch_image_cb (GObject *object, GAsyncResult *result, gpointer user_data);
+
+static void
+prefetch_next (PrefetchData *data)
+{
+    StoreApplication *self = data->self;
+
+    while (data->n_active < PREFETCH_MAX_ACTIVE && !g_queue_is_empty (data->uris)) {
+        g_autofree gchar *uri = g_queue_pop_head (data->uris);
+
+        /* Images already in the cache only need revalidating */
+        g_autofree gchar *etag = NULL;
+        store_model_get_cached_image_metadata_sync (self->model, uri, &etag, NULL, NULL, NULL, NULL);
+
+        /* Only stored, nothing is shown so there's no need to decode */
+        data->n_active++;
+        store_model_download_image_async (self->model, uri, etag, STORE_IMAGE_PRIORITY_PREFETCH, self->cancellable, prefetch_image_cb, data);
+    }
+
+    if (data->n_pending_steps == 0 && data->n_active == 0)
+        g_main_loop_quit (data->loop);
+}
+
+static void
+prefetch_image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    PrefetchData *data = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (store_model_download_image_finish (STORE_MODEL (object), result, &error))
+        data->n_images++;
+    else if (g_error_matches (error, STORE_MODEL_ERROR, STORE_MODEL_ERROR_NOT_MODIFIED))
+        data->n_unchanged++;
+    else
+        data->n_failed++;
+
+    data->n_active--;
+    prefetch_next (data);
+}
+
+static void
+queue_media (PrefetchData *data, StoreMedia *media)
+{
+    if (media != NULL && store_media_get_uri (media) != NULL)
+        g_queue_push_tail (data->uris, g_strdup (store_media_get_uri (media)));
+}
+
+/* Take apps from each category in turn so every category gets its first apps cached */
+static void
+queue_category_images (PrefetchData *data)
+{
+    GPtrArray *categories = store_model_get_categories (data->self->model);
+    if (categories == NULL)
+        return;
+
+    g_autoptr(GHashTable) seen = g_hash_table_new (g_str_hash, g_str_equal);
+    gboolean more = TRUE;
+    for (guint i = 0; more; i++) {
+        more = FALSE;
+        for (guint j = 0; j < categories->len; j++) {
+            GPtrArray *apps = store_category_get_apps (g_ptr_array_index (categories, j));
+            if (apps == NULL || i >= apps->len)
+                continue;
+            more = TRUE;
+
+            StoreApp *app = g_ptr_array_index (apps, i);
+            if (!g_hash_table_add (seen, (gpointer) store_app_get_name (app)))
+                continue;
+            if (g_hash_table_size (seen) > (guint) data->limit)
+                return;
+
+            queue_media (data, store_app_get_icon (app));
+            if (data->screenshots) {
+                GPtrArray *screenshots = store_app_get_screenshots (app);
+                for (guint k = 0; screenshots != NULL && k < screenshots->len; k++)
+                    queue_media (data, g_ptr_array_index (screenshots, k));
+            }
+        }
+    }
+}
+
+static void
+prefetch_categories_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    PrefetchData *data = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_model_update_categories_finish (STORE_MODEL (object), result, &error)) {
+        g_warning ("Failed to get categories: %s", error->message);
+        data->n_failed_steps++;
+    }
+    else
+        queue_category_images (data);
+
+    data->n_pending_steps--;
+    prefetch_next (data);
+}
+
+static void
+prefetch_ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    PrefetchData *data = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_model_update_ratings_finish (STORE_MODEL (object), result, &error)) {
+        g_warning ("Failed to get ratings: %s", error->message);
+        data->n_failed_steps++;
+    }
+
+    data->n_pending_steps--;
+    prefetch_next (data);
+}
+
+static void
+print_stats (StoreApplication *self)
+{
+    g_autoptr(GVariant) stats = store_model_get_stats (self->model);
+    g_autofree gchar *text = store_stats_to_string (stats);
+    g_print ("%s", text);
+}
+
+/* Fill the cache without showing a window, so the first launch on a new machine is warm.
+ * Runs its own main loop before GTK is initialized, so it works without a display */
+static gint
+run_prefetch (StoreApplication *self, gint limit, gboolean screenshots)
+{
+    g_autoptr(PrefetchData) data = g_new0 (PrefetchData, 1);
+    data->self = self;
+    data->loop = g_main_loop_new (NULL, FALSE);
+    data->limit = limit;
+    data->screenshots = screenshots;
+    data->uris = g_queue_new ();
+    gint64 start = g_get_monotonic_time ();
+
+    load_model (self);
+
+    /* Sections and their contents are written to the cache as they arrive */
+    data->n_pending_steps = 2;
+    store_model_update_categories_async (self->model, self->cancellable, prefetch_categories_cb, data);
+    store_model_update_ratings_async (self->model, self->cancellable, prefetch_ratings_cb, data);
+    g_main_loop_run (data->loop);
+
+    g_print ("Prefetched %u images (%u already up to date, %u failed) in %.1f seconds\n",
+             data->n_images, data->n_unchanged, data->n_failed, (g_get_monotonic_time () - start) / (gdouble) G_USEC_PER_SEC);
+    if (self->show_stats)
+        print_stats (self);
+
+    /* Fail if anything didn't make it into the cache, so provisioning scripts can retry */
+    return data->n_failed == 0 && data->n_failed_steps == 0 ? 0 : 1;
+}
+
+/* Restarts the inactivity timeout of a D-Bus activated instance */
+static void
+mark_busy (StoreApplication *self)
+{
+    g_application_hold (G_APPLICATION (self));
+    g_application_release (G_APPLICATION (self));
+}
+
+static void
+stats_method_call_cb (GDBusConnection *connection G_GNUC_UNUSED, const gchar *sender G_GNUC_UNUSED,
+                      const gchar *object_path G_GNUC_UNUSED, const gchar *interface_name G_GNUC_UNUSED,
+                      const gchar *method_name, GVariant *parameters G_GNUC_UNUSED,
+                      GDBusMethodInvocation *invocation, gpointer user_data)
+{
+    StoreApplication *self = user_data;
+
+    mark_busy (self);
+
+    if (g_strcmp0 (method_name, "GetStats") == 0) {
+        GVariant *stats = store_model_get_stats (self->model);
+        g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&stats, 1));
+    }
+    else
+        g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown method %s", method_name);
+}
+
+static const GDBusInterfaceVTable stats_vtable = { stats_method_call_cb, NULL, NULL };
+
+static void
+search_cached_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    GDBusMethodInvocation *invocation = user_data;
+    StoreApplication *self = g_dbus_method_invocation_get_user_data (invocation);
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) apps = store_model_search_cached_finish (STORE_MODEL (object), result, &error);
+    if (apps == NULL) {
+        g_dbus_method_invocation_return_gerror (invocation, error);
+        g_application_release (G_APPLICATION (self));
+        return;
+    }
+
+    /* Keep the results so GetResultMetas doesn't have to read the cache again */
+    g_hash_table_remove_all (self->search_results);
+    GVariantBuilder builder;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+    for (guint i = 0; i < apps->len; i++) {
+        StoreApp *app = g_ptr_array_index (apps, i);
+        g_hash_table_insert (self->search_results, g_strdup (store_app_get_name (app)), g_object_ref (app));
+        g_variant_builder_add (&builder, "s", store_app_get_name (app));
+    }
+    g_dbus_method_invocation_return_value (invocation, g_variant_new ("(as)", &builder));
+
+    g_application_release (G_APPLICATION (self));
+}
+
+static void
+get_result_set (StoreApplication *self, GStrv terms, GDBusMethodInvocation *invocation)
+{
+    /* Held until answered, so an activated instance doesn't time out while searching.
+     * The invocation is returned (and so freed) in search_cached_cb */
+    g_application_hold (G_APPLICATION (self));
+    store_model_search_cached_async (self->model, terms, self->cancellable, search_cached_cb, invocation);
+}
+
+static GVariant *
+get_result_metas (StoreApplication *self, GStrv names)
+{
+    GVariantBuilder builder;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
+    for (int i = 0; names[i] != NULL; i++) {
+        g_autoptr(StoreApp) app = g_hash_table_lookup (self->search_results, names[i]);
+        if (app != NULL)
+            g_object_ref (app);
+        else
+            app = STORE_APP (store_model_get_snap (self->model, names[i]));
+
+        GVariantBuilder meta;
+        g_variant_builder_init (&meta, G_VARIANT_TYPE ("a{sv}"));
+        g_variant_builder_add (&meta, "{sv}", "id", g_variant_new_string (names[i]));
+        const gchar *title = store_app_get_title (app);
+        g_variant_builder_add (&meta, "{sv}", "name", g_variant_new_string (title != NULL ? title : names[i]));
+        if (store_app_get_summary (app) != NULL)
+            g_variant_builder_add (&meta, "{sv}", "description", g_variant_new_string (store_app_get_summary (app)));
+        StoreMedia *icon = store_app_get_icon (app);
+        g_autoptr(GFile) icon_file = icon != NULL ? store_model_get_cached_image_file (self->model, store_media_get_uri (icon)) : NULL;
+        if (icon_file != NULL) {
+            g_autoptr(GIcon) gicon = g_file_icon_new (icon_file);
+            g_autoptr(GVariant) serialized_icon = g_icon_serialize (gicon);
+            if (serialized_icon != NULL)
+                g_variant_builder_add (&meta, "{sv}", "icon", serialized_icon);
+        }
+        g_variant_builder_add (&builder, "a{sv}", &meta);
+    }
+
+    return g_variant_new ("(aa{sv})", &builder);
+}
+
+static void
+search_provider_method_call_cb (GDBusConnection *connection G_GNUC_UNUSED, const gchar *sender G_GNUC_UNUSED,
+                                const gchar *object_path G_GNUC_UNUSED, const gchar *interface_name G_GNUC_UNUSED,
+                                const gchar *method_name, GVariant *parameters,
+                                GDBusMethodInvocation *invocation, gpointer user_data)
+{
+    StoreApplication *self = user_data;
+
+    mark_busy (self);
+
+    if (g_strcmp0 (method_name, "GetInitialResultSet") == 0) {
+        g_autofree const gchar **terms = NULL;
+        g_variant_get (parameters, "(^a&s)", &terms);
+        get_result_set (self, (GStrv) terms, invocation);
+    }
+    else if (g_strcmp0 (method_name, "GetSubsearchResultSet") == 0) {
+        /* Searching the index is cheap enough to not need to filter the previous results */
+        g_autofree const gchar **terms = NULL;
+        g_variant_get (parameters, "(as^a&s)", NULL, &terms);
+        get_result_set (self, (GStrv) terms, invocation);
+    }
+    else if (g_strcmp0 (method_name, "GetResultMetas") == 0) {
+        g_autofree const gchar **names = NULL;
+        g_variant_get (parameters, "(^a&s)", &names);
+        g_dbus_method_invocation_return_value (invocation, get_result_metas (self, (GStrv) names));
+    }
+    else if (g_strcmp0 (method_name, "ActivateResult") == 0) {
+        const gchar *name;
+        guint32 timestamp;
+        g_variant_get (parameters, "(&sasu)", &name, NULL, &timestamp);
+        ensure_window (self);
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (self->model, name);
+        store_window_show_app (self->window, STORE_APP (app));
+        gtk_window_present_with_time (GTK_WINDOW (self->window), timestamp);
+        g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+    else if (g_strcmp0 (method_name, "LaunchSearch") == 0) {
+        g_autofree const gchar **terms = NULL;
+        guint32 timestamp;
+        g_variant_get (parameters, "(^a&su)", &terms, &timestamp);
+        ensure_window (self);
+        g_autofree gchar *query = g_strjoinv (" ", (GStrv) terms);
+        store_window_search (self->window, query);
+        gtk_window_present_with_time (GTK_WINDOW (self->window), timestamp);
+        g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+    else
+        g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD, "Unknown method %s", method_name);
+}
+
+static const GDBusInterfaceVTable search_provider_vtable = { search_provider_method_call_cb, NULL, NULL };
+
+/* Where the model gets its data from can only be set when it is first used, a resident instance keeps its own */
+static void
+configure_model (StoreApplication *self, GVariantDict *options)
+{
+    gboolean changes_model = g_variant_dict_contains (options, "no-cache") ||
+                             g_variant_dict_contains (options, "http-cache") ||
+                             g_variant_dict_contains (options, "odrs-server") ||
+                             g_variant_dict_contains (options, "snapd-socket-path");
+    if (self->configured) {
+        if (changes_model)
+            g_warning ("Already running, ignoring --no-cache, --http-cache, --odrs-server and --snapd-socket-path");
+        return;
+    }
+    self->configured = TRUE;
 
     if (g_variant_dict_contains (options, "no-cache"))
         store_model_set_cache (self->model, NULL);
+    else if (g_variant_dict_contains (options, "http-cache"))
+        enable_http_cache (self);
 
     if (g_variant_dict_contains (options, "odrs-server")) {
         const gchar *uri;
@@ -69,18 +555,75 @@ store_application_command_line (GApplication *application, GApplicationCommandLi
         g_variant_dict_lookup (options, "snapd-socket-path", "&s", &path);
         store_model_set_snapd_socket_path (self->model, path);
     }
+}
+
+static void
+apply_options (StoreApplication *self, GVariantDict *options)
+{
+    configure_model (self, options);
+
+    if (g_variant_dict_contains (options, "media-policy")) {
+        const gchar *name;
+        g_variant_dict_lookup (options, "media-policy", "&s", &name);
+        g_autoptr(GEnumClass) policy_class = g_type_class_ref (store_media_policy_get_type ());
+        GEnumValue *policy = g_enum_get_value_by_nick (policy_class, name);
+        if (policy != NULL)
+            store_model_set_media_policy (self->model, policy->value);
+        else
+            g_warning ("Unknown media policy %s", name);
+    }
+
+    if (g_variant_dict_contains (options, "trace")) {
+        const gchar *path;
+        g_variant_dict_lookup (options, "trace", "^&ay", &path);
+        g_autoptr(GError) error = NULL;
+        if (!store_trace_open (path, &error))
+            g_warning ("Failed to enable tracing: %s", error->message);
+    }
+
+    if (g_variant_dict_contains (options, "stats"))
+        self->show_stats = TRUE;
+
+    if (g_variant_dict_contains (options, "prewarm-pages"))
+        self->prewarm_pages = TRUE;
+}
+
+static gint
+store_application_handle_local_options (GApplication *application, GVariantDict *options)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    /* Handled in this process, without registering or starting GTK */
+    if (g_variant_dict_contains (options, "prefetch")) {
+        apply_options (self, options);
+        gint limit = PREFETCH_DEFAULT_LIMIT;
+        g_variant_dict_lookup (options, "prefetch-limit", "i", &limit);
+        return run_prefetch (self, limit, g_variant_dict_contains (options, "prefetch-screenshots"));
+    }
+
+    return G_APPLICATION_CLASS (store_application_parent_class)->handle_local_options (application, options);
+}
+
+static int
+store_application_command_line (GApplication *application, GApplicationCommandLine *command_line)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    GVariantDict *options = g_application_command_line_get_options_dict (command_line);
+    apply_options (self, options);
 
     if (g_variant_dict_contains (options, "version")) {
         g_print ("snap-store " VERSION "\n");
         return 0;
     }
 
-    store_model_load (self->model);
-    store_model_update_ratings_async (self->model, NULL, NULL, NULL);
+    if (g_variant_dict_contains (options, "service")) {
+        load_model (self);
+        start_service (self);
+        return 0;
+    }
 
-    self->window = store_window_new (self);
-    store_window_set_model (self->window, self->model);
-    store_window_load (self->window);
+    ensure_window (self);
 
     int args_length;
     g_auto(GStrv) args = g_application_command_line_get_arguments (command_line, &args_length);
@@ -119,16 +662,73 @@ store_application_startup (GApplication *application)
 
     G_APPLICATION_CLASS (store_application_parent_class)->startup (application);
 
+    /* Started by D-Bus activation (e.g. for a search), so exit once requests stop. Only --service stays running */
+    if (g_application_get_flags (application) & G_APPLICATION_IS_SERVICE)
+        g_application_set_inactivity_timeout (application, SERVICE_INACTIVITY_TIMEOUT);
+
     self->css_provider = gtk_css_provider_new ();
     gtk_style_context_add_provider_for_screen (gdk_screen_get_default (), GTK_STYLE_PROVIDER (self->css_provider), GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
     g_signal_connect_object (gtk_settings_get_default (), "notify::gtk-theme-name", G_CALLBACK (theme_changed_cb), self, G_CONNECT_SWAPPED);
     theme_changed_cb (self);
 }
 
+static void
+store_application_shutdown (GApplication *application)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    if (self->show_stats)
+        print_stats (self);
+
+    G_APPLICATION_CLASS (store_application_parent_class)->shutdown (application);
+}
+
+static gboolean
+store_application_dbus_register (GApplication *application, GDBusConnection *connection, const gchar *object_path, GError **error)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    if (!G_APPLICATION_CLASS (store_application_parent_class)->dbus_register (application, connection, object_path, error))
+        return FALSE;
+
+    g_autoptr(GDBusNodeInfo) info = g_dbus_node_info_new_for_xml (stats_introspection_xml, error);
+    if (info == NULL)
+        return FALSE;
+    self->stats_registration_id = g_dbus_connection_register_object (connection, object_path, info->interfaces[0], &stats_vtable, self, NULL, error);
+    if (self->stats_registration_id == 0)
+        return FALSE;
+
+    g_autoptr(GDBusNodeInfo) search_provider_info = g_dbus_node_info_new_for_xml (search_provider_introspection_xml, error);
+    if (search_provider_info == NULL)
+        return FALSE;
+    g_autofree gchar *search_provider_path = g_strconcat (object_path, "/SearchProvider", NULL);
+    self->search_provider_registration_id = g_dbus_connection_register_object (connection, search_provider_path, search_provider_info->interfaces[0], &search_provider_vtable, self, NULL, error);
+
+    return self->search_provider_registration_id != 0;
+}
+
+static void
+store_application_dbus_unregister (GApplication *application, GDBusConnection *connection, const gchar *object_path)
+{
+    StoreApplication *self = STORE_APPLICATION (application);
+
+    if (self->stats_registration_id != 0) {
+        g_dbus_connection_unregister_object (connection, self->stats_registration_id);
+        self->stats_registration_id = 0;
+    }
+    if (self->search_provider_registration_id != 0) {
+        g_dbus_connection_unregister_object (connection, self->search_provider_registration_id);
+        self->search_provider_registration_id = 0;
+    }
+
+    G_APPLICATION_CLASS (store_application_parent_class)->dbus_unregister (application, connection, object_path);
+}
+
 static void
 store_application_activate (GApplication *application)
 {
     StoreApplication *self = STORE_APPLICATION (application);
+    ensure_window (self);
     gtk_window_present (GTK_WINDOW (self->window));
 }
 
@@ -136,8 +736,12 @@ static void
 store_application_class_init (StoreApplicationClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_application_dispose;
+    G_APPLICATION_CLASS (klass)->handle_local_options = store_application_handle_local_options;
     G_APPLICATION_CLASS (klass)->command_line = store_application_command_line;
     G_APPLICATION_CLASS (klass)->startup = store_application_startup;
+    G_APPLICATION_CLASS (klass)->shutdown = store_application_shutdown;
+    G_APPLICATION_CLASS (klass)->dbus_register = store_application_dbus_register;
+    G_APPLICATION_CLASS (klass)->dbus_unregister = store_application_dbus_unregister;
     G_APPLICATION_CLASS (klass)->activate = store_application_activate;
 }
 
@@ -151,6 +755,9 @@ store_application_init (StoreApplication *self)
         { "no-cache", 0, 0, G_OPTION_ARG_NONE, NULL,
            /* Help text for --no-cache command line option */
            _("Disable caching"), NULL },
+        { "http-cache", 0, 0, G_OPTION_ARG_NONE, NULL,
+           /* Help text for --http-cache command line option */
+           _("Cache HTTP responses on disk"), NULL },
         { "odrs-server", 0, 0, G_OPTION_ARG_STRING, NULL,
            /* Help text for --odrs-server command line option */
            _("ODRS server URI"),
@@ -161,13 +768,52 @@ store_application_init (StoreApplication *self)
            _("Socket snapd server is using"),
            /* Help text for argument to --snapd-socket-path command line option */
            _("PATH") },
+        { "media-policy", 0, 0, G_OPTION_ARG_STRING, NULL,
+           /* Help text for --media-policy command line option */
+           _("Which images to download: automatic, full, defer-screenshots or icons-only"),
+           /* Help text for argument to --media-policy command line option */
+           _("POLICY") },
+        { "trace", 0, 0, G_OPTION_ARG_FILENAME, NULL,
+           /* Help text for --trace command line option */
+           _("Write timings of model, cache and network operations to a file"),
+           /* Help text for argument to --trace command line option */
+           _("FILE") },
+        { "stats", 0, 0, G_OPTION_ARG_NONE, NULL,
+           /* Help text for --stats command line option */
+           _("Show cache and network statistics on exit"), NULL },
+        { "prewarm-pages", 0, 0, G_OPTION_ARG_NONE, NULL,
+           /* Help text for --prewarm-pages command line option */
+           _("Build all pages in the background after startup"), NULL },
+        { "service", 0, 0, G_OPTION_ARG_NONE, NULL,
+           /* Help text for --service command line option */
+           _("Stay running in the background and keep the store up to date"), NULL },
+        { "prefetch", 0, 0, G_OPTION_ARG_NONE, NULL,
+           /* Help text for --prefetch command line option */
+           _("Fill the cache with categories, ratings and icons, then exit"), NULL },
+        { "prefetch-limit", 0, 0, G_OPTION_ARG_INT, NULL,
+           /* Help text for --prefetch-limit command line option */
+           _("Number of snaps to fetch images for"),
+           /* Help text for argument to --prefetch-limit command line option */
+           _("COUNT") },
+        { "prefetch-screenshots", 0, 0, G_OPTION_ARG_NONE, NULL,
+           /* Help text for --prefetch-screenshots command line option */
+           _("Also fetch screenshots when prefetching"), NULL },
         { NULL }
     };
 
     g_application_add_main_option_entries (G_APPLICATION (self), options);
 
+    /* Trace from the start so startup can be profiled, --trace overrides this */
+    const gchar *trace_path = g_getenv ("SNAP_STORE_TRACE");
+    if (trace_path != NULL) {
+        g_autoptr(GError) error = NULL;
+        if (!store_trace_open (trace_path, &error))
+            g_warning ("Failed to enable tracing: %s", error->message);
+    }
+
     self->cancellable = g_cancellable_new ();
     self->model = store_model_new ();
+    self->search_results = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
     g_autoptr(StoreCache) cache = store_cache_new ();
     store_model_set_cache (self->model, cache);
 }
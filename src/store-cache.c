@@ -8,14 +8,49 @@
  */
 
 #include "store-cache.h"
+#include "store-stats.h"
+#include "store-trace.h"
 
 struct _StoreCache
 {
     GObject parent_instance;
+
+    GHashTable *stats;
 };
 
 G_DEFINE_TYPE (StoreCache, store_cache, G_TYPE_OBJECT)
 
+typedef struct
+{
+    StoreStats *stats;
+    gint64 start;
+} LookupData;
+
+static StoreStats *
+get_stats (StoreCache *self, const gchar *type)
+{
+    StoreStats *stats = g_hash_table_lookup (self->stats, type);
+    if (stats == NULL) {
+        stats = g_new0 (StoreStats, 1);
+        g_hash_table_insert (self->stats, g_strdup (type), stats);
+    }
+    return stats;
+}
+
+static void
+add_lookup_stats (StoreStats *stats, gint64 start, GBytes *data, GError *error)
+{
+    store_stats_add_latency (stats, start);
+    if (data != NULL) {
+        stats->hits++;
+        stats->bytes_read += g_bytes_get_size (data);
+    }
+    else if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+        stats->misses++;
+    else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        stats->errors++;
+}
+
 static GFile *
 get_cache_file (const gchar *type, const gchar *name, gboolean hash)
 {
@@ -33,26 +68,42 @@ static void
 contents_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
+    LookupData *data = g_task_get_task_data (task);
 
     g_autoptr(GError) error = NULL;
     g_autofree gchar *contents = NULL;
     gsize contents_length;
     if (!g_file_load_contents_finish (G_FILE (object), result, &contents, &contents_length, NULL, &error)) {
+        add_lookup_stats (data->stats, data->start, NULL, error);
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
 
-    g_task_return_pointer (task, g_bytes_new_take (g_steal_pointer (&contents), contents_length), (GDestroyNotify) g_bytes_unref);
+    g_autoptr(GBytes) bytes = g_bytes_new_take (g_steal_pointer (&contents), contents_length);
+    add_lookup_stats (data->stats, data->start, bytes, NULL);
+    g_task_return_pointer (task, g_steal_pointer (&bytes), (GDestroyNotify) g_bytes_unref);
 }
 
 static void
-store_cache_class_init (StoreCacheClass *klass G_GNUC_UNUSED)
+store_cache_dispose (GObject *object)
 {
+    StoreCache *self = STORE_CACHE (object);
+
+    g_clear_pointer (&self->stats, g_hash_table_unref);
+
+    G_OBJECT_CLASS (store_cache_parent_class)->dispose (object);
 }
 
 static void
-store_cache_init (StoreCache *self G_GNUC_UNUSED)
+store_cache_class_init (StoreCacheClass *klass)
 {
+    G_OBJECT_CLASS (klass)->dispose = store_cache_dispose;
+}
+
+static void
+store_cache_init (StoreCache *self)
+{
+    self->stats = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 }
 
 StoreCache *
@@ -66,6 +117,8 @@ store_cache_insert (StoreCache *self, const gchar *type, const gchar *name, gboo
 {
     g_return_val_if_fail (STORE_IS_CACHE (self), FALSE);
 
+    gint64 trace_start = store_trace_begin ();
+
     g_autoptr(GFile) file = get_cache_file (type, name, hash);
 
     g_autofree gchar *path = g_file_get_path (file);
@@ -74,7 +127,24 @@ store_cache_insert (StoreCache *self, const gchar *type, const gchar *name, gboo
 
     gsize contents_length;
     const gchar *contents = g_bytes_get_data (data, &contents_length);
-    return g_file_replace_contents (file, contents, contents_length, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, cancellable, error);
+    g_autoptr(GError) local_error = NULL;
+    gboolean result = g_file_replace_contents (file, contents, contents_length, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, cancellable, &local_error);
+
+    /* Cancelled writes aren't a problem with the cache */
+    StoreStats *stats = get_stats (self, type);
+    if (result) {
+        stats->writes++;
+        stats->bytes_written += contents_length;
+    }
+    else if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        stats->errors++;
+
+    if (local_error != NULL)
+        g_propagate_error (error, g_steal_pointer (&local_error));
+
+    store_trace_end (trace_start, "cache", "insert", name);
+
+    return result;
 }
 
 gboolean
@@ -99,6 +169,11 @@ store_cache_lookup_async (StoreCache *self, const gchar *type, const gchar *name
     g_autoptr(GFile) file = get_cache_file (type, name, hash);
 
     GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "cache", "lookup", name);
+    LookupData *data = g_new0 (LookupData, 1);
+    data->stats = get_stats (self, type);
+    data->start = g_get_monotonic_time ();
+    g_task_set_task_data (task, data, g_free);
     g_file_load_contents_async (file, cancellable, contents_cb, task);
 }
 
@@ -116,14 +191,28 @@ store_cache_lookup_sync (StoreCache *self, const gchar *type, const gchar *name,
 {
     g_return_val_if_fail (STORE_IS_CACHE (self), NULL);
 
+    gint64 trace_start = store_trace_begin ();
+
+    gint64 start = g_get_monotonic_time ();
+
     g_autoptr(GFile) file = get_cache_file (type, name, hash);
 
     g_autofree gchar *contents = NULL;
     gsize contents_length;
-    if (!g_file_load_contents (file, cancellable, &contents, &contents_length, NULL, error))
+    g_autoptr(GError) local_error = NULL;
+    gboolean result = g_file_load_contents (file, cancellable, &contents, &contents_length, NULL, &local_error);
+
+    store_trace_end (trace_start, "cache", "lookup", name);
+
+    if (!result) {
+        add_lookup_stats (get_stats (self, type), start, NULL, local_error);
+        g_propagate_error (error, g_steal_pointer (&local_error));
         return NULL;
+    }
 
-    return g_bytes_new_take (g_steal_pointer (&contents), contents_length);
+    GBytes *data = g_bytes_new_take (g_steal_pointer (&contents), contents_length);
+    add_lookup_stats (get_stats (self, type), start, data, NULL);
+    return data;
 }
 
 JsonNode *
@@ -147,3 +236,65 @@ store_cache_lookup_json (StoreCache *self, const gchar *type, const gchar *name,
 
     return json_node_ref (root);
 }
+
+GFile *
+store_cache_get_file (StoreCache *self, const gchar *type, const gchar *name, gboolean hash)
+{
+    g_return_val_if_fail (STORE_IS_CACHE (self), NULL);
+
+    g_autoptr(GFile) file = get_cache_file (type, name, hash);
+    if (!g_file_query_exists (file, NULL))
+        return NULL;
+
+    return g_steal_pointer (&file);
+}
+
+GStrv
+store_cache_list_sync (StoreCache *self, const gchar *type, GCancellable *cancellable, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_CACHE (self), NULL);
+
+    g_autofree gchar *path = g_build_filename (g_get_user_cache_dir (), "snap-store", type, NULL);
+    g_autoptr(GFile) dir = g_file_new_for_path (path);
+
+    g_autoptr(GPtrArray) names = g_ptr_array_new_with_free_func (g_free);
+    g_autoptr(GError) local_error = NULL;
+    g_autoptr(GFileEnumerator) enumerator = g_file_enumerate_children (dir, G_FILE_ATTRIBUTE_STANDARD_NAME, G_FILE_QUERY_INFO_NONE, cancellable, &local_error);
+    if (enumerator == NULL) {
+        /* Nothing cached yet */
+        if (!g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+            g_propagate_error (error, g_steal_pointer (&local_error));
+            return NULL;
+        }
+    }
+    else {
+        while (TRUE) {
+            GFileInfo *info;
+            if (!g_file_enumerator_iterate (enumerator, &info, NULL, cancellable, error))
+                return NULL;
+            if (info == NULL)
+                break;
+            g_ptr_array_add (names, g_strdup (g_file_info_get_name (info)));
+        }
+    }
+    g_ptr_array_add (names, NULL);
+
+    return (GStrv) g_ptr_array_free (g_steal_pointer (&names), FALSE);
+}
+
+GVariant *
+store_cache_get_stats (StoreCache *self)
+{
+    g_return_val_if_fail (STORE_IS_CACHE (self), NULL);
+
+    g_autoptr(GList) types = g_list_sort (g_hash_table_get_keys (self->stats), (GCompareFunc) g_strcmp0);
+
+    GVariantBuilder builder;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{st}}"));
+    for (GList *link = types; link != NULL; link = link->next) {
+        const gchar *type = link->data;
+        store_stats_add_to_builder (g_hash_table_lookup (self->stats, type), type, &builder);
+    }
+
+    return g_variant_builder_end (&builder);
+}
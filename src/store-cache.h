@@ -9,7 +9,7 @@
 
 #pragma once
 
-#include <glib-object.h>
+#include <gio/gio.h>
 #include <json-glib/json-glib.h>
 
 G_BEGIN_DECLS
@@ -31,4 +31,10 @@ GBytes     *store_cache_lookup_sync   (StoreCache *cache, const gchar *type, con
 
 JsonNode   *store_cache_lookup_json   (StoreCache *cache, const gchar *type, const gchar *name, gboolean hash, GCancellable *cancellable, GError **error);
 
+GFile      *store_cache_get_file      (StoreCache *cache, const gchar *type, const gchar *name, gboolean hash);
+
+GStrv       store_cache_list_sync     (StoreCache *cache, const gchar *type, GCancellable *cancellable, GError **error);
+
+GVariant   *store_cache_get_stats     (StoreCache *cache);
+
 G_END_DECLS
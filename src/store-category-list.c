@@ -112,30 +112,66 @@ store_category_list_set_category (StoreCategoryList *self, StoreCategory *catego
 
     GPtrArray *apps = store_category_get_apps (category); // FIXME Update when apps updates
 
-    /* Ensure correct number of app tiles */
+    /* Match existing tiles by app, so unchanged apps keep their tile and bindings */
+    g_autoptr(GHashTable) tiles = g_hash_table_new (g_direct_hash, g_direct_equal);
     g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
-    guint n_tiles = g_list_length (children);
+    for (GList *link = children; link != NULL; link = link->next) {
+        StoreAppSmallTile *tile = link->data;
+        g_hash_table_insert (tiles, store_app_small_tile_get_app (tile), tile);
+    }
+
     guint n_apps = apps->len <  5 ? apps->len : 5;
-    while (n_tiles < n_apps) {
-        StoreAppSmallTile *tile = store_app_small_tile_new ();
-        gtk_widget_show (GTK_WIDGET (tile));
-        g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
-        store_app_small_tile_set_model (tile, self->model);
-        gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        n_tiles++;
-        children = g_list_append (children, tile);
+    g_autoptr(GPtrArray) new_tiles = g_ptr_array_new ();
+    for (guint i = 0; i < n_apps; i++) {
+        StoreApp *app = g_ptr_array_index (apps, i);
+        StoreAppSmallTile *tile = g_hash_table_lookup (tiles, app);
+        if (tile != NULL)
+            g_hash_table_remove (tiles, app);
+        g_ptr_array_add (new_tiles, tile);
     }
-    if (n_tiles > n_apps) {
-        for (GList *link = g_list_nth (children, n_apps); link != NULL; link = link->next) {
-            StoreAppSmallTile *tile = link->data;
-            gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
+
+    /* Reuse tiles of apps no longer shown for new apps, and remove any left over */
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, tiles);
+    gpointer value;
+    for (guint i = 0; i < n_apps; i++) {
+        if (g_ptr_array_index (new_tiles, i) != NULL)
+            continue;
+
+        StoreAppSmallTile *tile;
+        if (g_hash_table_iter_next (&iter, NULL, &value)) {
+            tile = value;
+            g_hash_table_iter_remove (&iter);
         }
+        else {
+            tile = store_app_small_tile_new ();
+            gtk_widget_show (GTK_WIDGET (tile));
+            g_signal_connect_object (tile, "activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
+            store_app_small_tile_set_model (tile, self->model);
+            gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
+        }
+        store_app_small_tile_set_app (tile, g_ptr_array_index (apps, i));
+        g_ptr_array_index (new_tiles, i) = tile;
+    }
+    while (g_hash_table_iter_next (&iter, NULL, &value)) {
+        gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (value));
+        g_hash_table_iter_remove (&iter);
     }
+
+    /* Only move tiles that are out of place */
+    g_autoptr(GList) ordered_children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
+    GList *link = ordered_children;
     for (guint i = 0; i < n_apps; i++) {
-        StoreApp *app = g_ptr_array_index (apps, i);
-        StoreAppSmallTile *tile = g_list_nth_data (children, i);
-        store_app_small_tile_set_app (tile, app);
+        StoreAppSmallTile *tile = g_ptr_array_index (new_tiles, i);
+        if (link != NULL && link->data == tile) {
+            link = link->next;
+            continue;
+        }
+        gtk_box_reorder_child (self->app_box, GTK_WIDGET (tile), i);
+        link = NULL;
     }
+    for (guint i = 0; i < n_apps; i++)
+        store_app_small_tile_set_prefetch (g_ptr_array_index (new_tiles, i), i == 0); /* First row of the home page */
 }
 
 StoreCategory *
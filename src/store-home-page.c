@@ -195,6 +195,15 @@ store_home_page_set_model (StorePage *page, StoreModel *model)
 
     g_object_bind_property (model, "categories", self, "categories", G_BINDING_SYNC_CREATE);
 
+    /* Banners come from the cache, so they show in the first frame */
+    // FIXME: Hardcoded
+    g_autoptr(StoreSnapApp) app = store_model_get_snap (model, "telemetrytv");
+    store_banner_tile_set_app (self->banner_tile, STORE_APP (app));
+    g_autoptr(StoreSnapApp) app1 = store_model_get_snap (model, "supertuxkart");
+    store_banner_tile_set_app (self->banner1_tile, STORE_APP (app1));
+    g_autoptr(StoreSnapApp) app2 = store_model_get_snap (model, "fluffychat");
+    store_banner_tile_set_app (self->banner2_tile, STORE_APP (app2));
+
     STORE_PAGE_CLASS (store_home_page_parent_class)->set_model (page, model);
 }
 
@@ -299,12 +308,13 @@ void
 store_home_page_load (StoreHomePage *self)
 {
     store_model_update_categories_async (store_page_get_model (STORE_PAGE (self)), NULL, NULL, NULL);
+}
 
-    // FIXME: Hardcoded
-    g_autoptr(StoreSnapApp) app = store_model_get_snap (store_page_get_model (STORE_PAGE (self)), "telemetrytv");
-    store_banner_tile_set_app (self->banner_tile, STORE_APP (app));
-    g_autoptr(StoreSnapApp) app1 = store_model_get_snap (store_page_get_model (STORE_PAGE (self)), "supertuxkart");
-    store_banner_tile_set_app (self->banner1_tile, STORE_APP (app1));
-    g_autoptr(StoreSnapApp) app2 = store_model_get_snap (store_page_get_model (STORE_PAGE (self)), "fluffychat");
-    store_banner_tile_set_app (self->banner2_tile, STORE_APP (app2));
+void
+store_home_page_search (StoreHomePage *self, const gchar *query)
+{
+    g_return_if_fail (STORE_IS_HOME_PAGE (self));
+
+    gtk_entry_set_text (self->search_entry, query);
+    gtk_widget_grab_focus (GTK_WIDGET (self->search_entry));
 }
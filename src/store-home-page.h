@@ -19,4 +19,6 @@ void store_home_page_load           (StoreHomePage *page);
 
 void store_home_page_set_categories (StoreHomePage *self, GPtrArray *categories);
 
+void store_home_page_search         (StoreHomePage *self, const gchar *query);
+
 G_END_DECLS
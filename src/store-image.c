@@ -10,6 +10,7 @@
 #include "store-image.h"
 
 #include "store-model.h"
+#include "store-page.h"
 
 struct _StoreImage
 {
@@ -17,9 +18,11 @@ struct _StoreImage
 
     GCancellable *cache_cancellable;
     GCancellable *cancellable;
+    gboolean deferred;
     guint height;
     StoreModel *model;
     GdkPixbuf *pixbuf;
+    StoreImagePriority priority;
     guint width;
     gchar *uri;
 };
@@ -29,6 +32,7 @@ enum
     PROP_0,
     PROP_HEIGHT,
     PROP_MEDIA,
+    PROP_PRIORITY,
     PROP_WIDTH,
     PROP_URI,
     PROP_LAST
@@ -51,10 +55,16 @@ image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 
     g_autoptr(GError) error = NULL;
     g_autoptr(GdkPixbuf) pixbuf = store_model_get_image_finish (STORE_MODEL (object), result, &error);
+    if (pixbuf == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+
+    /* Done, so hiding the page doesn't cause a reload */
+    g_clear_object (&self->cancellable);
+
     if (pixbuf == NULL) {
-        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            return;
-        g_warning ("Failed to load image: %s", error->message);
+        /* Not modified means the cached copy being loaded is up to date */
+        if (!g_error_matches (error, STORE_MODEL_ERROR, STORE_MODEL_ERROR_NOT_MODIFIED))
+            g_warning ("Failed to load image: %s", error->message);
         return;
     }
 
@@ -72,9 +82,13 @@ cache_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 
     g_autoptr(GError) error = NULL;
     g_autoptr(GdkPixbuf) pixbuf = store_model_get_cached_image_finish (STORE_MODEL (object), result, &error);
+    if (pixbuf == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        return;
+
+    /* Done, so hiding the page doesn't cause a reload */
+    g_clear_object (&self->cache_cancellable);
+
     if (pixbuf == NULL) {
-        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            return;
         if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
             g_warning ("Failed to load cached image: %s", error->message);
         return;
@@ -92,6 +106,8 @@ store_image_dispose (GObject *object)
     g_clear_object (&self->cache_cancellable);
     g_cancellable_cancel (self->cancellable);
     g_clear_object (&self->cancellable);
+    if (self->model != NULL)
+        g_signal_handlers_disconnect_by_data (self->model, self);
     g_clear_object (&self->model);
     g_clear_object (&self->pixbuf);
     g_clear_pointer (&self->uri, g_free);
@@ -109,6 +125,9 @@ store_image_get_property (GObject *object, guint prop_id, GValue *value, GParamS
     case PROP_HEIGHT:
         g_value_set_int (value, self->height);
         break;
+    case PROP_PRIORITY:
+        g_value_set_enum (value, self->priority);
+        break;
     case PROP_WIDTH:
         g_value_set_int (value, self->width);
         break;
@@ -134,6 +153,9 @@ store_image_set_property (GObject *object, guint prop_id, const GValue *value, G
     case PROP_MEDIA:
         store_image_set_media (self, g_value_get_object (value));
         break;
+    case PROP_PRIORITY:
+        store_image_set_priority (self, g_value_get_enum (value));
+        break;
     case PROP_WIDTH:
         self->width = g_value_get_int (value);
         break;
@@ -168,6 +190,102 @@ store_image_get_preferred_width (GtkWidget *widget, gint *minimum_width, gint *n
     *minimum_width = *natural_width = width;
 }
 
+/* Images that aren't on screen are only downloaded when nothing visible is waiting */
+static StoreImagePriority
+get_priority (StoreImage *self)
+{
+    return gtk_widget_get_mapped (GTK_WIDGET (self)) ? self->priority : STORE_IMAGE_PRIORITY_PREFETCH;
+}
+
+static void
+update_priority (StoreImage *self)
+{
+    if (self->model != NULL && self->cancellable != NULL)
+        store_model_set_image_priority (self->model, self->cancellable, get_priority (self));
+}
+
+/* Icons are always downloaded, other images depend on the network */
+static gboolean
+can_download (StoreImage *self)
+{
+    if (self->priority == STORE_IMAGE_PRIORITY_ICON)
+        return TRUE;
+
+    switch (store_model_get_media_policy (self->model))
+    {
+    case STORE_MEDIA_POLICY_ICONS_ONLY:
+        return FALSE;
+    case STORE_MEDIA_POLICY_DEFER_SCREENSHOTS:
+        return self->priority != STORE_IMAGE_PRIORITY_SCREENSHOT || gtk_widget_get_mapped (GTK_WIDGET (self));
+    default:
+        return TRUE;
+    }
+}
+
+static void
+load (StoreImage *self)
+{
+    /* Cancel existing operation */
+    g_cancellable_cancel (self->cancellable);
+    g_clear_object (&self->cancellable);
+    g_cancellable_cancel (self->cache_cancellable);
+    g_clear_object (&self->cache_cancellable);
+    self->deferred = FALSE;
+
+    if (self->uri == NULL)
+        return;
+
+    /* Load cache information */
+    g_autofree gchar *etag = NULL;
+    g_autoptr(GError) error = NULL;
+    if (!store_model_get_cached_image_metadata_sync (self->model, self->uri, &etag, NULL, NULL, NULL, &error)) {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
+            g_warning ("Failed to get cached image metadata: %s", error->message);
+    }
+
+    /* Cancelled along with the page we are on when it is hidden */
+    if (can_download (self)) {
+        self->cancellable = store_page_new_cancellable_for_widget (GTK_WIDGET (self));
+        store_model_get_image_async (self->model, self->uri, etag, self->width, self->height, get_priority (self), self->cancellable, image_cb, self);
+    }
+    else
+        self->deferred = TRUE;
+
+    /* Load cached version */
+    self->cache_cancellable = store_page_new_cancellable_for_widget (GTK_WIDGET (self));
+    store_model_get_cached_image_async (self->model, self->uri, etag, self->width, self->height, self->cache_cancellable, cache_cb, self);
+}
+
+static void
+media_policy_changed_cb (StoreImage *self)
+{
+    if (self->deferred && can_download (self))
+        load (self);
+}
+
+static void
+store_image_map (GtkWidget *widget)
+{
+    StoreImage *self = STORE_IMAGE (widget);
+
+    GTK_WIDGET_CLASS (store_image_parent_class)->map (widget);
+
+    /* Restart if a load was cancelled when our page was hidden or the download is allowed now we are visible */
+    if ((self->cancellable != NULL && g_cancellable_is_cancelled (self->cancellable)) ||
+        (self->cache_cancellable != NULL && g_cancellable_is_cancelled (self->cache_cancellable)) ||
+        (self->deferred && can_download (self)))
+        load (self);
+    else
+        update_priority (self);
+}
+
+static void
+store_image_unmap (GtkWidget *widget)
+{
+    GTK_WIDGET_CLASS (store_image_parent_class)->unmap (widget);
+    update_priority (STORE_IMAGE (widget));
+}
+
 static gboolean
 store_image_draw (GtkWidget *widget, cairo_t *cr)
 {
@@ -194,6 +312,8 @@ store_image_class_init (StoreImageClass *klass)
     GTK_WIDGET_CLASS (klass)->get_preferred_height = store_image_get_preferred_height;
     GTK_WIDGET_CLASS (klass)->get_preferred_width = store_image_get_preferred_width;
     GTK_WIDGET_CLASS (klass)->draw = store_image_draw;
+    GTK_WIDGET_CLASS (klass)->map = store_image_map;
+    GTK_WIDGET_CLASS (klass)->unmap = store_image_unmap;
 
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_HEIGHT,
@@ -201,6 +321,9 @@ store_image_class_init (StoreImageClass *klass)
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_MEDIA,
                                      g_param_spec_object ("media", NULL, NULL, store_media_get_type (), G_PARAM_WRITABLE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_PRIORITY,
+                                     g_param_spec_enum ("priority", NULL, NULL, store_image_priority_get_type (), STORE_IMAGE_PRIORITY_ICON, G_PARAM_READWRITE));
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_WIDTH,
                                      g_param_spec_int ("width", NULL, NULL, G_MININT, G_MAXINT, 0, G_PARAM_READWRITE));
@@ -232,7 +355,21 @@ void
 store_image_set_model (StoreImage *self, StoreModel *model)
 {
     g_return_if_fail (STORE_IS_IMAGE (self));
+
+    if (self->model != NULL)
+        g_signal_handlers_disconnect_by_data (self->model, self);
     g_set_object (&self->model, model);
+    if (self->model != NULL)
+        g_signal_connect_object (self->model, "notify::media-policy", G_CALLBACK (media_policy_changed_cb), self, G_CONNECT_SWAPPED);
+}
+
+void
+store_image_set_priority (StoreImage *self, StoreImagePriority priority)
+{
+    g_return_if_fail (STORE_IS_IMAGE (self));
+
+    self->priority = priority;
+    update_priority (self);
 }
 
 void
@@ -256,30 +393,8 @@ store_image_set_uri (StoreImage *self, const gchar *uri)
     g_free (self->uri);
     self->uri = g_strdup (uri);
 
-    /* Cancel existing operation */
-    g_cancellable_cancel (self->cancellable);
-    g_clear_object (&self->cancellable);
-    g_cancellable_cancel (self->cache_cancellable);
-    g_clear_object (&self->cache_cancellable);
-
     g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new_from_resource_at_scale ("/io/snapcraft/Store/default-snap-icon.svg", self->width, self->height, TRUE, NULL); // FIXME: Make a property
     set_pixbuf (self, pixbuf);
 
-    if (uri == NULL)
-        return;
-
-    /* Load cache information */
-    g_autofree gchar *etag = NULL;
-    g_autoptr(GError) error = NULL;
-    if (!store_model_get_cached_image_metadata_sync (self->model, uri, &etag, NULL, NULL, self->cancellable, &error)) {
-        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND))
-            g_warning ("Failed to get cached image metadata: %s", error->message);
-    }
-
-    self->cancellable = g_cancellable_new ();
-    store_model_get_image_async (self->model, uri, etag, self->width, self->height, self->cancellable, image_cb, self);
-
-    /* Load cached version */
-    self->cache_cancellable = g_cancellable_new ();
-    store_model_get_cached_image_async (self->model, uri, self->width, self->height, self->cache_cancellable, cache_cb, self);
+    load (self);
 }
@@ -18,14 +18,16 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (StoreImage, store_image, STORE, IMAGE, GtkDrawingArea)
 
-StoreImage *store_image_new       (void);
+StoreImage *store_image_new          (void);
 
-void        store_image_set_media (StoreImage *image, StoreMedia *media);
+void        store_image_set_media    (StoreImage *image, StoreMedia *media);
 
-void        store_image_set_model (StoreImage *image, StoreModel *model);
+void        store_image_set_model    (StoreImage *image, StoreModel *model);
 
-void        store_image_set_size  (StoreImage *image, guint width, guint height);
+void        store_image_set_priority (StoreImage *image, StoreImagePriority priority);
 
-void        store_image_set_uri   (StoreImage *image, const gchar *uri);
+void        store_image_set_size     (StoreImage *image, guint width, guint height);
+
+void        store_image_set_uri      (StoreImage *image, const gchar *uri);
 
 G_END_DECLS
@@ -130,42 +130,60 @@ store_installed_page_init (StoreInstalledPage *self)
     gtk_widget_init_template (GTK_WIDGET (self));
 }
 
-void
-store_installed_page_load (StoreInstalledPage *self)
-{
-    g_return_if_fail (STORE_IS_INSTALLED_PAGE (self));
-
-    store_model_update_installed_async (store_page_get_model (STORE_PAGE (self)), NULL, NULL, NULL);
-}
-
 void
 store_installed_page_set_apps (StoreInstalledPage *self, GPtrArray *apps)
 {
     g_return_if_fail (STORE_IS_INSTALLED_PAGE (self));
 
-    /* Ensure correct number of app tiles */
+    /* Match existing tiles by app, so unchanged apps keep their tile and bindings */
+    g_autoptr(GHashTable) tiles = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_autoptr(GHashTable) unused_tiles = g_hash_table_new (g_direct_hash, g_direct_equal);
     g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
-    guint n_tiles = g_list_length (children);
-    while (n_tiles < apps->len) {
-        StoreAppInstalledTile *tile = store_app_installed_tile_new ();
+    for (GList *link = children; link != NULL; link = link->next) {
+        StoreAppInstalledTile *tile = link->data;
+        g_hash_table_insert (tiles, store_app_installed_tile_get_app (tile), tile);
+        g_hash_table_add (unused_tiles, tile);
+    }
+
+    /* Add tiles for new apps */
+    for (guint i = 0; i < apps->len; i++) {
+        StoreApp *app = g_ptr_array_index (apps, i);
+        StoreAppInstalledTile *tile = g_hash_table_lookup (tiles, app);
+        if (tile != NULL) {
+            g_hash_table_remove (unused_tiles, tile);
+            continue;
+        }
+
+        tile = store_app_installed_tile_new ();
         gtk_widget_show (GTK_WIDGET (tile));
         gtk_size_group_add_widget (self->title_size_group, store_app_installed_tile_get_title_box (tile));
         g_signal_connect_object (tile, "activated", G_CALLBACK (tile_activated_cb), self, G_CONNECT_SWAPPED);
         store_app_installed_tile_set_model (tile, store_page_get_model (STORE_PAGE (self)));
+        store_app_installed_tile_set_app (tile, app);
         gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        n_tiles++;
-        children = g_list_append (children, tile);
+        g_hash_table_insert (tiles, app, tile);
     }
-    if (n_tiles > apps->len) {
-        for (GList *link = g_list_nth (children, apps->len); link != NULL; link = link->next) {
-            StoreAppInstalledTile *tile = link->data;
-            gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
-        }
+
+    /* Remove tiles for apps no longer installed */
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, unused_tiles);
+    gpointer key;
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+        StoreAppInstalledTile *tile = key;
+        gtk_size_group_remove_widget (self->title_size_group, store_app_installed_tile_get_title_box (tile));
+        gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
     }
 
-    for (guint i = 0; i < apps->len; i++) {
-        StoreSnapApp *app = g_ptr_array_index (apps, i);
-        StoreAppInstalledTile *tile = g_list_nth_data (children, i);
-        store_app_installed_tile_set_app (tile, STORE_APP (app));
+    /* Installs append and removes keep the order, so only reorder if the order actually changed */
+    g_autoptr(GList) ordered_children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
+    GList *link = ordered_children;
+    guint i = 0;
+    for (; i < apps->len && link != NULL; i++, link = link->next) {
+        if (store_app_installed_tile_get_app (link->data) != g_ptr_array_index (apps, i))
+            break;
+    }
+    for (; i < apps->len; i++) {
+        StoreAppInstalledTile *tile = g_hash_table_lookup (tiles, g_ptr_array_index (apps, i));
+        gtk_box_reorder_child (self->app_box, GTK_WIDGET (tile), i);
     }
 }
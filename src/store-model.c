@@ -13,18 +13,47 @@
 
 #include "store-model.h"
 #include "store-odrs-client.h"
+#include "store-stats.h"
+#include "store-trace.h"
 
 struct _StoreModel
 {
     GObject parent_instance;
 
+    GPtrArray *active_operations;
     StoreCache *cache;
     GPtrArray *categories;
+    guint image_cancel_source;
+    GHashTable *image_host_requests;
+    GQueue *image_queue;
     GPtrArray *installed;
+    StoreMediaPolicy media_policy;
+    StoreMediaPolicy media_policy_override;
+    guint n_active_prefetches;
+    guint n_active_transfers;
     StoreOdrsClient *odrs_client;
+    GCancellable *operation_cancellable;
+    GQueue *operation_queue;
+    GQueue *prefetch_queue;
+    guint prefetch_source;
+    GHashTable *prefetches;
+    GHashTable *search_index;
+    gboolean search_index_loading;
+    guint search_index_source;
+    GHashTable *search_index_updates;
+    GPtrArray *search_tasks;
     SoupSession *session;
+    StoreStats image_stats;
     gchar *snapd_socket_path;
     GHashTable *snaps;
+    guint snapshot_source;
+    gdouble throughput;
+    gint64 throughput_busy_start;
+    gint64 throughput_busy_time;
+    gsize throughput_bytes;
+    guint throughput_expiry_source;
+    GPtrArray *updates;
+    gint64 updates_time;
 };
 
 enum
@@ -32,29 +61,131 @@ enum
     PROP_0,
     PROP_CATEGORIES,
     PROP_INSTALLED,
+    PROP_MEDIA_POLICY,
+    PROP_UPDATES,
     PROP_LAST
 };
 
 G_DEFINE_TYPE (StoreModel, store_model, G_TYPE_OBJECT)
 
+G_DEFINE_QUARK (store-model-error-quark, store_model_error)
+
+GType
+store_image_priority_get_type (void)
+{
+    static gsize type = 0;
+
+    if (g_once_init_enter (&type)) {
+        static const GEnumValue values[] = {
+            { STORE_IMAGE_PRIORITY_ICON, "STORE_IMAGE_PRIORITY_ICON", "icon" },
+            { STORE_IMAGE_PRIORITY_BANNER, "STORE_IMAGE_PRIORITY_BANNER", "banner" },
+            { STORE_IMAGE_PRIORITY_SCREENSHOT, "STORE_IMAGE_PRIORITY_SCREENSHOT", "screenshot" },
+            { STORE_IMAGE_PRIORITY_PREFETCH, "STORE_IMAGE_PRIORITY_PREFETCH", "prefetch" },
+            { 0, NULL, NULL }
+        };
+        g_once_init_leave (&type, g_enum_register_static ("StoreImagePriority", values));
+    }
+
+    return type;
+}
+
+GType
+store_media_policy_get_type (void)
+{
+    static gsize type = 0;
+
+    if (g_once_init_enter (&type)) {
+        static const GEnumValue values[] = {
+            { STORE_MEDIA_POLICY_AUTOMATIC, "STORE_MEDIA_POLICY_AUTOMATIC", "automatic" },
+            { STORE_MEDIA_POLICY_FULL, "STORE_MEDIA_POLICY_FULL", "full" },
+            { STORE_MEDIA_POLICY_DEFER_SCREENSHOTS, "STORE_MEDIA_POLICY_DEFER_SCREENSHOTS", "defer-screenshots" },
+            { STORE_MEDIA_POLICY_ICONS_ONLY, "STORE_MEDIA_POLICY_ICONS_ONLY", "icons-only" },
+            { 0, NULL, NULL }
+        };
+        g_once_init_leave (&type, g_enum_register_static ("StoreMediaPolicy", values));
+    }
+
+    return type;
+}
+
+/* Icons, banners and screenshots come from a small number of CDN hosts, so allow more parallel
+ * connections per host than the libsoup default and keep them open between page views */
+#define MAX_CONNS_PER_HOST 6
+#define MAX_CONNS          24
+#define IDLE_TIMEOUT       90
+
+/* Throughput (bytes/s) is measured across all image downloads over windows of time at least one is
+ * transferring, so parallel downloads sharing a slow link aren't each counted as fast. A slow measurement
+ * is forgotten after a while so screenshots are downloaded again and the network measured afresh */
+#define MIN_THROUGHPUT_SAMPLE 65536
+#define SLOW_THROUGHPUT       100000
+#define THROUGHPUT_WINDOW     (2 * G_USEC_PER_SEC)
+#define THROUGHPUT_LIFETIME   (10 * 60)
+
+/* Image requests are queued by priority and only sent when their host has a free connection,
+ * so libsoup never queues them itself in arrival order. Prefetches may only use a few connections
+ * per host, so what is on screen always has some free */
+#define MAX_PREFETCH_IMAGES_PER_HOST 2
+
+/* Prefetches run at low priority with only a few in flight so they don't compete with what is on screen.
+ * Results are reused for a few minutes so opening a prefetched app doesn't repeat the requests */
+#define MAX_ACTIVE_PREFETCHES 2
+#define PREFETCH_LIFETIME     (5 * 60 * G_USEC_PER_SEC)
+
+/* Images decoded at less than half their original size also get the decoded copy saved as a thumbnail,
+ * so later views (e.g. the screenshot strip) don't decode the full size image again */
+#define THUMBNAIL_SCALE 2
+
+/* The list of available updates comes from one snapd query and is reused for this long.
+ * It is invalidated whenever we install, remove or refresh snaps */
+#define UPDATES_LIFETIME (30 * 60 * G_USEC_PER_SEC)
+
+/* The categories and the apps shown in them are also saved together in one snapshot, so startup
+ * only has to read one file. Bump the version when the format changes so old snapshots are ignored */
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_DELAY   2
+
+/* Searching the cache only needs a few fields from each snap, so these are kept in one small index
+ * instead of loading every snap. It is saved with the same delay as the snapshot */
+#define SEARCH_INDEX_VERSION 1
+
+typedef struct
+{
+    guint n_pending;
+    guint n_updated;
+    GError *error;
+} UpdateCategoriesData;
+
+static void
+update_categories_data_free (UpdateCategoriesData *data)
+{
+    g_clear_error (&data->error);
+    g_free (data);
+}
+
 typedef struct
 {
     StoreModel *self;
     gchar *section_name;
+    GTask *task;
+    gint64 trace_start;
 } FindSectionData;
 
 static FindSectionData *
-find_section_data_new (StoreModel *self, const gchar *section_name)
+find_section_data_new (GTask *task, const gchar *section_name)
 {
     FindSectionData *data = g_new0 (FindSectionData, 1);
-    data->self = self;
+    data->self = g_task_get_source_object (task);
     data->section_name = g_strdup (section_name);
+    data->task = g_object_ref (task);
+    data->trace_start = store_trace_begin ();
     return data;
 }
 
 static void
 find_section_data_free (FindSectionData *data)
 {
+    g_object_unref (data->task);
     g_free (data->section_name);
     g_free (data);
 }
@@ -65,12 +196,18 @@ typedef struct
 {
     StoreModel *self;
     gchar *uri;
+    gchar *etag;
+    gchar *host;
+    StoreImagePriority priority;
+    gboolean decode;
+    gulong cancelled_id;
     SoupMessage *message;
     gint orig_width;
     gint orig_height;
     gint width;
     gint height;
     GByteArray *buffer;
+    gint64 start;
 } GetImageData;
 
 static GetImageData *
@@ -82,6 +219,7 @@ get_image_data_new (StoreModel *self, const gchar *uri, gint width, gint height)
     data->width = width;
     data->height = height;
     data->buffer = g_byte_array_new ();
+    data->start = g_get_monotonic_time ();
     return data;
 }
 
@@ -90,6 +228,8 @@ get_image_data_free (GetImageData *data)
 {
     g_clear_pointer (&data->buffer, g_byte_array_unref);
     g_clear_pointer (&data->uri, g_free);
+    g_clear_pointer (&data->etag, g_free);
+    g_clear_pointer (&data->host, g_free);
     g_clear_object (&data->message);
     g_clear_pointer (&data, g_free);
 }
@@ -117,6 +257,124 @@ feedback_data_free (FeedbackData *data)
     g_free (data);
 }
 
+typedef enum
+{
+    OPERATION_INSTALL,
+    OPERATION_REMOVE,
+    OPERATION_REFRESH_ALL
+} OperationType;
+
+typedef struct
+{
+    StoreModel *self;
+    OperationType type;
+    GTask *task;
+    StoreApp *app;
+    GPtrArray *apps;
+    gchar *channel;
+    gulong cancelled_id;
+} Operation;
+
+static Operation *
+operation_new (StoreModel *self, OperationType type, GTask *task, StoreApp *app, const gchar *channel)
+{
+    Operation *operation = g_new0 (Operation, 1);
+    operation->self = self;
+    operation->type = type;
+    operation->task = task;
+    operation->app = app != NULL ? g_object_ref (app) : NULL;
+    operation->channel = g_strdup (channel);
+    return operation;
+}
+
+static const gchar *
+operation_type_to_string (OperationType type)
+{
+    switch (type)
+    {
+    case OPERATION_INSTALL:
+        return "install";
+    case OPERATION_REMOVE:
+        return "remove";
+    case OPERATION_REFRESH_ALL:
+        return "refresh-all";
+    default:
+        return NULL;
+    }
+}
+
+/* A refresh-all applies to every app being updated */
+static void
+operation_set_state (Operation *operation, StoreAppState state)
+{
+    if (operation->app != NULL)
+        store_app_set_state (operation->app, state);
+    for (guint i = 0; operation->apps != NULL && i < operation->apps->len; i++)
+        store_app_set_state (g_ptr_array_index (operation->apps, i), state);
+}
+
+static void
+operation_set_busy (Operation *operation, gboolean busy)
+{
+    if (operation->app != NULL) {
+        g_autoptr(StoreProgress) progress = busy ? store_progress_new () : NULL;
+        store_app_set_progress (operation->app, progress);
+    }
+    for (guint i = 0; operation->apps != NULL && i < operation->apps->len; i++) {
+        g_autoptr(StoreProgress) progress = busy ? store_progress_new () : NULL;
+        store_app_set_progress (g_ptr_array_index (operation->apps, i), progress);
+    }
+}
+
+static void
+operation_disconnect (Operation *operation)
+{
+    if (operation->cancelled_id != 0)
+        g_signal_handler_disconnect (g_task_get_cancellable (operation->task), operation->cancelled_id);
+    operation->cancelled_id = 0;
+}
+
+static void
+operation_free (Operation *operation)
+{
+    operation_disconnect (operation);
+    g_clear_object (&operation->task);
+    g_clear_object (&operation->app);
+    g_clear_pointer (&operation->apps, g_ptr_array_unref);
+    g_clear_pointer (&operation->channel, g_free);
+    g_free (operation);
+}
+
+typedef struct
+{
+    StoreModel *self;
+    StoreApp *app;
+    GCancellable *cancellable;
+    gint64 details_time;
+    gint64 details_trace_start;
+    guint n_pending;
+    gboolean queued;
+    gboolean requeue;
+    gint64 reviews_time;
+} PrefetchData;
+
+static PrefetchData *
+prefetch_data_new (StoreModel *self, StoreApp *app)
+{
+    PrefetchData *data = g_new0 (PrefetchData, 1);
+    data->self = self;
+    data->app = g_object_ref (app);
+    return data;
+}
+
+static void
+prefetch_data_free (PrefetchData *data)
+{
+    g_clear_object (&data->app);
+    g_clear_object (&data->cancellable);
+    g_free (data);
+}
+
 static void
 set_review_counts (StoreModel *self, StoreApp *app)
 {
@@ -127,11 +385,7 @@ set_review_counts (StoreModel *self, StoreApp *app)
     if (store_app_get_appstream_id (app) != NULL)
         ratings = store_odrs_client_get_ratings (self->odrs_client, store_app_get_appstream_id (app));
 
-    store_app_set_review_count_one_star (app, ratings != NULL ? ratings[0] : 0);
-    store_app_set_review_count_two_star (app, ratings != NULL ? ratings[1] : 0);
-    store_app_set_review_count_three_star (app, ratings != NULL ? ratings[2] : 0);
-    store_app_set_review_count_four_star (app, ratings != NULL ? ratings[3] : 0);
-    store_app_set_review_count_five_star (app, ratings != NULL ? ratings[4] : 0);
+    store_app_set_review_counts (app, ratings);
 }
 
 static GPtrArray *
@@ -305,524 +559,2112 @@ load_cached_categories (StoreModel *self)
     return g_steal_pointer (&categories);
 }
 
-StoreCategory *
-find_category (StoreModel *self, const gchar *section_name)
+static StoreSnapApp *
+lookup_snap (StoreModel *self, const gchar *name)
 {
-    for (guint i = 0; i < self->categories->len; i++) {
-        StoreCategory *category = g_ptr_array_index (self->categories, i);
-        if (g_strcmp0 (store_category_get_name (category), section_name) == 0)
-            return category;
+    StoreSnapApp *snap = g_hash_table_lookup (self->snaps, name);
+    if (snap == NULL) {
+        snap = store_snap_app_new ();
+        store_app_set_name (STORE_APP (snap), name);
+        g_hash_table_insert (self->snaps, g_strdup (name), snap); // FIXME: Use a weak ref to clean out when no-longer used
     }
 
-    return NULL;
+    return g_object_ref (snap);
 }
 
-static void
-get_category_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+static gboolean
+has_member_of_type (JsonObject *object, const gchar *name, JsonNodeType type)
 {
-    g_autoptr(FindSectionData) data = user_data;
-    StoreModel *self = data->self;
+    return json_object_has_member (object, name) && json_node_get_node_type (json_object_get_member (object, name)) == type;
+}
 
-    g_autoptr(GError) error = NULL;
-    g_autoptr(GPtrArray) snaps = snapd_client_find_section_finish (SNAPD_CLIENT (object), result, NULL, &error);
-    if (snaps == NULL) {
-        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            return;
-        g_warning ("Failed to find snaps in category: %s", error->message);
-        return;
-    }
+static GPtrArray *
+load_snapshot (StoreModel *self)
+{
+    if (self->cache == NULL)
+        return NULL;
 
-    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
-    for (guint i = 0; i < snaps->len; i++) {
-        SnapdSnap *snap = g_ptr_array_index (snaps, i);
-        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
-        store_snap_app_update_from_search (app, snap);
-        if (self->cache != NULL)
-            store_app_save_to_cache (STORE_APP (app), self->cache);
-        g_ptr_array_add (apps, g_steal_pointer (&app));
-    }
+    g_autoptr(JsonNode) root = store_cache_lookup_json (self->cache, "snapshot", "home", FALSE, NULL, NULL);
+    if (root == NULL || json_node_get_node_type (root) != JSON_NODE_OBJECT)
+        return NULL;
 
-    StoreCategory *category = find_category (self, data->section_name);
-    if (category != NULL)
-        store_category_set_apps (category, apps);
+    /* Anything unexpected falls back to the individual cache files */
+    JsonObject *object = json_node_get_object (root);
+    if (!has_member_of_type (object, "version", JSON_NODE_VALUE) || json_object_get_int_member (object, "version") != SNAPSHOT_VERSION ||
+        !has_member_of_type (object, "apps", JSON_NODE_OBJECT) || !has_member_of_type (object, "categories", JSON_NODE_ARRAY))
+        return NULL;
 
-    /* Save in cache */
-    if (self->cache != NULL) {
-        g_autoptr(JsonBuilder) builder = json_builder_new ();
-        json_builder_begin_array (builder);
-        for (guint i = 0; i < snaps->len; i++) {
-            SnapdSnap *snap = g_ptr_array_index (snaps, i);
-            json_builder_add_string_value (builder, snapd_snap_get_name (snap));
+    JsonObject *apps_object = json_object_get_object_member (object, "apps");
+    JsonArray *categories_array = json_object_get_array_member (object, "categories");
+    for (guint i = 0; i < json_array_get_length (categories_array); i++) {
+        JsonNode *category_node = json_array_get_element (categories_array, i);
+        if (!JSON_NODE_HOLDS_OBJECT (category_node))
+            return NULL;
+        JsonObject *category_object = json_node_get_object (category_node);
+        if (!has_member_of_type (category_object, "name", JSON_NODE_VALUE) || json_object_get_string_member (category_object, "name") == NULL ||
+            !has_member_of_type (category_object, "apps", JSON_NODE_ARRAY))
+            return NULL;
+        JsonArray *names = json_object_get_array_member (category_object, "apps");
+        for (guint j = 0; j < json_array_get_length (names); j++) {
+            JsonNode *name_node = json_array_get_element (names, j);
+            if (!JSON_NODE_HOLDS_VALUE (name_node) || json_node_get_value_type (name_node) != G_TYPE_STRING)
+                return NULL;
+            const gchar *name = json_node_get_string (name_node);
+            if (json_object_has_member (apps_object, name) && !JSON_NODE_HOLDS_OBJECT (json_object_get_member (apps_object, name)))
+                return NULL;
         }
-        json_builder_end_array (builder);
-        g_autoptr(JsonNode) root = json_builder_get_root (builder);
-        store_cache_insert_json (self->cache, "sections", data->section_name, FALSE, root, NULL, NULL);
-    }
-}
-
-static void
-get_sections_cb (GObject *object, GAsyncResult *result, gpointer user_data)
-{
-    g_autoptr(GTask) task = user_data;
-
-    g_autoptr(GError) error = NULL;
-    g_auto(GStrv) sections = snapd_client_get_sections_finish (SNAPD_CLIENT (object), result, &error);
-    if (sections == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
-        return;
     }
 
-    StoreModel *self = g_task_get_source_object (task);
+    g_autoptr(GPtrArray) categories = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < json_array_get_length (categories_array); i++) {
+        JsonObject *category_object = json_array_get_object_element (categories_array, i);
+        const gchar *section = json_object_get_string_member (category_object, "name");
 
-    g_clear_pointer (&self->categories, g_ptr_array_unref);
-    self->categories = g_ptr_array_new_with_free_func (g_object_unref);
-    for (int i = 0; sections[i] != NULL; i++) {
         StoreCategory *category = store_category_new ();
-        g_ptr_array_add (self->categories, category);
-        store_category_set_name (category, sections[i]);
-        store_category_set_title (category, get_section_title (sections[i]));
-        store_category_set_summary (category, get_section_summary (sections[i]));
+        g_ptr_array_add (categories, category);
+        store_category_set_name (category, section);
+        store_category_set_title (category, get_section_title (section));
+        store_category_set_summary (category, get_section_summary (section));
 
-        g_autoptr(GPtrArray) apps = load_cached_category_apps (self, sections[i]);
-        store_category_set_apps (category, apps);
+        JsonArray *names = json_object_get_array_member (category_object, "apps");
+        g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+        for (guint j = 0; j < json_array_get_length (names); j++) {
+            const gchar *name = json_array_get_string_element (names, j);
+            g_autoptr(StoreSnapApp) app = lookup_snap (self, name);
 
-        g_autoptr(SnapdClient) client = snapd_client_new ();
-        snapd_client_set_socket_path (client, self->snapd_socket_path);
-        snapd_client_find_section_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, sections[i], NULL, g_task_get_cancellable (task), get_category_snaps_cb, find_section_data_new (self, sections[i]));
-    }
+            store_app_begin_update (STORE_APP (app));
+            if (json_object_has_member (apps_object, name))
+                store_snap_app_update_from_json (app, json_object_get_member (apps_object, name));
+            set_review_counts (self, STORE_APP (app));
+            store_app_end_update (STORE_APP (app));
 
-    /* Save in cache */
-    if (self->cache != NULL) {
-        g_autoptr(JsonBuilder) builder = json_builder_new ();
-        json_builder_begin_array (builder);
-        for (int i = 0; sections[i] != NULL; i++)
-            json_builder_add_string_value (builder, sections[i]);
-        json_builder_end_array (builder);
-        g_autoptr(JsonNode) root = json_builder_get_root (builder);
-        store_cache_insert_json (self->cache, "sections", "_index", FALSE, root, NULL, NULL);
+            g_ptr_array_add (apps, g_steal_pointer (&app));
+        }
+        store_category_set_apps (category, apps);
     }
 
-    g_object_notify (G_OBJECT (self), "categories");
-
-    g_task_return_boolean (task, TRUE);
+    return g_steal_pointer (&categories);
 }
 
 static void
-get_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+save_snapshot (StoreModel *self)
 {
-    g_autoptr(GTask) task = user_data;
-
-    g_autoptr(GError) error = NULL;
-    g_autoptr(GPtrArray) snaps = snapd_client_get_snaps_finish (SNAPD_CLIENT (object), result, &error);
-    if (snaps == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    if (self->cache == NULL)
         return;
-    }
 
-    StoreModel *self = g_task_get_source_object (task);
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "version");
+    json_builder_add_int_value (builder, SNAPSHOT_VERSION);
+    json_builder_set_member_name (builder, "categories");
+    json_builder_begin_array (builder);
+    g_autoptr(GHashTable) apps = g_hash_table_new (g_str_hash, g_str_equal);
+    for (guint i = 0; i < self->categories->len; i++) {
+        StoreCategory *category = g_ptr_array_index (self->categories, i);
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "name");
+        json_builder_add_string_value (builder, store_category_get_name (category));
+        json_builder_set_member_name (builder, "apps");
+        json_builder_begin_array (builder);
+        GPtrArray *category_apps = store_category_get_apps (category);
+        for (guint j = 0; j < category_apps->len; j++) {
+            StoreApp *app = g_ptr_array_index (category_apps, j);
+            json_builder_add_string_value (builder, store_app_get_name (app));
+            g_hash_table_insert (apps, (gpointer) store_app_get_name (app), app);
+        }
+        json_builder_end_array (builder);
+        json_builder_end_object (builder);
+    }
+    json_builder_end_array (builder);
 
-    g_clear_pointer (&self->installed, g_ptr_array_unref);
-    self->installed = g_ptr_array_new_with_free_func (g_object_unref);
-    for (guint i = 0; i < snaps->len; i++) {
-        SnapdSnap *snap = g_ptr_array_index (snaps, i);
-        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
-        store_app_set_installed (STORE_APP (app), TRUE);
-        store_snap_app_update_from_search (app, snap);
-        if (self->cache != NULL)
-            store_app_save_to_cache (STORE_APP (app), self->cache);
-        g_ptr_array_add (self->installed, g_steal_pointer (&app));
+    /* Apps that are in more than one category are only saved once */
+    json_builder_set_member_name (builder, "apps");
+    json_builder_begin_object (builder);
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, apps);
+    const gchar *name;
+    StoreApp *app;
+    while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &app)) {
+        json_builder_set_member_name (builder, name);
+        json_builder_add_value (builder, store_snap_app_to_json (STORE_SNAP_APP (app)));
     }
+    json_builder_end_object (builder);
+    json_builder_end_object (builder);
 
-    g_object_notify (G_OBJECT (self), "installed");
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    store_cache_insert_json (self->cache, "snapshot", "home", FALSE, root, NULL, NULL);
+}
 
-    g_task_return_boolean (task, TRUE);
+static gboolean
+snapshot_cb (StoreModel *self)
+{
+    self->snapshot_source = 0;
+    save_snapshot (self);
+    return G_SOURCE_REMOVE;
 }
 
+/* Categories are updated one section at a time, so wait for them all before saving */
 static void
-ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+schedule_snapshot (StoreModel *self)
 {
-    g_autoptr(GTask) task = user_data;
-
-    g_autoptr(GError) error = NULL;
-    if (!store_odrs_client_update_ratings_finish (STORE_ODRS_CLIENT (object), result, &error)) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    if (self->cache == NULL || self->snapshot_source != 0)
         return;
-    }
-
-    StoreModel *self = g_task_get_source_object (task);
-
-    /* Update existing apps */
-    GHashTableIter iter;
-    g_hash_table_iter_init (&iter, self->snaps);
-    gpointer key, value;
-    while (g_hash_table_iter_next (&iter, &key, &value)) {
-        StoreSnapApp *snap = value;
-        gint64 *ratings = store_odrs_client_get_ratings (self->odrs_client, store_app_get_appstream_id (STORE_APP (snap)));
-        store_app_set_review_count_one_star (STORE_APP (snap), ratings != NULL ? ratings[0] : 0);
-        store_app_set_review_count_two_star (STORE_APP (snap), ratings != NULL ? ratings[1] : 0);
-        store_app_set_review_count_three_star (STORE_APP (snap), ratings != NULL ? ratings[2] : 0);
-        store_app_set_review_count_four_star (STORE_APP (snap), ratings != NULL ? ratings[3] : 0);
-        store_app_set_review_count_five_star (STORE_APP (snap), ratings != NULL ? ratings[4] : 0);
-    }
 
-    g_task_return_boolean (task, TRUE);
+    self->snapshot_source = g_timeout_add_seconds (SNAPSHOT_DELAY, (GSourceFunc) snapshot_cb, self);
 }
 
-static void
-reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+typedef struct
 {
-    g_autoptr(GTask) task = user_data;
-
-    g_autoptr(GError) error = NULL;
-    g_autofree gchar *user_skey = NULL;
-    g_autoptr(GPtrArray) reviews = store_odrs_client_get_reviews_finish (STORE_ODRS_CLIENT (object), result, &user_skey, &error);
-    if (reviews == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
-        return;
-    }
+    gchar *name;
+    gchar *title;
+    gchar *summary;
+    gchar *icon_uri;
+    gchar *keywords;
+} SearchEntry;
 
-    StoreModel *self = g_task_get_source_object (task);
-    StoreApp *app = g_task_get_task_data (task);
+typedef struct
+{
+    StoreCache *cache;
+    gboolean rebuilt;
+} LoadSearchIndexData;
 
-    store_app_set_reviews (app, reviews);
-    store_app_set_review_key (app, user_skey); // FIXME: cache?
+static SearchEntry *
+search_entry_new (const gchar *name, const gchar *title, const gchar *summary, const gchar *icon_uri)
+{
+    SearchEntry *entry = g_new0 (SearchEntry, 1);
+    entry->name = g_strdup (name);
+    entry->title = g_strdup (title);
+    entry->summary = g_strdup (summary);
+    entry->icon_uri = g_strdup (icon_uri);
 
-    cache_reviews (self, app);
-    if (self->cache != NULL)
-        store_app_save_to_cache (STORE_APP (app), self->cache);
+    /* Terms are matched against all the fields at once */
+    g_autofree gchar *text = g_strjoin ("\n", name, title != NULL ? title : "", summary != NULL ? summary : "", NULL);
+    entry->keywords = g_utf8_casefold (text, -1);
 
-    g_task_return_boolean (task, TRUE);
+    return entry;
 }
 
 static void
-downvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+search_entry_free (SearchEntry *entry)
 {
-    g_autoptr(GTask) task = user_data;
+    g_free (entry->name);
+    g_free (entry->title);
+    g_free (entry->summary);
+    g_free (entry->icon_uri);
+    g_free (entry->keywords);
+    g_free (entry);
+}
 
-    g_autoptr(GError) error = NULL;
-    if (!store_odrs_client_downvote_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+static gboolean
+search_entry_equal (SearchEntry *a, SearchEntry *b)
+{
+    return g_strcmp0 (a->title, b->title) == 0 && g_strcmp0 (a->summary, b->summary) == 0 && g_strcmp0 (a->icon_uri, b->icon_uri) == 0;
+}
+
+static const gchar *
+get_string_member (JsonObject *object, const gchar *name)
+{
+    JsonNode *node = json_object_get_member (object, name);
+    if (node == NULL || !JSON_NODE_HOLDS_VALUE (node) || json_node_get_value_type (node) != G_TYPE_STRING)
+        return NULL;
+
+    return json_node_get_string (node);
+}
+
+/* Index entries use the same fields as the cached snaps, so either can be read here */
+static SearchEntry *
+search_entry_new_from_json (JsonNode *node)
+{
+    if (!JSON_NODE_HOLDS_OBJECT (node))
+        return NULL;
+
+    JsonObject *object = json_node_get_object (node);
+    const gchar *name = get_string_member (object, "name");
+    if (name == NULL)
+        return NULL;
+
+    const gchar *icon_uri = NULL;
+    JsonNode *icon = json_object_get_member (object, "icon");
+    if (icon != NULL && JSON_NODE_HOLDS_OBJECT (icon))
+        icon_uri = get_string_member (json_node_get_object (icon), "uri");
+
+    return search_entry_new (name, get_string_member (object, "title"), get_string_member (object, "summary"), icon_uri);
+}
+
+static GHashTable *
+search_index_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal, NULL, (GDestroyNotify) search_entry_free);
+}
+
+static void
+add_search_entry (GHashTable *index, SearchEntry *entry)
+{
+    /* The key is owned by the entry, so replace it along with the entry */
+    g_hash_table_replace (index, entry->name, entry);
+}
+
+static void
+add_search_entry_from_file (GHashTable *index, GFile *file)
+{
+    g_autofree gchar *path = g_file_get_path (file);
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    if (!json_parser_load_from_file (parser, path, NULL) || json_parser_get_root (parser) == NULL)
+        return;
+
+    SearchEntry *entry = search_entry_new_from_json (json_parser_get_root (parser));
+    if (entry != NULL)
+        add_search_entry (index, entry);
+}
+
+static gboolean
+read_search_index (StoreCache *cache, GHashTable *index)
+{
+    g_autoptr(GFile) file = store_cache_get_file (cache, "search-index", "snaps", FALSE);
+    if (file == NULL)
+        return FALSE;
+
+    g_autofree gchar *path = g_file_get_path (file);
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    if (!json_parser_load_from_file (parser, path, NULL))
+        return FALSE;
+
+    JsonNode *root = json_parser_get_root (parser);
+    if (root == NULL || !JSON_NODE_HOLDS_OBJECT (root))
+        return FALSE;
+    JsonObject *object = json_node_get_object (root);
+    if (!has_member_of_type (object, "version", JSON_NODE_VALUE) || json_object_get_int_member (object, "version") != SEARCH_INDEX_VERSION ||
+        !has_member_of_type (object, "snaps", JSON_NODE_ARRAY))
+        return FALSE;
+
+    JsonArray *snaps = json_object_get_array_member (object, "snaps");
+    for (guint i = 0; i < json_array_get_length (snaps); i++) {
+        SearchEntry *entry = search_entry_new_from_json (json_array_get_element (snaps, i));
+        if (entry != NULL)
+            add_search_entry (index, entry);
+    }
+
+    return TRUE;
+}
+
+static void
+load_search_index_data_free (LoadSearchIndexData *data)
+{
+    g_clear_object (&data->cache);
+    g_free (data);
+}
+
+/* Only the file helpers of the cache are used here, they don't touch its stats so are safe from a worker */
+static void
+load_search_index_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable)
+{
+    LoadSearchIndexData *data = task_data;
+
+    g_autoptr(GHashTable) index = search_index_new ();
+    if (read_search_index (data->cache, index)) {
+        g_task_return_pointer (task, g_steal_pointer (&index), (GDestroyNotify) g_hash_table_unref);
+        return;
+    }
+
+    /* No usable index, so build one from the cached snaps */
+    g_hash_table_remove_all (index);
+    data->rebuilt = TRUE;
+    g_autoptr(GError) error = NULL;
+    g_auto(GStrv) names = store_cache_list_sync (data->cache, "snaps", cancellable, &error);
+    if (names == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+    for (int i = 0; names[i] != NULL; i++) {
+        g_autoptr(GFile) file = store_cache_get_file (data->cache, "snaps", names[i], FALSE);
+        if (file != NULL)
+            add_search_entry_from_file (index, file);
+    }
+
+    g_task_return_pointer (task, g_steal_pointer (&index), (GDestroyNotify) g_hash_table_unref);
+}
+
+static void
+save_search_index (StoreModel *self)
+{
+    if (self->cache == NULL || self->search_index == NULL)
+        return;
+
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "version");
+    json_builder_add_int_value (builder, SEARCH_INDEX_VERSION);
+    json_builder_set_member_name (builder, "snaps");
+    json_builder_begin_array (builder);
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, self->search_index);
+    SearchEntry *entry;
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "name");
+        json_builder_add_string_value (builder, entry->name);
+        if (entry->title != NULL) {
+            json_builder_set_member_name (builder, "title");
+            json_builder_add_string_value (builder, entry->title);
+        }
+        if (entry->summary != NULL) {
+            json_builder_set_member_name (builder, "summary");
+            json_builder_add_string_value (builder, entry->summary);
+        }
+        if (entry->icon_uri != NULL) {
+            json_builder_set_member_name (builder, "icon");
+            json_builder_begin_object (builder);
+            json_builder_set_member_name (builder, "uri");
+            json_builder_add_string_value (builder, entry->icon_uri);
+            json_builder_end_object (builder);
+        }
+        json_builder_end_object (builder);
+    }
+    json_builder_end_array (builder);
+    json_builder_end_object (builder);
+
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    store_cache_insert_json (self->cache, "search-index", "snaps", FALSE, root, NULL, NULL);
+}
+
+static gboolean
+search_index_cb (StoreModel *self)
+{
+    self->search_index_source = 0;
+    save_search_index (self);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+schedule_search_index_save (StoreModel *self)
+{
+    if (self->cache == NULL || self->search_index_source != 0)
+        return;
+
+    self->search_index_source = g_timeout_add_seconds (SNAPSHOT_DELAY, (GSourceFunc) search_index_cb, self);
+}
+
+static gboolean
+search_entry_matches (SearchEntry *entry, GStrv terms)
+{
+    for (int i = 0; terms[i] != NULL; i++) {
+        if (g_strstr_len (entry->keywords, -1, terms[i]) == NULL)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gint
+compare_search_entries (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    SearchEntry *entry_a = *((SearchEntry **) a);
+    SearchEntry *entry_b = *((SearchEntry **) b);
+    const gchar *term = user_data;
+
+    /* Snaps whose name starts with the first term come first */
+    gboolean prefix_a = g_str_has_prefix (entry_a->name, term);
+    gboolean prefix_b = g_str_has_prefix (entry_b->name, term);
+    if (prefix_a != prefix_b)
+        return prefix_a ? -1 : 1;
+
+    return g_strcmp0 (entry_a->name, entry_b->name);
+}
+
+/* Snaps not already in memory aren't added to the model, so searching doesn't keep them loaded */
+static StoreApp *
+search_entry_to_app (StoreModel *self, SearchEntry *entry)
+{
+    StoreApp *app = g_hash_table_lookup (self->snaps, entry->name);
+    if (app != NULL)
+        return g_object_ref (app);
+
+    app = STORE_APP (store_snap_app_new ());
+    store_app_set_name (app, entry->name);
+    store_app_set_title (app, entry->title);
+    store_app_set_summary (app, entry->summary);
+    if (entry->icon_uri != NULL) {
+        g_autoptr(StoreMedia) icon = store_media_new ();
+        store_media_set_uri (icon, entry->icon_uri);
+        store_app_set_icon (app, icon);
+    }
+
+    return app;
+}
+
+static void
+return_search_results (StoreModel *self, GTask *task)
+{
+    GStrv terms = g_task_get_task_data (task);
+
+    g_autoptr(GPtrArray) entries = g_ptr_array_new ();
+    if (terms[0] != NULL) {
+        GHashTableIter iter;
+        g_hash_table_iter_init (&iter, self->search_index);
+        SearchEntry *entry;
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+            if (search_entry_matches (entry, terms))
+                g_ptr_array_add (entries, entry);
+        }
+        g_ptr_array_sort_with_data (entries, compare_search_entries, terms[0]);
+    }
+
+    GPtrArray *apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < entries->len; i++)
+        g_ptr_array_add (apps, search_entry_to_app (self, g_ptr_array_index (entries, i)));
+    g_task_return_pointer (task, apps, (GDestroyNotify) g_ptr_array_unref);
+}
+
+static void
+search_index_loaded_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    StoreModel *self = STORE_MODEL (object);
+    LoadSearchIndexData *data = g_task_get_task_data (G_TASK (result));
+
+    self->search_index_loading = FALSE;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GHashTable) index = g_task_propagate_pointer (G_TASK (result), &error);
+    if (index == NULL) {
+        g_warning ("Failed to load search index: %s", error->message);
+        index = search_index_new ();
+    }
+
+    /* Snaps saved while loading are newer than what was read */
+    gboolean changed = data->rebuilt || g_hash_table_size (self->search_index_updates) > 0;
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, self->search_index_updates);
+    SearchEntry *entry;
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry)) {
+        g_hash_table_iter_steal (&iter);
+        add_search_entry (index, entry);
+    }
+    g_clear_pointer (&self->search_index, g_hash_table_unref);
+    self->search_index = g_steal_pointer (&index);
+    if (changed)
+        schedule_search_index_save (self);
+
+    g_autoptr(GPtrArray) tasks = g_steal_pointer (&self->search_tasks);
+    self->search_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < tasks->len; i++)
+        return_search_results (self, g_ptr_array_index (tasks, i));
+}
+
+/* Read off the main loop, the first time it is needed */
+static void
+load_search_index (StoreModel *self)
+{
+    if (self->search_index != NULL || self->search_index_loading)
+        return;
+
+    if (self->cache == NULL) {
+        self->search_index = search_index_new ();
+        return;
+    }
+
+    self->search_index_loading = TRUE;
+    LoadSearchIndexData *data = g_new0 (LoadSearchIndexData, 1);
+    data->cache = g_object_ref (self->cache);
+    g_autoptr(GTask) task = g_task_new (self, NULL, search_index_loaded_cb, NULL);
+    store_trace_task (task, "model", "load-search-index", NULL);
+    g_task_set_task_data (task, data, (GDestroyNotify) load_search_index_data_free);
+    g_task_run_in_thread (task, load_search_index_thread);
+}
+
+static void
+update_search_index (StoreModel *self, StoreApp *app)
+{
+    if (store_app_get_name (app) == NULL)
+        return;
+
+    StoreMedia *icon = store_app_get_icon (app);
+    SearchEntry *entry = search_entry_new (store_app_get_name (app), store_app_get_title (app), store_app_get_summary (app),
+                                           icon != NULL ? store_media_get_uri (icon) : NULL);
+
+    /* Kept until the index is loaded, so saving it never drops snaps */
+    if (self->search_index == NULL) {
+        add_search_entry (self->search_index_updates, entry);
+        load_search_index (self);
+        return;
+    }
+
+    SearchEntry *old_entry = g_hash_table_lookup (self->search_index, entry->name);
+    if (old_entry != NULL && search_entry_equal (old_entry, entry)) {
+        search_entry_free (entry);
+        return;
+    }
+    add_search_entry (self->search_index, entry);
+    schedule_search_index_save (self);
+}
+
+static gboolean
+is_in_categories (StoreModel *self, StoreApp *app)
+{
+    for (guint i = 0; i < self->categories->len; i++) {
+        GPtrArray *apps = store_category_get_apps (g_ptr_array_index (self->categories, i));
+        if (apps != NULL && g_ptr_array_find (apps, app, NULL))
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+static void
+save_app (StoreModel *self, StoreApp *app)
+{
+    if (self->cache == NULL)
+        return;
+
+    store_app_save_to_cache (app, self->cache);
+    update_search_index (self, app);
+
+    /* Keep the snapshot in step with the individual files, it is loaded in preference to them */
+    if (is_in_categories (self, app))
+        schedule_snapshot (self);
+}
+
+StoreCategory *
+find_category (StoreModel *self, const gchar *section_name)
+{
+    for (guint i = 0; i < self->categories->len; i++) {
+        StoreCategory *category = g_ptr_array_index (self->categories, i);
+        if (g_strcmp0 (store_category_get_name (category), section_name) == 0)
+            return category;
+    }
+
+    return NULL;
+}
+
+/* Updating categories completes once the contents of every section have been fetched (or failed),
+ * and only fails if none of them could be */
+static void
+complete_section (GTask *task, GError *error)
+{
+    UpdateCategoriesData *data = g_task_get_task_data (task);
+
+    data->n_pending--;
+    if (error == NULL)
+        data->n_updated++;
+    else if (data->error == NULL)
+        data->error = g_error_copy (error);
+    if (data->n_pending > 0)
+        return;
+
+    if (data->n_updated > 0)
+        g_task_return_boolean (task, TRUE);
+    else
+        g_task_return_error (task, g_steal_pointer (&data->error));
+}
+
+static void
+get_category_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(FindSectionData) data = user_data;
+    StoreModel *self = data->self;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) snaps = snapd_client_find_section_finish (SNAPD_CLIENT (object), result, NULL, &error);
+    store_trace_end_async (data->trace_start, "snapd", "find-section", data->section_name);
+    if (snaps == NULL) {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_warning ("Failed to find snaps in category: %s", error->message);
+        complete_section (data->task, error);
+        return;
+    }
+
+    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < snaps->len; i++) {
+        SnapdSnap *snap = g_ptr_array_index (snaps, i);
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
+        store_snap_app_update_from_search (app, snap);
+        save_app (self, STORE_APP (app));
+        g_ptr_array_add (apps, g_steal_pointer (&app));
+    }
+
+    StoreCategory *category = find_category (self, data->section_name);
+    if (category != NULL) {
+        store_category_set_apps (category, apps);
+        schedule_snapshot (self);
+    }
+
+    /* Save in cache */
+    if (self->cache != NULL) {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+        json_builder_begin_array (builder);
+        for (guint i = 0; i < snaps->len; i++) {
+            SnapdSnap *snap = g_ptr_array_index (snaps, i);
+            json_builder_add_string_value (builder, snapd_snap_get_name (snap));
+        }
+        json_builder_end_array (builder);
+        g_autoptr(JsonNode) root = json_builder_get_root (builder);
+        store_cache_insert_json (self->cache, "sections", data->section_name, FALSE, root, NULL, NULL);
+    }
+
+    complete_section (data->task, NULL);
+}
+
+static void
+get_sections_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_auto(GStrv) sections = snapd_client_get_sections_finish (SNAPD_CLIENT (object), result, &error);
+    if (sections == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+
+    g_clear_pointer (&self->categories, g_ptr_array_unref);
+    self->categories = g_ptr_array_new_with_free_func (g_object_unref);
+    UpdateCategoriesData *data = g_new0 (UpdateCategoriesData, 1);
+    data->n_pending = g_strv_length (sections);
+    g_task_set_task_data (task, data, (GDestroyNotify) update_categories_data_free);
+    for (int i = 0; sections[i] != NULL; i++) {
+        StoreCategory *category = store_category_new ();
+        g_ptr_array_add (self->categories, category);
+        store_category_set_name (category, sections[i]);
+        store_category_set_title (category, get_section_title (sections[i]));
+        store_category_set_summary (category, get_section_summary (sections[i]));
+
+        g_autoptr(GPtrArray) apps = load_cached_category_apps (self, sections[i]);
+        store_category_set_apps (category, apps);
+
+        g_autoptr(SnapdClient) client = snapd_client_new ();
+        snapd_client_set_socket_path (client, self->snapd_socket_path);
+        snapd_client_find_section_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, sections[i], NULL, g_task_get_cancellable (task), get_category_snaps_cb, find_section_data_new (task, sections[i]));
+    }
+
+    /* Save in cache */
+    if (self->cache != NULL) {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+        json_builder_begin_array (builder);
+        for (int i = 0; sections[i] != NULL; i++)
+            json_builder_add_string_value (builder, sections[i]);
+        json_builder_end_array (builder);
+        g_autoptr(JsonNode) root = json_builder_get_root (builder);
+        store_cache_insert_json (self->cache, "sections", "_index", FALSE, root, NULL, NULL);
+    }
+
+    g_object_notify (G_OBJECT (self), "categories");
+
+    if (data->n_pending == 0)
+        g_task_return_boolean (task, TRUE);
+}
+
+static void
+update_installed_snaps (StoreModel *self, GPtrArray *snaps, GStrv names)
+{
+    gboolean changed = FALSE;
+
+    g_autoptr(GHashTable) installed_names = g_hash_table_new (g_str_hash, g_str_equal);
+    for (guint i = 0; i < snaps->len; i++) {
+        SnapdSnap *snap = g_ptr_array_index (snaps, i);
+        g_hash_table_add (installed_names, (gpointer) snapd_snap_get_name (snap));
+
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
+        gboolean was_installed = store_app_get_installed (STORE_APP (app));
+        g_autofree gchar *old_version = g_strdup (store_app_get_version (STORE_APP (app)));
+        store_app_begin_update (STORE_APP (app));
+        store_app_set_installed (STORE_APP (app), TRUE);
+        store_snap_app_update_from_search (app, snap);
+        store_app_end_update (STORE_APP (app));
+
+        /* Only write to the cache if something is likely to have changed */
+        if (!was_installed || g_strcmp0 (old_version, store_app_get_version (STORE_APP (app))) != 0)
+            save_app (self, STORE_APP (app));
+
+        if (!g_ptr_array_find (self->installed, app, NULL)) {
+            g_ptr_array_add (self->installed, g_object_ref (app));
+            changed = TRUE;
+        }
+    }
+
+    /* Remove snaps that are no longer installed, only checking the requested ones if filtered */
+    for (guint i = self->installed->len; i > 0; i--) {
+        StoreApp *app = g_ptr_array_index (self->installed, i - 1);
+        const gchar *name = store_app_get_name (app);
+        if (g_hash_table_contains (installed_names, name))
+            continue;
+        if (names != NULL && !g_strv_contains ((const gchar * const *) names, name))
+            continue;
+
+        store_app_set_installed (app, FALSE);
+        g_ptr_array_remove_index (self->installed, i - 1);
+        changed = TRUE;
+    }
+
+    if (changed)
+        g_object_notify (G_OBJECT (self), "installed");
+}
+
+static void
+get_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) snaps = snapd_client_get_snaps_finish (SNAPD_CLIENT (object), result, &error);
+    if (snaps == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    GStrv names = g_task_get_task_data (task);
+
+    update_installed_snaps (self, snaps, names);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_odrs_client_update_ratings_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+
+    /* Update existing apps */
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, self->snaps);
+    gpointer key, value;
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        StoreSnapApp *snap = value;
+        gint64 *ratings = store_odrs_client_get_ratings (self->odrs_client, store_app_get_appstream_id (STORE_APP (snap)));
+        store_app_set_review_counts (STORE_APP (snap), ratings);
+    }
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autofree gchar *user_skey = NULL;
+    g_autoptr(GPtrArray) reviews = store_odrs_client_get_reviews_finish (STORE_ODRS_CLIENT (object), result, &user_skey, &error);
+    if (reviews == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    StoreApp *app = g_task_get_task_data (task);
+
+    store_app_set_reviews (app, reviews);
+    store_app_set_review_key (app, user_skey); // FIXME: cache?
+
+    cache_reviews (self, app);
+    save_app (self, app);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+downvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_odrs_client_downvote_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    FeedbackData *data = g_task_get_task_data (task);
+
+    store_odrs_review_set_voted (data->review, TRUE);
+    cache_reviews (self, data->app);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+report_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_odrs_client_report_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    FeedbackData *data = g_task_get_task_data (task);
+
+    store_odrs_review_set_voted (data->review, TRUE);
+    cache_reviews (self, data->app);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+upvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_odrs_client_upvote_finish (STORE_ODRS_CLIENT (object), result, &error)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    FeedbackData *data = g_task_get_task_data (task);
+
+    store_odrs_review_set_voted (data->review, TRUE);
+    cache_reviews (self, data->app);
+
+    g_task_return_boolean (task, TRUE);
+}
+
+static void
+image_size_cb (GetImageData *data, gint width, gint height, GdkPixbufLoader *loader)
+{
+    data->orig_width = width;
+    data->orig_height = height;
+
+    if (data->width == 0 && data->height == 0)
+        return;
+
+    /* Fit inside the requested size, a zero dimension is scaled to keep the aspect ratio */
+    gint w, h;
+    if (data->height == 0 || (data->width != 0 && width * data->height > height * data->width)) {
+        w = data->width;
+        h = height * data->width / width;
+    }
+    else {
+        h = data->height;
+        w = width * data->height / height;
+    }
+
+    /* Only scale down, drawing scales to the allocated size anyway */
+    if (w >= width || h >= height)
+        return;
+
+    gdk_pixbuf_loader_set_size (loader, w, h);
+}
+
+static GdkPixbuf *
+process_image (GetImageData *image_data, GBytes *data, GError **error)
+{
+    gint64 trace_start = store_trace_begin ();
+
+    g_autoptr(GdkPixbufLoader) loader = gdk_pixbuf_loader_new ();
+
+    g_signal_connect_swapped (loader, "size-prepared", G_CALLBACK (image_size_cb), image_data);
+
+    gboolean result = gdk_pixbuf_loader_write_bytes (loader, data, error) &&
+                      gdk_pixbuf_loader_close (loader, error);
+
+    store_trace_end (trace_start, "image", "decode", image_data->uri);
+
+    if (!result)
+        return NULL;
+
+    return g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+}
+
+/* Thumbnails are keyed by size, so one made from a new copy of the original replaces the old one.
+ * The ETag of the original it was made from is kept in the thumbnail metadata */
+static gchar *
+get_thumbnail_name (GetImageData *image_data)
+{
+    return g_strdup_printf ("%s@%dx%d", image_data->uri, image_data->width, image_data->height);
+}
+
+typedef struct
+{
+    gchar *name;
+    gchar *etag;
+} ThumbnailData;
+
+static void
+thumbnail_data_free (ThumbnailData *data)
+{
+    g_free (data->name);
+    g_free (data->etag);
+    g_free (data);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (ThumbnailData, thumbnail_data_free)
+
+static void
+encode_thumbnail_thread (GTask *task, gpointer source_object G_GNUC_UNUSED, gpointer task_data, GCancellable *cancellable G_GNUC_UNUSED)
+{
+    GdkPixbuf *pixbuf = task_data;
+
+    gint64 trace_start = store_trace_begin ();
+    gchar *buffer;
+    gsize buffer_length;
+    g_autoptr(GError) error = NULL;
+    gboolean result = gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_length, "png", &error, NULL);
+    store_trace_end (trace_start, "image", "encode", NULL);
+    if (!result) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    g_task_return_pointer (task, g_bytes_new_take (buffer, buffer_length), (GDestroyNotify) g_bytes_unref);
+}
+
+static void
+encode_thumbnail_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    StoreModel *self = STORE_MODEL (object);
+    g_autoptr(ThumbnailData) thumbnail_data = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GBytes) data = g_task_propagate_pointer (G_TASK (result), &error);
+    if (data == NULL) {
+        g_warning ("Failed to encode thumbnail: %s", error->message);
+        return;
+    }
+
+    if (self->cache == NULL)
+        return;
+
+    /* Image first, so if interrupted the metadata doesn't match and the thumbnail is made again */
+    if (!store_cache_insert (self->cache, "thumbnails", thumbnail_data->name, TRUE, data, NULL, NULL))
+        return;
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "etag");
+    json_builder_add_string_value (builder, thumbnail_data->etag);
+    json_builder_end_object (builder);
+    g_autoptr(JsonNode) root = json_builder_get_root (builder);
+    store_cache_insert_json (self->cache, "thumbnail-metadata", thumbnail_data->name, TRUE, root, NULL, NULL);
+}
+
+static void
+cache_thumbnail (StoreModel *self, GetImageData *image_data, GdkPixbuf *pixbuf)
+{
+    if (self->cache == NULL)
+        return;
+
+    /* Without an ETag there is no way to tell when the thumbnail is out of date */
+    if (image_data->etag == NULL)
+        return;
+
+    if (image_data->orig_width < gdk_pixbuf_get_width (pixbuf) * THUMBNAIL_SCALE ||
+        image_data->orig_height < gdk_pixbuf_get_height (pixbuf) * THUMBNAIL_SCALE)
+        return;
+
+    /* Encoding costs more than the decode it saves, so keep it off the main thread */
+    ThumbnailData *thumbnail_data = g_new0 (ThumbnailData, 1);
+    thumbnail_data->name = get_thumbnail_name (image_data);
+    thumbnail_data->etag = g_strdup (image_data->etag);
+    g_autoptr(GTask) task = g_task_new (self, NULL, encode_thumbnail_cb, thumbnail_data);
+    g_task_set_task_data (task, g_object_ref (pixbuf), g_object_unref);
+    g_task_run_in_thread (task, encode_thumbnail_thread);
+}
+
+static void
+cached_image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GBytes) data = store_cache_lookup_finish (STORE_CACHE (object), result, &error);
+    if (data == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+    GetImageData *image_data = g_task_get_task_data (task);
+
+    g_autoptr(GdkPixbuf) pixbuf = process_image (image_data, data, &error);
+    if (pixbuf == NULL) {
         g_task_return_error (task, g_steal_pointer (&error));
         return;
     }
 
+    /* Thumbnail may be missing if the original was cached before thumbnails were supported */
+    cache_thumbnail (self, image_data, pixbuf);
+
+    g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+}
+
+static void
+lookup_original_image (GTask *task)
+{
     StoreModel *self = g_task_get_source_object (task);
-    FeedbackData *data = g_task_get_task_data (task);
+    GetImageData *image_data = g_task_get_task_data (task);
+    store_cache_lookup_async (self->cache, "images", image_data->uri, TRUE, g_task_get_cancellable (task), cached_image_cb, task);
+}
 
-    store_odrs_review_set_voted (data->review, TRUE);
-    cache_reviews (self, data->app);
+static void
+cached_thumbnail_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    GetImageData *image_data = g_task_get_task_data (task);
+
+    /* Fall back to the original */
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GBytes) data = store_cache_lookup_finish (STORE_CACHE (object), result, &error);
+    if (data == NULL) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_task_return_error (task, g_steal_pointer (&error));
+            return;
+        }
+        lookup_original_image (g_steal_pointer (&task));
+        return;
+    }
+
+    g_autoptr(GdkPixbuf) pixbuf = process_image (image_data, data, &error);
+    if (pixbuf == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+}
+
+static gboolean
+thumbnail_metadata_matches (GBytes *data, const gchar *etag)
+{
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    if (!json_parser_load_from_data (parser, g_bytes_get_data (data, NULL), g_bytes_get_size (data), NULL))
+        return FALSE;
+
+    JsonNode *root = json_parser_get_root (parser);
+    if (root == NULL || json_node_get_node_type (root) != JSON_NODE_OBJECT)
+        return FALSE;
+    JsonObject *object = json_node_get_object (root);
+    return has_member_of_type (object, "etag", JSON_NODE_VALUE) && g_strcmp0 (json_object_get_string_member (object, "etag"), etag) == 0;
+}
+
+/* Only use a thumbnail made from the copy of the original we have */
+static void
+cached_thumbnail_metadata_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    GetImageData *image_data = g_task_get_task_data (task);
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GBytes) data = store_cache_lookup_finish (STORE_CACHE (object), result, &error);
+    if (data == NULL && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+    if (data == NULL || !thumbnail_metadata_matches (data, image_data->etag)) {
+        lookup_original_image (g_steal_pointer (&task));
+        return;
+    }
+
+    g_autofree gchar *thumbnail_name = get_thumbnail_name (image_data);
+    store_cache_lookup_async (STORE_CACHE (object), "thumbnails", thumbnail_name, TRUE, g_task_get_cancellable (task), cached_thumbnail_cb, g_steal_pointer (&task));
+}
+
+static StoreMediaPolicy
+get_automatic_media_policy (StoreModel *self)
+{
+    GNetworkMonitor *monitor = g_network_monitor_get_default ();
+    return store_media_policy_for_network (g_network_monitor_get_connectivity (monitor), g_network_monitor_get_network_metered (monitor), self->throughput);
+}
+
+static void
+update_media_policy (StoreModel *self)
+{
+    StoreMediaPolicy policy = self->media_policy_override;
+    if (policy == STORE_MEDIA_POLICY_AUTOMATIC)
+        policy = get_automatic_media_policy (self);
+
+    if (policy == self->media_policy)
+        return;
+
+    self->media_policy = policy;
+    g_object_notify (G_OBJECT (self), "media-policy");
+}
+
+static gboolean
+throughput_expired_cb (StoreModel *self)
+{
+    self->throughput_expiry_source = 0;
+    self->throughput = 0;
+    update_media_policy (self);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void
+add_throughput_sample (StoreModel *self, gdouble throughput)
+{
+    /* Smooth out so a single slow window doesn't change the policy */
+    if (self->throughput == 0)
+        self->throughput = throughput;
+    else
+        self->throughput = 0.75 * self->throughput + 0.25 * throughput;
+
+    g_clear_handle_id (&self->throughput_expiry_source, g_source_remove);
+    self->throughput_expiry_source = g_timeout_add_seconds (THROUGHPUT_LIFETIME, (GSourceFunc) throughput_expired_cb, self);
+
+    update_media_policy (self);
+}
+
+static gint64
+get_throughput_busy_time (StoreModel *self, gint64 now)
+{
+    gint64 busy_time = self->throughput_busy_time;
+    if (self->n_active_transfers > 0)
+        busy_time += now - self->throughput_busy_start;
+    return busy_time;
+}
+
+/* Count bytes received by any download, taking a sample each time a window is complete */
+static void
+add_throughput_bytes (StoreModel *self, gsize n_bytes)
+{
+    self->throughput_bytes += n_bytes;
+
+    gint64 now = g_get_monotonic_time ();
+    gint64 busy_time = get_throughput_busy_time (self, now);
+    if (busy_time < THROUGHPUT_WINDOW || self->throughput_bytes < MIN_THROUGHPUT_SAMPLE)
+        return;
+
+    gdouble throughput = self->throughput_bytes * (gdouble) G_USEC_PER_SEC / busy_time;
+    self->throughput_bytes = 0;
+    self->throughput_busy_time = 0;
+    self->throughput_busy_start = now;
+    add_throughput_sample (self, throughput);
+}
+
+static void
+start_transfer (StoreModel *self)
+{
+    if (self->n_active_transfers == 0)
+        self->throughput_busy_start = g_get_monotonic_time ();
+    self->n_active_transfers++;
+}
+
+static void
+end_transfer (StoreModel *self)
+{
+    self->n_active_transfers--;
+    if (self->n_active_transfers == 0)
+        self->throughput_busy_time += g_get_monotonic_time () - self->throughput_busy_start;
+}
+
+static gboolean
+is_image_data (GBytes *data)
+{
+    gsize data_length;
+    const guchar *contents = g_bytes_get_data (data, &data_length);
+    g_autofree gchar *content_type = g_content_type_guess (NULL, contents, data_length, NULL);
+    g_autofree gchar *mime_type = g_content_type_get_mime_type (content_type);
+    return mime_type != NULL && g_str_has_prefix (mime_type, "image/");
+}
+
+static void
+read_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GBytes) data = g_input_stream_read_bytes_finish (G_INPUT_STREAM (object), result, &error);
+    StoreModel *self = g_task_get_source_object (task);
+    GetImageData *image_data = g_task_get_task_data (task);
+    if (data == NULL) {
+        end_transfer (self);
+        self->image_stats.errors++;
+        store_stats_add_latency (&self->image_stats, image_data->start);
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    g_byte_array_append (image_data->buffer, g_bytes_get_data (data, NULL), g_bytes_get_size (data));
+    add_throughput_bytes (self, g_bytes_get_size (data));
+
+    /* Read until EOF */
+    if (g_bytes_get_size (data) != 0) {
+        GCancellable *cancellable = g_task_get_cancellable (task);
+        g_input_stream_read_bytes_async (G_INPUT_STREAM (object), 65535, G_PRIORITY_DEFAULT, cancellable, read_cb, g_steal_pointer (&task));
+        return;
+    }
+
+    end_transfer (self);
+    self->image_stats.misses++;
+    self->image_stats.bytes_read += image_data->buffer->len;
+    store_stats_add_latency (&self->image_stats, image_data->start);
+
+    g_autoptr(GBytes) full_data = g_bytes_new_static (image_data->buffer->data, image_data->buffer->len);
+    g_autoptr(GdkPixbuf) pixbuf = NULL;
+    if (image_data->decode) {
+        pixbuf = process_image (image_data, full_data, &error);
+        if (pixbuf == NULL) {
+            g_task_return_error (task, g_steal_pointer (&error));
+            return;
+        }
+    }
+    else if (!is_image_data (full_data)) {
+        /* Not decoded, but don't cache something that obviously isn't an image */
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Downloaded data for %s is not an image", image_data->uri);
+        return;
+    }
+
+    /* Save in cache */
+    if (self->cache != NULL) {
+        g_autoptr(JsonBuilder) builder = json_builder_new ();
+        json_builder_begin_object (builder);
+        json_builder_set_member_name (builder, "uri");
+        json_builder_add_string_value (builder, image_data->uri);
+        if (pixbuf != NULL) {
+            json_builder_set_member_name (builder, "width");
+            json_builder_add_int_value (builder, image_data->orig_width);
+            json_builder_set_member_name (builder, "height");
+            json_builder_add_int_value (builder, image_data->orig_height);
+        }
+        g_free (image_data->etag);
+        image_data->etag = g_strdup (soup_message_headers_get_one (image_data->message->response_headers, "ETag"));
+        if (image_data->etag != NULL) {
+            json_builder_set_member_name (builder, "etag");
+            json_builder_add_string_value (builder, image_data->etag);
+        }
+        const gchar *cache_control = soup_message_headers_get_one (image_data->message->response_headers, "Cache-Control");
+        if (cache_control != NULL) {
+            g_autoptr(GHashTable) params = soup_header_parse_param_list (cache_control);
+            const gchar *max_age = g_hash_table_lookup (params, "max-age");
+            if (max_age != NULL) {
+                json_builder_set_member_name (builder, "max-age");
+                json_builder_add_int_value (builder, g_ascii_strtoull (max_age, NULL, 10));
+            }
+        }
+        json_builder_end_object (builder);
+        g_autoptr(JsonNode) root = json_builder_get_root (builder);
+        store_cache_insert_json (self->cache, "image-metadata", image_data->uri, TRUE, root, g_task_get_cancellable (task), NULL);
+        store_cache_insert (self->cache, "images", image_data->uri, TRUE, full_data, g_task_get_cancellable (task), NULL);
+        if (pixbuf != NULL)
+            cache_thumbnail (self, image_data, pixbuf);
+    }
+
+    if (pixbuf == NULL)
+        g_task_return_boolean (task, TRUE);
+    else
+        g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+}
+
+static void
+send_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GInputStream) stream = soup_session_send_finish (SOUP_SESSION (object), result, &error);
+    StoreModel *self = g_task_get_source_object (task);
+    GetImageData *image_data = g_task_get_task_data (task);
+    if (stream == NULL) {
+        self->image_stats.errors++;
+        store_stats_add_latency (&self->image_stats, image_data->start);
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    SoupMessage *msg = image_data->message;
+
+    /* A revalidated image counts as a hit, a downloaded one as a miss */
+    if (msg->status_code == SOUP_STATUS_NOT_MODIFIED) {
+        self->image_stats.hits++;
+        store_stats_add_latency (&self->image_stats, image_data->start);
+        g_task_return_new_error (task, STORE_MODEL_ERROR, STORE_MODEL_ERROR_NOT_MODIFIED, "Cached copy of %s is up to date", image_data->uri);
+        return;
+    }
+    if (msg->status_code != SOUP_STATUS_OK) {
+        self->image_stats.errors++;
+        store_stats_add_latency (&self->image_stats, image_data->start);
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Server returned status code %d", msg->status_code);
+        return;
+    }
+
+    start_transfer (self);
+    GCancellable *cancellable = g_task_get_cancellable (task);
+    g_input_stream_read_bytes_async (stream, 65535, G_PRIORITY_DEFAULT, cancellable, read_cb, g_steal_pointer (&task));
+}
+
+static guint
+get_host_requests (StoreModel *self, const gchar *host)
+{
+    return GPOINTER_TO_UINT (g_hash_table_lookup (self->image_host_requests, host));
+}
+
+static guint
+get_host_limit (StoreImagePriority priority)
+{
+    return priority == STORE_IMAGE_PRIORITY_PREFETCH ? MAX_PREFETCH_IMAGES_PER_HOST : MAX_CONNS_PER_HOST;
+}
+
+static void dispatch_images (StoreModel *self);
+
+static void
+image_request_completed_cb (GTask *task, GParamSpec *pspec G_GNUC_UNUSED, StoreModel *self)
+{
+    if (!g_task_get_completed (task) || self->image_host_requests == NULL)
+        return;
+
+    GetImageData *image_data = g_task_get_task_data (task);
+    g_hash_table_insert (self->image_host_requests, g_strdup (image_data->host), GUINT_TO_POINTER (get_host_requests (self, image_data->host) - 1));
+    dispatch_images (self);
+}
+
+static void
+start_image_request (StoreModel *self, GTask *task)
+{
+    GetImageData *image_data = g_task_get_task_data (task);
+    g_hash_table_insert (self->image_host_requests, g_strdup (image_data->host), GUINT_TO_POINTER (get_host_requests (self, image_data->host) + 1));
+    g_signal_connect (task, "notify::completed", G_CALLBACK (image_request_completed_cb), self);
+    soup_session_send_async (self->session, image_data->message, g_task_get_cancellable (task), send_cb, task); // FIXME: Combine cancellables
+}
+
+static void
+unqueue_image (GTask *task)
+{
+    GetImageData *image_data = g_task_get_task_data (task);
+    if (image_data->cancelled_id != 0)
+        g_cancellable_disconnect (g_task_get_cancellable (task), image_data->cancelled_id);
+    image_data->cancelled_id = 0;
+}
+
+/* Start the highest priority requests that have a free connection, oldest first within a priority */
+static void
+dispatch_images (StoreModel *self)
+{
+    if (self->image_queue == NULL)
+        return;
+
+    g_autoptr(GPtrArray) cancelled_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+    while (TRUE) {
+        GList *best = NULL;
+        StoreImagePriority best_priority = STORE_IMAGE_PRIORITY_PREFETCH;
+        GList *link = self->image_queue->head;
+        while (link != NULL) {
+            GList *next = link->next;
+            GTask *task = link->data;
+            GetImageData *image_data = g_task_get_task_data (task);
+            if (g_cancellable_is_cancelled (g_task_get_cancellable (task))) {
+                unqueue_image (task);
+                g_ptr_array_add (cancelled_tasks, task);
+                g_queue_delete_link (self->image_queue, link);
+            }
+            else if (get_host_requests (self, image_data->host) < get_host_limit (image_data->priority) &&
+                     (best == NULL || image_data->priority < best_priority)) {
+                best = link;
+                best_priority = image_data->priority;
+            }
+            link = next;
+        }
+        if (best == NULL)
+            break;
+
+        GTask *task = best->data;
+        g_queue_delete_link (self->image_queue, best);
+        unqueue_image (task);
+        start_image_request (self, task);
+    }
+
+    /* Returned last, as the callbacks may queue more requests */
+    for (guint i = 0; i < cancelled_tasks->len; i++)
+        g_task_return_error_if_cancelled (g_ptr_array_index (cancelled_tasks, i));
+}
+
+static gboolean
+image_cancel_cb (StoreModel *self)
+{
+    self->image_cancel_source = 0;
+    dispatch_images (self);
+    return G_SOURCE_REMOVE;
+}
+
+/* Not handled here, as the cancellable may still be emitting for other requests */
+static void
+image_cancelled_cb (GCancellable *cancellable G_GNUC_UNUSED, StoreModel *self)
+{
+    if (self->image_cancel_source == 0)
+        self->image_cancel_source = g_idle_add ((GSourceFunc) image_cancel_cb, self);
+}
+
+/* Images only downloaded into the cache aren't decoded */
+static void
+queue_image (StoreModel *self, GTask *task, const gchar *uri, const gchar *etag, gint width, gint height, StoreImagePriority priority, gboolean decode)
+{
+    GetImageData *image_data = get_image_data_new (self, uri, width, height);
+    g_task_set_task_data (task, image_data, (GDestroyNotify) get_image_data_free);
+    image_data->message = soup_message_new ("GET", uri);
+    if (image_data->message == NULL) {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Invalid image URI %s", uri);
+        return;
+    }
+    image_data->host = g_strdup (soup_uri_get_host (soup_message_get_uri (image_data->message)));
+    image_data->priority = priority;
+    image_data->decode = decode;
+    if (etag != NULL)
+        soup_message_headers_append (image_data->message->request_headers, "If-None-Match", etag);
+
+    /* Cancelled requests leave the queue straight away, not when a connection next becomes free */
+    GCancellable *cancellable = g_task_get_cancellable (task);
+    if (cancellable != NULL)
+        image_data->cancelled_id = g_cancellable_connect (cancellable, G_CALLBACK (image_cancelled_cb), self, NULL);
+
+    g_queue_push_tail (self->image_queue, g_object_ref (task));
+    dispatch_images (self);
+}
+
+static void
+search_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    g_autoptr(GTask) task = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) snaps = snapd_client_find_finish (SNAPD_CLIENT (object), result, NULL, &error);
+    if (snaps == NULL) {
+        g_task_return_error (task, g_steal_pointer (&error));
+        return;
+    }
+
+    StoreModel *self = g_task_get_source_object (task);
+
+    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < snaps->len; i++) {
+        SnapdSnap *snap = g_ptr_array_index (snaps, i);
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
+        store_snap_app_update_from_search (app, snap);
+        save_app (self, STORE_APP (app));
+        g_ptr_array_add (apps, g_steal_pointer (&app));
+    }
 
-    g_task_return_boolean (task, TRUE);
+    g_task_return_pointer (task, g_steal_pointer (&apps), (GDestroyNotify) g_ptr_array_unref);
 }
 
 static void
-report_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+progress_cb (SnapdClient *client G_GNUC_UNUSED, SnapdChange *change, gpointer deprecated G_GNUC_UNUSED, gpointer user_data)
 {
-    g_autoptr(GTask) task = user_data;
+    StoreModel *self = user_data;
 
-    g_autoptr(GError) error = NULL;
-    if (!store_odrs_client_report_finish (STORE_ODRS_CLIENT (object), result, &error)) {
-        g_task_return_error (task, g_steal_pointer (&error));
-        return;
+    /* Combine all the tasks, the download is counted in bytes so dominates the total */
+    gint64 done = 0, total = 0;
+    const gchar *label = NULL;
+    GPtrArray *tasks = snapd_change_get_tasks (change);
+    for (guint i = 0; i < tasks->len; i++) {
+        SnapdTask *snapd_task = g_ptr_array_index (tasks, i);
+        done += snapd_task_get_progress_done (snapd_task);
+        total += snapd_task_get_progress_total (snapd_task);
+        if (label == NULL && g_strcmp0 (snapd_task_get_status (snapd_task), "Doing") == 0)
+            label = snapd_task_get_summary (snapd_task);
     }
 
-    StoreModel *self = g_task_get_source_object (task);
-    FeedbackData *data = g_task_get_task_data (task);
+    /* Snaps in the same change share its progress */
+    for (guint i = 0; i < self->active_operations->len; i++) {
+        Operation *operation = g_ptr_array_index (self->active_operations, i);
+        StoreProgress *progress = store_app_get_progress (operation->app);
+        if (progress != NULL)
+            store_progress_update (progress, done, total, label != NULL ? label : snapd_change_get_summary (change));
+    }
+}
 
-    store_odrs_review_set_voted (data->review, TRUE);
-    cache_reviews (self, data->app);
+static void
+update_queue_positions (StoreModel *self)
+{
+    gint position = 1;
+    for (GList *link = self->operation_queue->head; link != NULL; link = link->next) {
+        Operation *operation = link->data;
+        if (operation->app != NULL)
+            store_app_set_queue_position (operation->app, position);
+        position++;
+    }
+}
 
-    g_task_return_boolean (task, TRUE);
+static void
+cancel_queued_operation (Operation *operation)
+{
+    operation_disconnect (operation);
+    if (operation->app != NULL)
+        store_app_set_queue_position (operation->app, 0);
+    operation_set_busy (operation, FALSE);
+    operation_set_state (operation, STORE_APP_STATE_IDLE);
+    g_task_return_error_if_cancelled (operation->task);
+    operation_free (operation);
 }
 
 static void
-upvote_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+operation_cancelled_cb (GCancellable *cancellable G_GNUC_UNUSED, Operation *operation)
 {
-    g_autoptr(GTask) task = user_data;
+    StoreModel *self = operation->self;
 
-    g_autoptr(GError) error = NULL;
-    if (!store_odrs_client_upvote_finish (STORE_ODRS_CLIENT (object), result, &error)) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    /* Operations already sent to snapd are cancelled through operation_cancellable */
+    if (!g_queue_remove (self->operation_queue, operation))
         return;
-    }
 
-    StoreModel *self = g_task_get_source_object (task);
-    FeedbackData *data = g_task_get_task_data (task);
+    cancel_queued_operation (operation);
+    update_queue_positions (self);
+}
 
-    store_odrs_review_set_voted (data->review, TRUE);
-    cache_reviews (self, data->app);
+static void
+add_to_queue (StoreModel *self, Operation *operation, gboolean at_head)
+{
+    /* Show as busy straight away */
+    operation_set_busy (operation, TRUE);
+    operation_set_state (operation, STORE_APP_STATE_QUEUED);
 
-    g_task_return_boolean (task, TRUE);
+    GCancellable *cancellable = g_task_get_cancellable (operation->task);
+    if (cancellable != NULL)
+        operation->cancelled_id = g_signal_connect (cancellable, "cancelled", G_CALLBACK (operation_cancelled_cb), operation);
+
+    if (at_head)
+        g_queue_push_head (self->operation_queue, operation);
+    else
+        g_queue_push_tail (self->operation_queue, operation);
+}
+
+/* A refresh-all changes every app being updated */
+static gboolean
+operation_has_app (Operation *operation, StoreApp *app)
+{
+    if (operation->app == app)
+        return TRUE;
+    return app != NULL && operation->apps != NULL && g_ptr_array_find (operation->apps, app, NULL);
+}
+
+static Operation *
+find_operation (StoreModel *self, StoreApp *app)
+{
+    for (guint i = 0; i < self->active_operations->len; i++) {
+        Operation *operation = g_ptr_array_index (self->active_operations, i);
+        if (operation_has_app (operation, app))
+            return operation;
+    }
+    for (GList *link = self->operation_queue->head; link != NULL; link = link->next) {
+        Operation *operation = link->data;
+        if (operation_has_app (operation, app))
+            return operation;
+    }
+
+    return NULL;
 }
 
+static void run_operations (StoreModel *self);
+
 static void
-image_size_cb (GetImageData *data, gint width, gint height, GdkPixbufLoader *loader)
+operation_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    data->orig_width = width;
-    data->orig_height = height;
+    StoreModel *self = user_data;
 
-    if (data->width == 0 || data->height == 0)
-        return;
+    g_autoptr(GPtrArray) operations = g_steal_pointer (&self->active_operations);
+    self->active_operations = g_ptr_array_new_with_free_func ((GDestroyNotify) operation_free);
+    g_clear_object (&self->operation_cancellable);
+    Operation *first = g_ptr_array_index (operations, 0);
 
-    gint w, h;
-    if (width * data->height > height * data->width) {
-        w = data->width;
-        h = height * data->width / width;
+    g_autoptr(GError) error = NULL;
+    gboolean r;
+    if (first->type == OPERATION_INSTALL && operations->len > 1)
+        r = snapd_client_install_multiple_finish (SNAPD_CLIENT (object), result, &error);
+    else if (first->type == OPERATION_INSTALL)
+        r = snapd_client_install2_finish (SNAPD_CLIENT (object), result, &error);
+    else if (operations->len > 1)
+        r = snapd_client_remove_multiple_finish (SNAPD_CLIENT (object), result, &error);
+    else
+        r = snapd_client_remove_finish (SNAPD_CLIENT (object), result, &error);
+
+    gboolean changed = FALSE;
+    g_autoptr(GPtrArray) installed_names = g_ptr_array_new ();
+    g_autoptr(GPtrArray) retry_operations = g_ptr_array_new ();
+    for (guint i = 0; i < operations->len; i++) {
+        Operation *operation = g_ptr_array_index (operations, i);
+
+        /* Another operation in the same change was cancelled, so try again without it */
+        if (!r && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED) && !g_cancellable_is_cancelled (g_task_get_cancellable (operation->task))) {
+            g_ptr_array_add (retry_operations, operation_new (self, operation->type, g_object_ref (operation->task), operation->app, operation->channel));
+            continue;
+        }
+
+        store_app_set_progress (operation->app, NULL);
+        store_app_set_state (operation->app, STORE_APP_STATE_IDLE);
+
+        if (!r) {
+            if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+                g_task_return_error (operation->task, g_error_copy (error));
+            else if (operation->type == OPERATION_INSTALL)
+                g_task_return_new_error (operation->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to install snap: %s", error->message);
+            else
+                g_task_return_new_error (operation->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to remove snap: %s", error->message);
+            continue;
+        }
+
+        if (operation->type == OPERATION_INSTALL) {
+            /* Show as installed straight away, then get the installed details */
+            store_app_set_installed (operation->app, TRUE);
+            if (!g_ptr_array_find (self->installed, operation->app, NULL)) {
+                g_ptr_array_add (self->installed, g_object_ref (operation->app));
+                changed = TRUE;
+            }
+            g_ptr_array_add (installed_names, (gpointer) store_app_get_name (operation->app));
+        }
+        else {
+            store_app_set_installed (operation->app, FALSE);
+            if (g_ptr_array_remove (self->installed, operation->app))
+                changed = TRUE;
+        }
+
+        g_task_return_boolean (operation->task, TRUE);
     }
-    else {
-        h = data->height;
-        w = width * data->height / height;
+
+    if (changed)
+        g_object_notify (G_OBJECT (self), "installed");
+    if (r)
+        self->updates_time = 0;
+
+    if (installed_names->len > 0) {
+        g_ptr_array_add (installed_names, NULL);
+        store_model_update_installed_snaps_async (self, (GStrv) installed_names->pdata, NULL, NULL, NULL);
     }
 
-    gdk_pixbuf_loader_set_size (loader, w, h);
+    for (guint i = retry_operations->len; i > 0; i--)
+        add_to_queue (self, g_ptr_array_index (retry_operations, i - 1), TRUE);
+    update_queue_positions (self);
+
+    run_operations (self);
+    g_object_unref (self);
 }
 
-static GdkPixbuf *
-process_image (GetImageData *image_data, GBytes *data, GError **error)
+static void
+set_updates (StoreModel *self, GPtrArray *updates)
 {
-    g_autoptr(GdkPixbufLoader) loader = gdk_pixbuf_loader_new ();
+    gboolean changed = updates->len != self->updates->len;
+    for (guint i = 0; !changed && i < updates->len; i++)
+        changed = g_ptr_array_index (updates, i) != g_ptr_array_index (self->updates, i);
+    if (!changed)
+        return;
 
-    g_signal_connect_swapped (loader, "size-prepared", G_CALLBACK (image_size_cb), image_data);
+    g_clear_pointer (&self->updates, g_ptr_array_unref);
+    self->updates = g_ptr_array_ref (updates);
+    g_object_notify (G_OBJECT (self), "updates");
+}
 
-    if (!gdk_pixbuf_loader_write_bytes (loader, data, error) ||
-        !gdk_pixbuf_loader_close (loader, error))
-        return NULL;
+static void
+refresh_all_progress_cb (SnapdClient *client G_GNUC_UNUSED, SnapdChange *change, gpointer deprecated G_GNUC_UNUSED, gpointer user_data)
+{
+    Operation *operation = user_data;
 
-    return g_object_ref (gdk_pixbuf_loader_get_pixbuf (loader));
+    gint64 done = 0, total = 0;
+    const gchar *label = NULL;
+    GPtrArray *tasks = snapd_change_get_tasks (change);
+    for (guint i = 0; i < tasks->len; i++) {
+        SnapdTask *snapd_task = g_ptr_array_index (tasks, i);
+        done += snapd_task_get_progress_done (snapd_task);
+        total += snapd_task_get_progress_total (snapd_task);
+        if (label == NULL && g_strcmp0 (snapd_task_get_status (snapd_task), "Doing") == 0)
+            label = snapd_task_get_summary (snapd_task);
+    }
+
+    for (guint i = 0; i < operation->apps->len; i++) {
+        StoreProgress *progress = store_app_get_progress (g_ptr_array_index (operation->apps, i));
+        if (progress != NULL)
+            store_progress_update (progress, done, total, label != NULL ? label : snapd_change_get_summary (change));
+    }
 }
 
 static void
-cached_image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+refresh_all_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    g_autoptr(GTask) task = user_data;
+    StoreModel *self = user_data;
+
+    g_autoptr(GPtrArray) operations = g_steal_pointer (&self->active_operations);
+    self->active_operations = g_ptr_array_new_with_free_func ((GDestroyNotify) operation_free);
+    g_clear_object (&self->operation_cancellable);
+    Operation *operation = g_ptr_array_index (operations, 0);
+
+    operation_set_busy (operation, FALSE);
+    operation_set_state (operation, STORE_APP_STATE_IDLE);
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(GBytes) data = store_cache_lookup_finish (STORE_CACHE (object), result, &error);
-    if (data == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
-        return;
+    g_auto(GStrv) names = snapd_client_refresh_all_finish (SNAPD_CLIENT (object), result, &error);
+    if (names == NULL) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_task_return_error (operation->task, g_steal_pointer (&error));
+        else
+            g_task_return_new_error (operation->task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to update snaps: %s", error->message);
     }
+    else {
+        /* Drop the refreshed snaps from the updates and get their new installed details */
+        self->updates_time = 0;
+        g_autoptr(GPtrArray) updates = g_ptr_array_new_with_free_func (g_object_unref);
+        for (guint i = 0; i < self->updates->len; i++) {
+            StoreApp *app = g_ptr_array_index (self->updates, i);
+            if (!g_strv_contains ((const gchar * const *) names, store_app_get_name (app)))
+                g_ptr_array_add (updates, g_object_ref (app));
+        }
+        set_updates (self, updates);
 
-    GetImageData *image_data = g_task_get_task_data (task);
+        if (names[0] != NULL)
+            store_model_update_installed_snaps_async (self, names, NULL, NULL, NULL);
 
-    g_autoptr(GdkPixbuf) pixbuf = process_image (image_data, data, &error);
-    if (pixbuf == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
-        return;
+        g_task_return_boolean (operation->task, TRUE);
     }
 
-    g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+    run_operations (self);
+    g_object_unref (self);
+}
+
+static Operation *
+pop_operation (StoreModel *self)
+{
+    while (!g_queue_is_empty (self->operation_queue)) {
+        Operation *operation = g_queue_pop_head (self->operation_queue);
+        if (!g_cancellable_is_cancelled (g_task_get_cancellable (operation->task)))
+            return operation;
+        cancel_queued_operation (operation);
+    }
+
+    return NULL;
 }
 
 static void
-read_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+run_operations (StoreModel *self)
 {
-    g_autoptr(GTask) task = user_data;
+    if (self->active_operations->len > 0)
+        return;
 
-    g_autoptr(GError) error = NULL;
-    g_autoptr(GBytes) data = g_input_stream_read_bytes_finish (G_INPUT_STREAM (object), result, &error);
-    if (data == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    Operation *first = pop_operation (self);
+    if (first == NULL)
         return;
-    }
 
-    StoreModel *self = g_task_get_source_object (task);
-    GetImageData *image_data = g_task_get_task_data (task);
+    /* Group with the following operations of the same type so snapd runs them as one change,
+     * stopping at the first different one so they run in the order the user asked for.
+     * Operations on a specific channel can't be grouped */
+    g_ptr_array_add (self->active_operations, first);
+    while (first->channel == NULL && !g_queue_is_empty (self->operation_queue)) {
+        Operation *operation = g_queue_peek_head (self->operation_queue);
+        if (g_cancellable_is_cancelled (g_task_get_cancellable (operation->task))) {
+            cancel_queued_operation (g_queue_pop_head (self->operation_queue));
+            continue;
+        }
+        if (operation->type != first->type || operation->channel != NULL)
+            break;
+        g_ptr_array_add (self->active_operations, g_queue_pop_head (self->operation_queue));
+    }
 
-    g_byte_array_append (image_data->buffer, g_bytes_get_data (data, NULL), g_bytes_get_size (data));
+    /* Cancelling any of the operations cancels the change */
+    self->operation_cancellable = g_cancellable_new ();
+    for (guint i = 0; i < self->active_operations->len; i++) {
+        Operation *operation = g_ptr_array_index (self->active_operations, i);
+        operation_disconnect (operation);
+        GCancellable *cancellable = g_task_get_cancellable (operation->task);
+        if (cancellable != NULL)
+            g_signal_connect_object (cancellable, "cancelled", G_CALLBACK (g_cancellable_cancel), self->operation_cancellable, G_CONNECT_SWAPPED);
+        store_trace_task (operation->task, "snapd", operation_type_to_string (operation->type), operation->app != NULL ? store_app_get_name (operation->app) : NULL);
+        if (operation->app != NULL)
+            store_app_set_queue_position (operation->app, 0);
+        if (operation->type == OPERATION_INSTALL)
+            operation_set_state (operation, STORE_APP_STATE_INSTALLING);
+        else if (operation->type == OPERATION_REMOVE)
+            operation_set_state (operation, STORE_APP_STATE_REMOVING);
+        else
+            operation_set_state (operation, STORE_APP_STATE_UPDATING);
+    }
+    update_queue_positions (self);
 
-    /* Read until EOF */
-    if (g_bytes_get_size (data) != 0) {
-        GCancellable *cancellable = g_task_get_cancellable (task);
-        g_input_stream_read_bytes_async (G_INPUT_STREAM (object), 65535, G_PRIORITY_DEFAULT, cancellable, read_cb, g_steal_pointer (&task));
+    g_autoptr(SnapdClient) client = snapd_client_new ();
+    snapd_client_set_socket_path (client, self->snapd_socket_path);
+    g_object_ref (self);
+    if (first->type == OPERATION_REFRESH_ALL) {
+        snapd_client_refresh_all_async (client, refresh_all_progress_cb, first, self->operation_cancellable, refresh_all_cb, self);
+        return;
+    }
+    if (self->active_operations->len == 1) {
+        if (first->type == OPERATION_INSTALL)
+            snapd_client_install2_async (client, SNAPD_INSTALL_FLAGS_NONE, store_app_get_name (first->app), first->channel, NULL, progress_cb, self, self->operation_cancellable, operation_cb, self);
+        else
+            snapd_client_remove_async (client, store_app_get_name (first->app), progress_cb, self, self->operation_cancellable, operation_cb, self);
         return;
     }
 
-    g_autoptr(GBytes) full_data = g_bytes_new_static (image_data->buffer->data, image_data->buffer->len);
-    g_autoptr(GdkPixbuf) pixbuf = process_image (image_data, full_data, &error);
-    if (pixbuf == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    g_autoptr(GPtrArray) names = g_ptr_array_new ();
+    for (guint i = 0; i < self->active_operations->len; i++) {
+        Operation *operation = g_ptr_array_index (self->active_operations, i);
+        g_ptr_array_add (names, (gpointer) store_app_get_name (operation->app));
+    }
+    g_ptr_array_add (names, NULL);
+    if (first->type == OPERATION_INSTALL)
+        snapd_client_install_multiple_async (client, (GStrv) names->pdata, progress_cb, self, self->operation_cancellable, operation_cb, self);
+    else
+        snapd_client_remove_multiple_async (client, (GStrv) names->pdata, progress_cb, self, self->operation_cancellable, operation_cb, self);
+}
+
+static void
+queue_operation (StoreModel *self, Operation *operation)
+{
+    /* Only one operation per app (or refresh-all), the second one would conflict in snapd.
+     * This includes the apps a queued or running refresh-all is updating */
+    if (find_operation (self, operation->app) != NULL) {
+        g_task_return_new_error (operation->task, G_IO_ERROR, G_IO_ERROR_PENDING, "Operation already in progress");
+        operation_free (operation);
         return;
     }
 
-    /* Save in cache */
-    if (self->cache != NULL) {
-        g_autoptr(JsonBuilder) builder = json_builder_new ();
-        json_builder_begin_object (builder);
-        json_builder_set_member_name (builder, "uri");
-        json_builder_add_string_value (builder, image_data->uri);
-        json_builder_set_member_name (builder, "width");
-        json_builder_add_int_value (builder, image_data->orig_width);
-        json_builder_set_member_name (builder, "height");
-        json_builder_add_int_value (builder, image_data->orig_height);
-        const gchar *etag = soup_message_headers_get_one (image_data->message->response_headers, "ETag");
-        if (etag != NULL) {
-            json_builder_set_member_name (builder, "etag");
-            json_builder_add_string_value (builder, etag);
-        }
-        const gchar *cache_control = soup_message_headers_get_one (image_data->message->response_headers, "Cache-Control");
-        if (cache_control != NULL) {
-            g_autoptr(GHashTable) params = soup_header_parse_param_list (cache_control);
-            const gchar *max_age = g_hash_table_lookup (params, "max-age");
-            if (max_age != NULL) {
-                json_builder_set_member_name (builder, "max-age");
-                json_builder_add_int_value (builder, g_ascii_strtoull (max_age, NULL, 10));
-            }
-        }
-        json_builder_end_object (builder);
-        g_autoptr(JsonNode) root = json_builder_get_root (builder);
-        store_cache_insert_json (self->cache, "image-metadata", image_data->uri, TRUE, root, g_task_get_cancellable (task), NULL);
-        store_cache_insert (self->cache, "images", image_data->uri, TRUE, full_data, g_task_get_cancellable (task), NULL);
+    if (g_task_return_error_if_cancelled (operation->task)) {
+        operation_free (operation);
+        return;
     }
 
-    g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+    add_to_queue (self, operation, FALSE);
+    update_queue_positions (self);
+    run_operations (self);
 }
 
 static void
-send_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+refresh_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(GInputStream) stream = soup_session_send_finish (SOUP_SESSION (object), result, &error);
-    if (stream == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+    g_autoptr(GPtrArray) snaps = snapd_client_find_finish (SNAPD_CLIENT (object), result, NULL, &error);
+    if (snaps == NULL) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to get snap information: %s", error->message);
         return;
     }
 
-    GetImageData *image_data = g_task_get_task_data (task);
-    SoupMessage *msg = image_data->message;
-
-    if (msg->status_code != SOUP_STATUS_OK) {
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Server returned status code %d", msg->status_code); // FIXME: Report 304 errors better
+    if (snaps->len != 1) {
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Snap find returned %d results, expected 1", snaps->len);
         return;
     }
 
-    GCancellable *cancellable = g_task_get_cancellable (task);
-    g_input_stream_read_bytes_async (stream, 65535, G_PRIORITY_DEFAULT, cancellable, read_cb, g_steal_pointer (&task));
+    StoreSnapApp *app = g_task_get_task_data (task);
+    SnapdSnap *snap = g_ptr_array_index (snaps, 0);
+
+    store_snap_app_update_from_search (app, snap);
+    save_app (g_task_get_source_object (task), STORE_APP (app));
+
+    g_task_return_boolean (task, TRUE);
 }
 
 static void
-search_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+find_refreshable_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
     g_autoptr(GTask) task = user_data;
 
     g_autoptr(GError) error = NULL;
-    g_autoptr(GPtrArray) snaps = snapd_client_find_finish (SNAPD_CLIENT (object), result, NULL, &error);
+    g_autoptr(GPtrArray) snaps = snapd_client_find_refreshable_finish (SNAPD_CLIENT (object), result, &error);
     if (snaps == NULL) {
-        g_task_return_error (task, g_steal_pointer (&error));
+        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to get available updates: %s", error->message);
         return;
     }
 
     StoreModel *self = g_task_get_source_object (task);
 
-    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    /* The returned snaps describe the new revision, so don't overwrite the installed details with them */
+    g_autoptr(GPtrArray) updates = g_ptr_array_new_with_free_func (g_object_unref);
     for (guint i = 0; i < snaps->len; i++) {
         SnapdSnap *snap = g_ptr_array_index (snaps, i);
-        g_autoptr(StoreSnapApp) app = store_model_get_snap (self, snapd_snap_get_name (snap));
-        store_snap_app_update_from_search (app, snap);
-        if (self->cache != NULL)
-            store_app_save_to_cache (STORE_APP (app), self->cache);
-        g_ptr_array_add (apps, g_steal_pointer (&app));
+        g_ptr_array_add (updates, store_model_get_snap (self, snapd_snap_get_name (snap)));
     }
 
-    g_task_return_pointer (task, g_steal_pointer (&apps), (GDestroyNotify) g_ptr_array_unref);
+    self->updates_time = g_get_monotonic_time ();
+    set_updates (self, updates);
+
+    g_task_return_boolean (task, TRUE);
 }
 
-static void
-progress_cb (SnapdClient *client G_GNUC_UNUSED, SnapdChange *change, gpointer deprecated G_GNUC_UNUSED, gpointer user_data)
+static gboolean
+is_recent (gint64 time)
 {
-    GTask *task = user_data;
+    return time != 0 && g_get_monotonic_time () - time < PREFETCH_LIFETIME;
+}
 
-    StoreApp *app = g_task_get_task_data (task);
-    g_printerr ("%s:\n", store_app_get_name (app));
-    GPtrArray *tasks = snapd_change_get_tasks (change);
-    for (guint i = 0; i < tasks->len; i++) {
-        SnapdTask *task = g_ptr_array_index (tasks, i);
-        g_printerr ("  kind: %s\n", snapd_task_get_kind (task));
-        g_printerr ("  summary: %s\n", snapd_task_get_summary (task));
-        g_printerr ("  progress: %s %" G_GINT64_FORMAT "/%" G_GINT64_FORMAT "\n", snapd_task_get_progress_label (task), snapd_task_get_progress_done (task), snapd_task_get_progress_total (task));
-    }
+static PrefetchData *
+lookup_prefetch (StoreModel *self, StoreApp *app)
+{
+    return g_hash_table_lookup (self->prefetches, store_app_get_name (app));
 }
 
-static void
-install_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+static gboolean
+is_expired_prefetch (const gchar *name G_GNUC_UNUSED, PrefetchData *data, gpointer user_data G_GNUC_UNUSED)
 {
-    GTask *task = user_data;
+    return !data->queued && data->n_pending == 0 && !is_recent (data->details_time) && !is_recent (data->reviews_time);
+}
 
-    g_autoptr(GError) error = NULL;
-    gboolean r = snapd_client_install2_finish (SNAPD_CLIENT (object), result, &error);
-    if (!r && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-        return;
+/* Forget prefetches that are no longer reused, otherwise every app ever hovered is kept */
+static void
+prune_prefetches (StoreModel *self)
+{
+    g_hash_table_foreach_remove (self->prefetches, (GHRFunc) is_expired_prefetch, NULL);
+}
 
-    StoreModel *self = g_task_get_source_object (task);
-    StoreApp *app = g_task_get_task_data (task);
+static void
+queue_prefetch (StoreModel *self, PrefetchData *data)
+{
+    /* Most recently requested first, that's most likely what the user is about to click */
+    data->queued = TRUE;
+    g_queue_push_head (self->prefetch_queue, data);
+}
 
-    store_app_set_progress (app, NULL);
+static void schedule_prefetches (StoreModel *self);
 
-    if (!r) {
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to install snap: %s", error->message);
+static void
+prefetch_done (PrefetchData *data)
+{
+    data->n_pending--;
+    if (data->n_pending > 0)
         return;
+
+    StoreModel *self = data->self;
+    g_clear_object (&data->cancellable);
+    self->n_active_prefetches--;
+
+    /* Requested again while the cancelled attempt was finishing */
+    if (data->requeue) {
+        data->requeue = FALSE;
+        queue_prefetch (self, data);
     }
+    schedule_prefetches (self);
+    g_object_unref (self);
+}
 
-    store_app_set_installed (app, TRUE);
-    g_ptr_array_add (self->installed, g_object_ref (app));
-    g_object_notify (G_OBJECT (self), "installed");
+static void
+prefetch_image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    PrefetchData *data = user_data;
 
-    g_task_return_boolean (task, TRUE);
+    /* Only the cached copy is wanted */
+    g_autoptr(GdkPixbuf) pixbuf = store_model_get_image_finish (STORE_MODEL (object), result, NULL);
+
+    prefetch_done (data);
 }
 
 static void
-remove_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+prefetch_reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
 {
-    GTask *task = user_data;
+    PrefetchData *data = user_data;
 
     g_autoptr(GError) error = NULL;
-    gboolean r = snapd_client_remove_finish (SNAPD_CLIENT (object), result, &error);
-    if (!r && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    if (store_model_update_reviews_finish (STORE_MODEL (object), result, &error))
+        data->reviews_time = g_get_monotonic_time ();
+    else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_warning ("Failed to prefetch reviews for %s: %s", store_app_get_name (data->app), error->message);
+
+    prefetch_done (data);
+}
+
+static void
+prefetch_reviews (PrefetchData *data)
+{
+    if (is_recent (data->reviews_time) || store_app_get_appstream_id (data->app) == NULL)
         return;
 
-    StoreModel *self = g_task_get_source_object (task);
-    StoreApp *app = g_task_get_task_data (task);
+    data->n_pending++;
+    store_model_update_reviews_async (data->self, data->app, data->cancellable, prefetch_reviews_cb, data);
+}
+
+static void
+prefetch_screenshot (PrefetchData *data)
+{
+    GPtrArray *screenshots = store_app_get_screenshots (data->app);
+    if (data->self->cache == NULL || screenshots->len == 0)
+        return;
+
+    /* Leave screenshots until the app page is opened when the network is costly */
+    if (data->self->media_policy != STORE_MEDIA_POLICY_FULL)
+        return;
+
+    /* Nothing to do if already in the cache, the app page will revalidate it */
+    StoreMedia *screenshot = g_ptr_array_index (screenshots, 0);
+    const gchar *uri = store_media_get_uri (screenshot);
+    if (store_model_get_cached_image_metadata_sync (data->self, uri, NULL, NULL, NULL, data->cancellable, NULL))
+        return;
+
+    /* Decode at the size the app page shows it, so a matching thumbnail is cached */
+    guint width = 0, height = 420;
+    if (store_media_get_width (screenshot) > 0 && store_media_get_height (screenshot) > 0)
+        width = store_media_get_width (screenshot) * height / store_media_get_height (screenshot);
+
+    data->n_pending++;
+    store_model_get_image_async (data->self, uri, NULL, width, height, STORE_IMAGE_PRIORITY_PREFETCH, data->cancellable, prefetch_image_cb, data);
+}
 
-    store_app_set_progress (app, NULL);
+static void
+prefetch_details_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    PrefetchData *data = user_data;
+    StoreModel *self = data->self;
 
-    if (!r) {
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to remove snap: %s", error->message);
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) snaps = snapd_client_find_finish (SNAPD_CLIENT (object), result, NULL, &error);
+    store_trace_end_async (data->details_trace_start, "snapd", "find", store_app_get_name (data->app));
+    if (snaps == NULL) {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_warning ("Failed to prefetch %s: %s", store_app_get_name (data->app), error->message);
+        prefetch_done (data);
         return;
     }
 
-    store_app_set_installed (app, FALSE);
-    g_ptr_array_remove (self->installed, app);
-    g_object_notify (G_OBJECT (self), "installed");
+    if (snaps->len == 1) {
+        store_snap_app_update_from_search (STORE_SNAP_APP (data->app), g_ptr_array_index (snaps, 0));
+        save_app (self, data->app);
+        data->details_time = g_get_monotonic_time ();
 
-    g_task_return_boolean (task, TRUE);
+        /* These need the details, e.g. the appstream ID and screenshot URIs */
+        prefetch_reviews (data);
+        prefetch_screenshot (data);
+    }
+
+    prefetch_done (data);
 }
 
 static void
-refresh_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+start_prefetch (StoreModel *self, PrefetchData *data)
 {
-    g_autoptr(GTask) task = user_data;
+    self->n_active_prefetches++;
+    g_object_ref (self);
+    data->cancellable = g_cancellable_new ();
+    data->n_pending = 1;
 
-    g_autoptr(GError) error = NULL;
-    g_autoptr(GPtrArray) snaps = snapd_client_find_finish (SNAPD_CLIENT (object), result, NULL, &error);
-    if (snaps == NULL) {
-        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
-            return;
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to get snap information: %s", error->message);
+    if (is_recent (data->details_time)) {
+        prefetch_reviews (data);
+        prefetch_done (data);
         return;
     }
 
-    if (snaps->len != 1) {
-        g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED, "Snap find returned %d results, expected 1", snaps->len);
-        return;
+    g_autoptr(SnapdClient) client = snapd_client_new ();
+    snapd_client_set_socket_path (client, self->snapd_socket_path);
+    data->details_trace_start = store_trace_begin ();
+    snapd_client_find_async (client, SNAPD_FIND_FLAGS_MATCH_NAME, store_app_get_name (data->app), data->cancellable, prefetch_details_cb, data);
+}
+
+static gboolean
+prefetch_idle_cb (StoreModel *self)
+{
+    self->prefetch_source = 0;
+
+    while (self->n_active_prefetches < MAX_ACTIVE_PREFETCHES && !g_queue_is_empty (self->prefetch_queue)) {
+        PrefetchData *data = g_queue_pop_head (self->prefetch_queue);
+        data->queued = FALSE;
+        start_prefetch (self, data);
     }
 
-    StoreSnapApp *app = g_task_get_task_data (task);
-    SnapdSnap *snap = g_ptr_array_index (snaps, 0);
+    return G_SOURCE_REMOVE;
+}
 
-    store_snap_app_update_from_search (app, snap);
+static void
+schedule_prefetches (StoreModel *self)
+{
+    if (self->prefetch_source != 0 || g_queue_is_empty (self->prefetch_queue) || self->n_active_prefetches >= MAX_ACTIVE_PREFETCHES)
+        return;
 
-    g_task_return_boolean (task, TRUE);
+    self->prefetch_source = g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) prefetch_idle_cb, self, NULL);
 }
 
 static void
@@ -830,13 +2672,44 @@ store_model_dispose (GObject *object)
 {
     StoreModel *self = STORE_MODEL (object);
 
+    g_clear_handle_id (&self->image_cancel_source, g_source_remove);
+    g_clear_handle_id (&self->prefetch_source, g_source_remove);
+    g_clear_handle_id (&self->throughput_expiry_source, g_source_remove);
+    if (self->snapshot_source != 0) {
+        g_clear_handle_id (&self->snapshot_source, g_source_remove);
+        save_snapshot (self);
+    }
+    if (self->search_index_source != 0) {
+        g_clear_handle_id (&self->search_index_source, g_source_remove);
+        save_search_index (self);
+    }
+
+    g_clear_pointer (&self->active_operations, g_ptr_array_unref);
     g_clear_object (&self->cache);
     g_clear_pointer (&self->categories, g_ptr_array_unref);
+    g_clear_pointer (&self->image_host_requests, g_hash_table_unref);
+    if (self->image_queue != NULL) {
+        g_autoptr(GQueue) image_queue = g_steal_pointer (&self->image_queue);
+        for (GList *link = image_queue->head; link != NULL; link = link->next) {
+            g_autoptr(GTask) task = link->data;
+            unqueue_image (task);
+            g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_CANCELLED, "Model disposed");
+        }
+    }
     g_clear_pointer (&self->installed, g_ptr_array_unref);
     g_clear_object (&self->odrs_client);
+    g_clear_object (&self->operation_cancellable);
+    if (self->operation_queue != NULL)
+        g_queue_free_full (g_steal_pointer (&self->operation_queue), (GDestroyNotify) operation_free);
+    g_clear_pointer (&self->prefetch_queue, g_queue_free);
+    g_clear_pointer (&self->prefetches, g_hash_table_unref);
+    g_clear_pointer (&self->search_index, g_hash_table_unref);
+    g_clear_pointer (&self->search_index_updates, g_hash_table_unref);
+    g_clear_pointer (&self->search_tasks, g_ptr_array_unref);
     g_clear_object (&self->session);
     g_clear_pointer (&self->snapd_socket_path, g_free);
     g_clear_pointer (&self->snaps, g_hash_table_unref);
+    g_clear_pointer (&self->updates, g_ptr_array_unref);
 
     G_OBJECT_CLASS (store_model_parent_class)->dispose (object);
 }
@@ -854,6 +2727,12 @@ store_model_get_property (GObject *object, guint prop_id, GValue *value, GParamS
     case PROP_INSTALLED:
         g_value_set_boxed (value, self->installed);
         break;
+    case PROP_MEDIA_POLICY:
+        g_value_set_enum (value, self->media_policy);
+        break;
+    case PROP_UPDATES:
+        g_value_set_boxed (value, self->updates);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -879,17 +2758,42 @@ store_model_class_init (StoreModelClass *klass)
     g_object_class_install_property (G_OBJECT_CLASS (klass),
                                      PROP_INSTALLED,
                                      g_param_spec_boxed ("installed", NULL, NULL, G_TYPE_PTR_ARRAY, G_PARAM_READABLE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_MEDIA_POLICY,
+                                     g_param_spec_enum ("media-policy", NULL, NULL, store_media_policy_get_type (), STORE_MEDIA_POLICY_FULL, G_PARAM_READABLE));
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_UPDATES,
+                                     g_param_spec_boxed ("updates", NULL, NULL, G_TYPE_PTR_ARRAY, G_PARAM_READABLE));
 }
 
 static void
 store_model_init (StoreModel *self)
 {
+    self->active_operations = g_ptr_array_new_with_free_func ((GDestroyNotify) operation_free);
     self->cache = store_cache_new ();
     self->categories = g_ptr_array_new_with_free_func (g_object_unref);;
+    self->image_host_requests = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    self->image_queue = g_queue_new ();
     self->installed = g_ptr_array_new_with_free_func (g_object_unref);;
+    self->media_policy = STORE_MEDIA_POLICY_FULL;
     self->odrs_client = store_odrs_client_new ();
-    self->session = soup_session_new ();
+    self->operation_queue = g_queue_new ();
+    self->prefetch_queue = g_queue_new ();
+    self->prefetches = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) prefetch_data_free);
+    self->search_index_updates = search_index_new ();
+    self->search_tasks = g_ptr_array_new_with_free_func (g_object_unref);
+    self->session = soup_session_new_with_options (SOUP_SESSION_MAX_CONNS_PER_HOST, MAX_CONNS_PER_HOST,
+                                                   SOUP_SESSION_MAX_CONNS, MAX_CONNS,
+                                                   SOUP_SESSION_IDLE_TIMEOUT, IDLE_TIMEOUT,
+                                                   NULL);
+    store_odrs_client_set_soup_session (self->odrs_client, self->session);
     self->snaps = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+    self->updates = g_ptr_array_new_with_free_func (g_object_unref);
+
+    GNetworkMonitor *monitor = g_network_monitor_get_default ();
+    g_signal_connect_object (monitor, "notify::network-metered", G_CALLBACK (update_media_policy), self, G_CONNECT_SWAPPED);
+    g_signal_connect_object (monitor, "notify::connectivity", G_CALLBACK (update_media_policy), self, G_CONNECT_SWAPPED);
+    update_media_policy (self);
 }
 
 StoreModel *
@@ -903,7 +2807,12 @@ store_model_set_cache (StoreModel *self, StoreCache *cache)
 {
     g_return_if_fail (STORE_IS_MODEL (self));
 
-    g_set_object (&self->cache, cache);
+    if (!g_set_object (&self->cache, cache))
+        return;
+
+    /* Reloaded from the new cache when next searched */
+    if (!self->search_index_loading)
+        g_clear_pointer (&self->search_index, g_hash_table_unref);
 }
 
 StoreCache *
@@ -914,6 +2823,25 @@ store_model_get_cache (StoreModel *self)
     return self->cache;
 }
 
+GVariant *
+store_model_get_stats (StoreModel *self)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+
+    GVariantBuilder builder;
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{st}}"));
+    if (self->cache != NULL) {
+        g_autoptr(GVariant) cache_stats = store_cache_get_stats (self->cache);
+        for (gsize i = 0; i < g_variant_n_children (cache_stats); i++) {
+            g_autoptr(GVariant) entry = g_variant_get_child_value (cache_stats, i);
+            g_variant_builder_add_value (&builder, entry);
+        }
+    }
+    store_stats_add_to_builder (&self->image_stats, "network-images", &builder);
+
+    return g_variant_builder_end (&builder);
+}
+
 void
 store_model_set_odrs_server_uri (StoreModel *self, const gchar *uri)
 {
@@ -930,6 +2858,24 @@ store_model_get_odrs_server (StoreModel *self)
     return store_odrs_client_get_server_uri (self->odrs_client);
 }
 
+void
+store_model_set_soup_session (StoreModel *self, SoupSession *session)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+    g_return_if_fail (SOUP_IS_SESSION (session));
+
+    g_set_object (&self->session, session);
+    store_odrs_client_set_soup_session (self->odrs_client, session);
+}
+
+SoupSession *
+store_model_get_soup_session (StoreModel *self)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+
+    return self->session;
+}
+
 void
 store_model_set_snapd_socket_path (StoreModel *self, const gchar *path)
 {
@@ -944,7 +2890,12 @@ store_model_load (StoreModel *self)
 {
     g_return_if_fail (STORE_IS_MODEL (self));
 
-    self->categories = load_cached_categories (self);
+    g_clear_pointer (&self->categories, g_ptr_array_unref);
+    self->categories = load_snapshot (self);
+    if (self->categories == NULL) {
+        self->categories = load_cached_categories (self);
+        schedule_snapshot (self);
+    }
     g_object_notify (G_OBJECT (self), "categories");
 }
 
@@ -953,21 +2904,18 @@ store_model_get_snap (StoreModel *self, const gchar *name)
 {
     g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
 
-    StoreSnapApp *snap = g_hash_table_lookup (self->snaps, name);
-    if (snap == NULL) {
-        snap = store_snap_app_new ();
-        store_app_set_name (STORE_APP (snap), name);
-        g_hash_table_insert (self->snaps, g_strdup (name), snap); // FIXME: Use a weak ref to clean out when no-longer used
-    }
+    g_autoptr(StoreSnapApp) snap = lookup_snap (self, name);
 
+    store_app_begin_update (STORE_APP (snap));
     if (self->cache != NULL)
         store_app_update_from_cache (STORE_APP (snap), self->cache);
     set_review_counts (self, STORE_APP (snap));
     g_autoptr(GPtrArray) reviews = load_cached_reviews (self, name);
     if (reviews != NULL)
         store_app_set_reviews (STORE_APP (snap), reviews);
+    store_app_end_update (STORE_APP (snap));
 
-    return g_object_ref (snap);
+    return g_steal_pointer (&snap);
 }
 
 GPtrArray *
@@ -984,6 +2932,7 @@ store_model_update_categories_async (StoreModel *self,
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "snapd", "get-sections", NULL);
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
     snapd_client_get_sections_async (client, cancellable, get_sections_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
@@ -1012,6 +2961,7 @@ store_model_update_installed_async (StoreModel *self,
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "snapd", "get-snaps", NULL);
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
     snapd_client_get_snaps_async (client, SNAPD_GET_SNAPS_FLAGS_NONE, NULL, cancellable, get_snaps_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
@@ -1026,6 +2976,30 @@ store_model_update_installed_finish (StoreModel *self, GAsyncResult *result, GEr
     return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+void
+store_model_update_installed_snaps_async (StoreModel *self, GStrv names,
+                                          GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+    g_return_if_fail (names != NULL);
+
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "snapd", "get-snaps", names[0]);
+    g_task_set_task_data (task, g_strdupv (names), (GDestroyNotify) g_strfreev);
+    g_autoptr(SnapdClient) client = snapd_client_new ();
+    snapd_client_set_socket_path (client, self->snapd_socket_path);
+    snapd_client_get_snaps_async (client, SNAPD_GET_SNAPS_FLAGS_NONE, names, cancellable, get_snaps_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+}
+
+gboolean
+store_model_update_installed_snaps_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
 void
 store_model_update_ratings_async (StoreModel *self,
                                   GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
@@ -1033,7 +3007,7 @@ store_model_update_ratings_async (StoreModel *self,
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
-    store_odrs_client_update_ratings_async (self->odrs_client, cancellable, ratings_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_odrs_client_update_ratings_async (self->odrs_client, cancellable, ratings_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -1058,8 +3032,22 @@ store_model_update_reviews_async (StoreModel *self, StoreApp *app,
         return;
     }
 
+    /* Use recently prefetched reviews */
+    PrefetchData *prefetch = lookup_prefetch (self, app);
+    if (prefetch != NULL && is_recent (prefetch->reviews_time)) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    /* Apps restored from the snapshot don't have their cached reviews loaded yet */
+    if (store_app_get_reviews (app)->len == 0) {
+        g_autoptr(GPtrArray) reviews = load_cached_reviews (self, store_app_get_name (app));
+        if (reviews != NULL)
+            store_app_set_reviews (app, reviews);
+    }
+
     g_task_set_task_data (task, g_object_ref (app), g_object_unref);
-    store_odrs_client_get_reviews_async (self->odrs_client, store_app_get_appstream_id (app), NULL, NULL, 40, cancellable, reviews_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_odrs_client_get_reviews_async (self->odrs_client, store_app_get_appstream_id (app), NULL, NULL, 40, cancellable, reviews_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -1085,7 +3073,7 @@ store_model_downvote_review_async (StoreModel *self, StoreApp *app, StoreOdrsRev
     }
 
     g_task_set_task_data (task, feedback_data_new (app, review), (GDestroyNotify) feedback_data_free);
-    store_odrs_client_downvote_async (self->odrs_client, store_app_get_review_key (app), store_app_get_appstream_id (app), store_odrs_review_get_id (review), cancellable, downvote_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_odrs_client_downvote_async (self->odrs_client, store_app_get_review_key (app), store_app_get_appstream_id (app), store_odrs_review_get_id (review), cancellable, downvote_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -1111,7 +3099,7 @@ store_model_report_review_async (StoreModel *self, StoreApp *app, StoreOdrsRevie
     }
 
     g_task_set_task_data (task, feedback_data_new (app, review), (GDestroyNotify) feedback_data_free);
-    store_odrs_client_report_async (self->odrs_client, store_app_get_review_key (app), store_app_get_appstream_id (app), store_odrs_review_get_id (review), cancellable, report_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_odrs_client_report_async (self->odrs_client, store_app_get_review_key (app), store_app_get_appstream_id (app), store_odrs_review_get_id (review), cancellable, report_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -1137,7 +3125,7 @@ store_model_upvote_review_async (StoreModel *self, StoreApp *app, StoreOdrsRevie
     }
 
     g_task_set_task_data (task, feedback_data_new (app, review), (GDestroyNotify) feedback_data_free);
-    store_odrs_client_upvote_async (self->odrs_client, store_app_get_review_key (app), store_app_get_appstream_id (app), store_odrs_review_get_id (review), cancellable, upvote_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_odrs_client_upvote_async (self->odrs_client, store_app_get_review_key (app), store_app_get_appstream_id (app), store_odrs_review_get_id (review), cancellable, upvote_cb, g_steal_pointer (&task));
 }
 
 gboolean
@@ -1156,6 +3144,7 @@ store_model_search_async (StoreModel *self, const gchar *query,
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "snapd", "find", query);
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
     snapd_client_find_async (client, SNAPD_FIND_FLAGS_SCOPE_WIDE, query, cancellable, search_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
@@ -1170,11 +3159,59 @@ store_model_search_finish (StoreModel *self, GAsyncResult *result, GError **erro
     return g_task_propagate_pointer (G_TASK (result), error);
 }
 
+void
+store_model_search_cached_async (StoreModel *self, GStrv terms, GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+    g_return_if_fail (terms != NULL);
+
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "model", "search-cached", terms[0]);
+
+    g_autoptr(GPtrArray) folded_terms = g_ptr_array_new_with_free_func (g_free);
+    for (int i = 0; terms[i] != NULL; i++)
+        g_ptr_array_add (folded_terms, g_utf8_casefold (terms[i], -1));
+    g_ptr_array_add (folded_terms, NULL);
+    g_task_set_task_data (task, g_ptr_array_free (g_steal_pointer (&folded_terms), FALSE), (GDestroyNotify) g_strfreev);
+
+    load_search_index (self);
+    if (self->search_index != NULL)
+        return_search_results (self, task);
+    else
+        g_ptr_array_add (self->search_tasks, g_steal_pointer (&task));
+}
+
+GPtrArray *
+store_model_search_cached_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), NULL);
+
+    return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+GFile *
+store_model_get_cached_image_file (StoreModel *self, const gchar *uri)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+
+    if (self->cache == NULL)
+        return NULL;
+
+    return store_cache_get_file (self->cache, "images", uri, TRUE);
+}
+
 gboolean
 store_model_get_cached_image_metadata_sync (StoreModel *self, const gchar *uri, gchar **etag, gint64 *width, gint64 *height, GCancellable *cancellable, GError **error)
 {
     g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
 
+    /* Nothing is cached with --no-cache */
+    if (self->cache == NULL) {
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "No cache");
+        return FALSE;
+    }
+
     g_autoptr(JsonNode) node = store_cache_lookup_json (self->cache, "image-metadata", uri, TRUE, cancellable, error);
     if (node == NULL)
         return FALSE;
@@ -1191,7 +3228,7 @@ store_model_get_cached_image_metadata_sync (StoreModel *self, const gchar *uri,
 }
 
 void
-store_model_get_cached_image_async (StoreModel *self, const gchar *uri, gint width, gint height,
+store_model_get_cached_image_async (StoreModel *self, const gchar *uri, const gchar *etag, gint width, gint height,
                                     GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
 {
     g_return_if_fail (STORE_IS_MODEL (self));
@@ -1202,8 +3239,18 @@ store_model_get_cached_image_async (StoreModel *self, const gchar *uri, gint wid
         return;
     }
 
-    g_task_set_task_data (task, get_image_data_new (self, uri, width, height), (GDestroyNotify) get_image_data_free);
-    store_cache_lookup_async (self->cache, "images", uri, TRUE, cancellable, cached_image_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    GetImageData *image_data = get_image_data_new (self, uri, width, height);
+    image_data->etag = g_strdup (etag);
+    g_task_set_task_data (task, image_data, (GDestroyNotify) get_image_data_free);
+
+    /* Check for a thumbnail at this size first */
+    if (etag != NULL && (width != 0 || height != 0)) {
+        g_autofree gchar *thumbnail_name = get_thumbnail_name (image_data);
+        store_cache_lookup_async (self->cache, "thumbnail-metadata", thumbnail_name, TRUE, cancellable, cached_thumbnail_metadata_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+        return;
+    }
+
+    lookup_original_image (g_steal_pointer (&task));
 }
 
 GdkPixbuf *
@@ -1216,18 +3263,88 @@ store_model_get_cached_image_finish (StoreModel *self, GAsyncResult *result, GEr
 }
 
 void
-store_model_get_image_async (StoreModel *self, const gchar *uri, const gchar *etag, gint width, gint height,
+store_model_get_image_async (StoreModel *self, const gchar *uri, const gchar *etag, gint width, gint height, StoreImagePriority priority,
                              GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
 {
     g_return_if_fail (STORE_IS_MODEL (self));
 
     g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
-    GetImageData *image_data = get_image_data_new (self, uri, width, height);
-    g_task_set_task_data (task, image_data, (GDestroyNotify) get_image_data_free);
-    image_data->message = soup_message_new ("GET", uri);
-    if (etag != NULL)
-        soup_message_headers_append (image_data->message->request_headers, "If-None-Match", etag);
-    soup_session_send_async (self->session, image_data->message, cancellable, send_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+    store_trace_task (task, "http", "get-image", uri);
+    queue_image (self, task, uri, etag, width, height, priority, TRUE);
+}
+
+void
+store_model_download_image_async (StoreModel *self, const gchar *uri, const gchar *etag, StoreImagePriority priority,
+                                  GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "http", "download-image", uri);
+    queue_image (self, task, uri, etag, 0, 0, priority, FALSE);
+}
+
+gboolean
+store_model_download_image_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+void
+store_model_set_image_priority (StoreModel *self, GCancellable *cancellable, StoreImagePriority priority)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+    g_return_if_fail (G_IS_CANCELLABLE (cancellable));
+
+    /* Only the requests made with this cancellable, others for the same image may be for something else on screen.
+     * Requests already sent keep their connection */
+    gboolean changed = FALSE;
+    for (GList *link = self->image_queue->head; link != NULL; link = link->next) {
+        GetImageData *image_data = g_task_get_task_data (link->data);
+        if (image_data->priority != priority && g_task_get_cancellable (link->data) == cancellable) {
+            image_data->priority = priority;
+            changed = TRUE;
+        }
+    }
+
+    if (changed)
+        dispatch_images (self);
+}
+
+void
+store_model_set_media_policy (StoreModel *self, StoreMediaPolicy policy)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    self->media_policy_override = policy;
+    update_media_policy (self);
+}
+
+StoreMediaPolicy
+store_media_policy_for_network (GNetworkConnectivity connectivity, gboolean metered, gdouble throughput)
+{
+    /* Behind a captive portal or only a local network, so avoid anything we can do without */
+    if (connectivity != G_NETWORK_CONNECTIVITY_FULL)
+        return STORE_MEDIA_POLICY_ICONS_ONLY;
+
+    /* No throughput means it hasn't been measured yet */
+    gboolean slow = throughput > 0 && throughput < SLOW_THROUGHPUT;
+    if (metered && slow)
+        return STORE_MEDIA_POLICY_ICONS_ONLY;
+    if (metered || slow)
+        return STORE_MEDIA_POLICY_DEFER_SCREENSHOTS;
+
+    return STORE_MEDIA_POLICY_FULL;
+}
+
+StoreMediaPolicy
+store_model_get_media_policy (StoreModel *self)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), STORE_MEDIA_POLICY_FULL);
+    return self->media_policy;
 }
 
 GdkPixbuf *
@@ -1246,17 +3363,11 @@ store_model_install_async (StoreModel *self, StoreApp *app, StoreChannel *channe
 
     g_assert (STORE_IS_SNAP_APP (app)); // FIXME
 
-    g_autoptr(StoreProgress) progress = store_progress_new ();
-    store_app_set_progress (app, progress);
-
-    g_autoptr(SnapdClient) client = snapd_client_new ();
-    snapd_client_set_socket_path (client, self->snapd_socket_path);
     GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    g_task_set_task_data (task, g_object_ref (app), g_object_unref);
     const gchar *channel_name = NULL;
     if (channel != NULL)
-        store_channel_get_name (channel);
-    snapd_client_install2_async (client, SNAPD_INSTALL_FLAGS_NONE, store_app_get_name (app), channel_name, NULL, progress_cb, task, cancellable, install_cb, task);
+        channel_name = store_channel_get_name (channel);
+    queue_operation (self, operation_new (self, OPERATION_INSTALL, task, app, channel_name));
 }
 
 gboolean
@@ -1273,14 +3384,8 @@ store_model_remove_async (StoreModel *self, StoreApp *app, GCancellable *cancell
 
     g_assert (STORE_IS_SNAP_APP (app)); // FIXME
 
-    g_autoptr(StoreProgress) progress = store_progress_new ();
-    store_app_set_progress (app, progress);
-
-    g_autoptr(SnapdClient) client = snapd_client_new ();
-    snapd_client_set_socket_path (client, self->snapd_socket_path);
     GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    g_task_set_task_data (task, g_object_ref (app), g_object_unref);
-    snapd_client_remove_async (client, store_app_get_name (app), progress_cb, task, cancellable, remove_cb, task);
+    queue_operation (self, operation_new (self, OPERATION_REMOVE, task, app, NULL));
 }
 
 gboolean
@@ -1297,10 +3402,20 @@ store_model_refresh_async (StoreModel *self, StoreApp *app, GCancellable *cancel
 
     g_assert (STORE_IS_SNAP_APP (app)); // FIXME
 
+    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
+
+    /* Use recently prefetched details */
+    PrefetchData *prefetch = lookup_prefetch (self, app);
+    if (prefetch != NULL && is_recent (prefetch->details_time)) {
+        g_task_return_boolean (task, TRUE);
+        g_object_unref (task);
+        return;
+    }
+
     g_autoptr(SnapdClient) client = snapd_client_new ();
     snapd_client_set_socket_path (client, self->snapd_socket_path);
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
     g_task_set_task_data (task, g_object_ref (app), g_object_unref);
+    store_trace_task (task, "snapd", "find", store_app_get_name (app));
     snapd_client_find_async (client, SNAPD_FIND_FLAGS_MATCH_NAME, store_app_get_name (app), cancellable, refresh_cb, task);
 }
 
@@ -1310,3 +3425,115 @@ store_model_refresh_finish (StoreModel *self, GAsyncResult *result, GError **err
     g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
     return g_task_propagate_boolean (G_TASK (result), error);
 }
+
+GPtrArray *
+store_model_get_updates (StoreModel *self)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), NULL);
+    return self->updates;
+}
+
+void
+store_model_update_updates_async (StoreModel *self,
+                                  GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    g_autoptr(GTask) task = g_task_new (self, cancellable, callback, callback_data);
+
+    /* Use the last result if it hasn't expired */
+    if (self->updates_time != 0 && g_get_monotonic_time () - self->updates_time < UPDATES_LIFETIME) {
+        g_task_return_boolean (task, TRUE);
+        return;
+    }
+
+    store_trace_task (task, "snapd", "find-refreshable", NULL);
+    g_autoptr(SnapdClient) client = snapd_client_new ();
+    snapd_client_set_socket_path (client, self->snapd_socket_path);
+    snapd_client_find_refreshable_async (client, cancellable, find_refreshable_cb, g_steal_pointer (&task)); // FIXME: Combine cancellables
+}
+
+gboolean
+store_model_update_updates_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+void
+store_model_refresh_all_async (StoreModel *self,
+                               GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+
+    /* Queued with installs and removes so snapd doesn't get conflicting changes.
+     * The progress of the whole change is shown on each app being updated */
+    Operation *operation = operation_new (self, OPERATION_REFRESH_ALL, task, NULL, NULL);
+    operation->apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (guint i = 0; i < self->updates->len; i++)
+        g_ptr_array_add (operation->apps, g_object_ref (g_ptr_array_index (self->updates, i)));
+    queue_operation (self, operation);
+}
+
+gboolean
+store_model_refresh_all_finish (StoreModel *self, GAsyncResult *result, GError **error)
+{
+    g_return_val_if_fail (STORE_IS_MODEL (self), FALSE);
+    g_return_val_if_fail (g_task_is_valid (G_TASK (result), self), FALSE);
+
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+void
+store_model_prefetch_app (StoreModel *self, StoreApp *app)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+    g_return_if_fail (STORE_IS_APP (app));
+
+    if (!STORE_IS_SNAP_APP (app))
+        return;
+
+    prune_prefetches (self);
+
+    PrefetchData *data = lookup_prefetch (self, app);
+    if (data == NULL) {
+        data = prefetch_data_new (self, app);
+        g_hash_table_insert (self->prefetches, g_strdup (store_app_get_name (app)), data);
+    }
+
+    if (data->queued)
+        return;
+    if (data->n_pending > 0) {
+        if (g_cancellable_is_cancelled (data->cancellable))
+            data->requeue = TRUE;
+        return;
+    }
+    if (is_recent (data->details_time) && is_recent (data->reviews_time))
+        return;
+
+    queue_prefetch (self, data);
+    schedule_prefetches (self);
+}
+
+void
+store_model_cancel_prefetch_app (StoreModel *self, StoreApp *app)
+{
+    g_return_if_fail (STORE_IS_MODEL (self));
+    g_return_if_fail (STORE_IS_APP (app));
+
+    PrefetchData *data = lookup_prefetch (self, app);
+    if (data == NULL)
+        return;
+
+    if (data->queued) {
+        g_queue_remove (self->prefetch_queue, data);
+        data->queued = FALSE;
+    }
+    data->requeue = FALSE;
+    if (data->cancellable != NULL)
+        g_cancellable_cancel (data->cancellable);
+}
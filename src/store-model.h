@@ -11,6 +11,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <glib-object.h>
+#include <libsoup/soup.h>
 
 #include "store-cache.h"
 #include "store-category.h"
@@ -20,6 +21,39 @@
 
 G_BEGIN_DECLS
 
+#define STORE_MODEL_ERROR store_model_error_quark ()
+
+typedef enum
+{
+    STORE_MODEL_ERROR_NOT_MODIFIED
+} StoreModelError;
+
+GQuark         store_model_error_quark                    (void);
+
+/* Image downloads in order of priority */
+typedef enum
+{
+    STORE_IMAGE_PRIORITY_ICON,
+    STORE_IMAGE_PRIORITY_BANNER,
+    STORE_IMAGE_PRIORITY_SCREENSHOT,
+    STORE_IMAGE_PRIORITY_PREFETCH
+} StoreImagePriority;
+
+GType          store_image_priority_get_type              (void);
+
+/* Which images are downloaded, automatic picks one of the others from the network state */
+typedef enum
+{
+    STORE_MEDIA_POLICY_AUTOMATIC,
+    STORE_MEDIA_POLICY_FULL,
+    STORE_MEDIA_POLICY_DEFER_SCREENSHOTS,
+    STORE_MEDIA_POLICY_ICONS_ONLY
+} StoreMediaPolicy;
+
+GType          store_media_policy_get_type                (void);
+
+StoreMediaPolicy store_media_policy_for_network           (GNetworkConnectivity connectivity, gboolean metered, gdouble throughput);
+
 G_DECLARE_FINAL_TYPE   (StoreModel, store_model, STORE, MODEL, GObject)
 
 StoreModel    *store_model_new                            (void);
@@ -30,10 +64,16 @@ void           store_model_set_cache                      (StoreModel *model, St
 
 StoreCache    *store_model_get_cache                      (StoreModel *model);
 
+GVariant      *store_model_get_stats                      (StoreModel *model);
+
 void           store_model_set_odrs_server_uri            (StoreModel *model, const gchar *uri);
 
 const gchar   *store_model_get_odrs_server_uri            (StoreModel *model);
 
+void           store_model_set_soup_session               (StoreModel *model, SoupSession *session);
+
+SoupSession   *store_model_get_soup_session               (StoreModel *model);
+
 void           store_model_set_snapd_socket_path          (StoreModel *model, const gchar *path);
 
 StoreSnapApp  *store_model_get_snap                       (StoreModel *model, const gchar *name);
@@ -52,6 +92,11 @@ void           store_model_update_installed_async         (StoreModel *model,
 
 gboolean       store_model_update_installed_finish        (StoreModel *model, GAsyncResult *result, GError **error);
 
+void           store_model_update_installed_snaps_async   (StoreModel *model, GStrv names,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_update_installed_snaps_finish  (StoreModel *model, GAsyncResult *result, GError **error);
+
 void           store_model_update_ratings_async           (StoreModel *model,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
@@ -82,19 +127,38 @@ void           store_model_search_async                   (StoreModel *model, co
 
 GPtrArray     *store_model_search_finish                  (StoreModel *model, GAsyncResult *result, GError **error);
 
+void           store_model_search_cached_async            (StoreModel *model, GStrv terms, GCancellable *cancellable,
+                                                           GAsyncReadyCallback callback, gpointer callback_data);
+
+GPtrArray     *store_model_search_cached_finish           (StoreModel *model, GAsyncResult *result, GError **error);
+
+GFile         *store_model_get_cached_image_file          (StoreModel *model, const gchar *uri);
+
 gboolean       store_model_get_cached_image_metadata_sync (StoreModel *model, const gchar *uri, gchar **etag, gint64 *width, gint64 *height,
                                                            GCancellable *cancellable, GError **error);
 
-void           store_model_get_cached_image_async         (StoreModel *model, const gchar *uri, gint width, gint height,
+void           store_model_get_cached_image_async         (StoreModel *model, const gchar *uri, const gchar *etag, gint width, gint height,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
 GdkPixbuf     *store_model_get_cached_image_finish        (StoreModel *model, GAsyncResult *result, GError **error);
 
 void           store_model_get_image_async                (StoreModel *model, const gchar *uri, const gchar *etag, gint width, gint height,
+                                                           StoreImagePriority priority,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
 GdkPixbuf     *store_model_get_image_finish               (StoreModel *model, GAsyncResult *result, GError **error);
 
+void           store_model_download_image_async           (StoreModel *model, const gchar *uri, const gchar *etag, StoreImagePriority priority,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_download_image_finish          (StoreModel *model, GAsyncResult *result, GError **error);
+
+void           store_model_set_image_priority             (StoreModel *model, GCancellable *cancellable, StoreImagePriority priority);
+
+void           store_model_set_media_policy               (StoreModel *model, StoreMediaPolicy policy);
+
+StoreMediaPolicy store_model_get_media_policy             (StoreModel *model);
+
 void           store_model_install_async                  (StoreModel *model, StoreApp *app, StoreChannel *channel,
                                                            GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
 
@@ -110,5 +174,21 @@ void           store_model_refresh_async                  (StoreModel *model, St
 
 gboolean       store_model_refresh_finish                 (StoreModel *model, GAsyncResult *result, GError **error);
 
+GPtrArray     *store_model_get_updates                    (StoreModel *model);
+
+void           store_model_update_updates_async           (StoreModel *model,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_update_updates_finish          (StoreModel *model, GAsyncResult *result, GError **error);
+
+void           store_model_refresh_all_async              (StoreModel *model,
+                                                           GCancellable *cancellable, GAsyncReadyCallback callback, gpointer callback_data);
+
+gboolean       store_model_refresh_all_finish             (StoreModel *model, GAsyncResult *result, GError **error);
+
+void           store_model_prefetch_app                   (StoreModel *model, StoreApp *app);
+
+void           store_model_cancel_prefetch_app            (StoreModel *model, StoreApp *app);
+
 
 G_END_DECLS
@@ -13,12 +13,12 @@
 #include "store-odrs-client.h"
 
 #include "store-odrs-review.h"
+#include "store-trace.h"
 
 struct _StoreOdrsClient
 {
     GObject parent_instance;
 
-    GCancellable *cancellable;
     gchar *distro;
     gchar *locale;
     GHashTable *ratings;
@@ -29,6 +29,14 @@ struct _StoreOdrsClient
 
 G_DEFINE_TYPE (StoreOdrsClient, store_odrs_client, G_TYPE_OBJECT)
 
+static SoupSession *
+get_soup_session (StoreOdrsClient *self)
+{
+    if (self->soup_session == NULL)
+        self->soup_session = soup_session_new ();
+    return self->soup_session;
+}
+
 static gchar *
 get_user_hash (void)
 {
@@ -43,6 +51,13 @@ get_user_hash (void)
     return g_compute_checksum_for_string (G_CHECKSUM_SHA1, salted, -1);
 }
 
+/* Cancelled by the caller's cancellable, so the transfer stops along with the task */
+static void
+send_message (StoreOdrsClient *self, SoupMessage *message, GTask *task, GAsyncReadyCallback callback)
+{
+    soup_session_send_async (get_soup_session (self), message, g_task_get_cancellable (task), callback, task);
+}
+
 static JsonNode *
 send_finish (GTask *task, GObject *object, GAsyncResult *result, GError **error)
 {
@@ -50,10 +65,8 @@ send_finish (GTask *task, GObject *object, GAsyncResult *result, GError **error)
     if (stream == NULL)
         return NULL;
 
-    StoreOdrsClient *self = g_task_get_source_object (task);
-
     g_autoptr(JsonParser) parser = json_parser_new ();
-    if (!json_parser_load_from_stream (parser, stream, self->cancellable, error))
+    if (!json_parser_load_from_stream (parser, stream, g_task_get_cancellable (task), error))
         return NULL;
 
     JsonNode *root = json_parser_get_root (parser);
@@ -259,8 +272,9 @@ send_feedback (StoreOdrsClient *self, const char *method, GAsyncReadyCallback re
     g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
     soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, result_callback, task);
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "odrs", method, app_id);
+    send_message (self, message, task, result_callback);
 }
 
 static void
@@ -268,8 +282,6 @@ store_odrs_client_dispose (GObject *object)
 {
     StoreOdrsClient *self = STORE_ODRS_CLIENT (object);
 
-    g_cancellable_cancel (self->cancellable);
-    g_clear_object (&self->cancellable);
     g_clear_pointer (&self->distro, g_free);
     g_clear_pointer (&self->locale, g_free);
     g_clear_pointer (&self->ratings, g_hash_table_unref);
@@ -289,11 +301,9 @@ store_odrs_client_class_init (StoreOdrsClientClass *klass)
 static void
 store_odrs_client_init (StoreOdrsClient *self)
 {
-    self->cancellable = g_cancellable_new ();
     self->distro = g_strdup ("Ubuntu"); // FIXME
     self->locale = g_strdup ("en"); // FIXME
     self->server_uri = g_strdup ("https://odrs.gnome.org");
-    self->soup_session = soup_session_new (); // FIXME: Support common session
     self->user_hash = get_user_hash ();
 }
 
@@ -320,6 +330,22 @@ store_odrs_client_get_server_uri (StoreOdrsClient *self)
     return self->server_uri;
 }
 
+void
+store_odrs_client_set_soup_session (StoreOdrsClient *self, SoupSession *session)
+{
+    g_return_if_fail (STORE_IS_ODRS_CLIENT (self));
+
+    g_set_object (&self->soup_session, session);
+}
+
+SoupSession *
+store_odrs_client_get_soup_session (StoreOdrsClient *self)
+{
+    g_return_val_if_fail (STORE_IS_ODRS_CLIENT (self), NULL);
+
+    return get_soup_session (self);
+}
+
 void
 store_odrs_client_set_distro (StoreOdrsClient *self, const gchar *distro)
 {
@@ -357,8 +383,9 @@ store_odrs_client_update_ratings_async (StoreOdrsClient *self,
     g_autofree gchar *uri = g_strdup_printf ("%s/1.0/reviews/api/ratings", self->server_uri);
     g_autoptr(SoupMessage) message = soup_message_new ("GET", uri);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, get_ratings_cb, task);
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "odrs", "ratings", NULL);
+    send_message (self, message, task, get_ratings_cb);
 }
 
 gboolean
@@ -411,8 +438,9 @@ store_odrs_client_get_reviews_async (StoreOdrsClient *self, const gchar *app_id,
     g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
     soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, get_reviews_cb, task);
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "odrs", "fetch", app_id);
+    send_message (self, message, task, get_reviews_cb);
 }
 
 GPtrArray *
@@ -475,8 +503,9 @@ store_odrs_client_submit_async (StoreOdrsClient *self, const gchar *user_skey, c
     g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
     soup_message_set_request (message, "application/json; charset=utf-8", SOUP_MEMORY_COPY, json_text, json_text_length);
 
-    GTask *task = g_task_new (self, cancellable, callback, callback_data); // FIXME: Need to combine cancellables?
-    soup_session_send_async (self->soup_session, message, self->cancellable, submit_cb, task);
+    GTask *task = g_task_new (self, cancellable, callback, callback_data);
+    store_trace_task (task, "odrs", "submit", app_id);
+    send_message (self, message, task, submit_cb);
 }
 
 gboolean
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <gio/gio.h>
+#include <libsoup/soup.h>
 
 #include "store-odrs-review.h"
 
@@ -23,6 +24,10 @@ void             store_odrs_client_set_server_uri       (StoreOdrsClient *client
 
 const gchar     *store_odrs_client_get_server_uri       (StoreOdrsClient *client);
 
+void             store_odrs_client_set_soup_session     (StoreOdrsClient *client, SoupSession *session);
+
+SoupSession     *store_odrs_client_get_soup_session     (StoreOdrsClient *client);
+
 void             store_odrs_client_set_distro           (StoreOdrsClient *client, const gchar *distro);
 
 void             store_odrs_client_set_locale           (StoreOdrsClient *client, const gchar *locale);
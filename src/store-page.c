@@ -9,8 +9,11 @@
 
 #include "store-page.h"
 
+/* Work done on behalf of a page uses cancellables chained to the page scope.
+ * A scope is started each time the page is shown and cancelled when it is hidden, so work started while hidden is cancelled straight away */
 typedef struct
 {
+    GCancellable *cancellable;
     StoreModel *model;
 } StorePagePrivate;
 
@@ -22,6 +25,8 @@ store_page_dispose (GObject *object)
     StorePage *self = STORE_PAGE (object);
     StorePagePrivate *priv = store_page_get_instance_private (self);
 
+    g_cancellable_cancel (priv->cancellable);
+    g_clear_object (&priv->cancellable);
     g_clear_object (&priv->model);
 
     G_OBJECT_CLASS (store_page_parent_class)->dispose (object);
@@ -35,17 +40,48 @@ store_page_real_set_model (StorePage *self, StoreModel *model)
     g_set_object (&priv->model, model);
 }
 
+static void
+store_page_map (GtkWidget *widget)
+{
+    StorePage *self = STORE_PAGE (widget);
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    /* Started before the children are mapped so they can restart their work in it */
+    g_object_unref (priv->cancellable);
+    priv->cancellable = g_cancellable_new ();
+
+    GTK_WIDGET_CLASS (store_page_parent_class)->map (widget);
+}
+
+static void
+store_page_unmap (GtkWidget *widget)
+{
+    StorePage *self = STORE_PAGE (widget);
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    GTK_WIDGET_CLASS (store_page_parent_class)->unmap (widget);
+
+    g_cancellable_cancel (priv->cancellable);
+}
+
 static void
 store_page_class_init (StorePageClass *klass)
 {
     G_OBJECT_CLASS (klass)->dispose = store_page_dispose;
+    GTK_WIDGET_CLASS (klass)->map = store_page_map;
+    GTK_WIDGET_CLASS (klass)->unmap = store_page_unmap;
 
     klass->set_model = store_page_real_set_model;
 }
 
 static void
-store_page_init (StorePage *self G_GNUC_UNUSED)
+store_page_init (StorePage *self)
 {
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    /* Not shown yet */
+    priv->cancellable = g_cancellable_new ();
+    g_cancellable_cancel (priv->cancellable);
 }
 
 void
@@ -65,3 +101,29 @@ store_page_get_model (StorePage *self)
 
     return priv->model;
 }
+
+GCancellable *
+store_page_new_cancellable (StorePage *self)
+{
+    StorePagePrivate *priv = store_page_get_instance_private (self);
+
+    g_return_val_if_fail (STORE_IS_PAGE (self), NULL);
+
+    GCancellable *cancellable = g_cancellable_new ();
+    if (g_cancellable_is_cancelled (priv->cancellable))
+        g_cancellable_cancel (cancellable);
+    else
+        g_signal_connect_object (priv->cancellable, "cancelled", G_CALLBACK (g_cancellable_cancel), cancellable, G_CONNECT_SWAPPED);
+
+    return cancellable;
+}
+
+GCancellable *
+store_page_new_cancellable_for_widget (GtkWidget *widget)
+{
+    GtkWidget *page = gtk_widget_get_ancestor (widget, store_page_get_type ());
+    if (page == NULL)
+        return g_cancellable_new ();
+
+    return store_page_new_cancellable (STORE_PAGE (page));
+}
@@ -24,8 +24,12 @@ struct _StorePageClass
     void (*set_model) (StorePage *page, StoreModel *model); // FIXME: Replace with a property binding
 };
 
-void        store_page_set_model (StorePage *page, StoreModel *model);
+void          store_page_set_model                  (StorePage *page, StoreModel *model);
 
-StoreModel *store_page_get_model (StorePage *page);
+StoreModel   *store_page_get_model                  (StorePage *page);
+
+GCancellable *store_page_new_cancellable            (StorePage *page);
+
+GCancellable *store_page_new_cancellable_for_widget (GtkWidget *widget);
 
 G_END_DECLS
@@ -160,3 +160,15 @@ store_progress_get_total (StoreProgress *self)
     g_return_val_if_fail (STORE_IS_PROGRESS (self), 0);
     return self->total;
 }
+
+void
+store_progress_update (StoreProgress *self, gint64 done, gint64 total, const gchar *label)
+{
+    g_return_if_fail (STORE_IS_PROGRESS (self));
+
+    g_object_freeze_notify (G_OBJECT (self));
+    store_progress_set_done (self, done);
+    store_progress_set_total (self, total);
+    store_progress_set_label (self, label);
+    g_object_thaw_notify (G_OBJECT (self));
+}
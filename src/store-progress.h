@@ -29,4 +29,6 @@ void           store_progress_set_total (StoreProgress *progress, gint64 total);
 
 gint64         store_progress_get_total (StoreProgress *progress);
 
+void           store_progress_update    (StoreProgress *progress, gint64 done, gint64 total, const gchar *label);
+
 G_END_DECLS
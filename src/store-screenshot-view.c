@@ -89,6 +89,7 @@ store_screenshot_view_set_app (StoreScreenshotView *self, StoreApp *app)
         gtk_widget_show (GTK_WIDGET (image));
         gtk_widget_set_halign (GTK_WIDGET (image), GTK_ALIGN_START);
         store_image_set_model (image, self->model);
+        store_image_set_priority (image, STORE_IMAGE_PRIORITY_SCREENSHOT);
         store_image_set_uri (image, store_media_get_uri (screenshot));
         guint width = 0, height = 90;
         if (store_media_get_width (screenshot) > 0 && store_media_get_height (screenshot) > 0)
@@ -76,116 +76,16 @@ store_snap_app_launch (StoreApp *app, GError **error)
 static void
 store_snap_app_save_to_cache (StoreApp *self, StoreCache *cache)
 {
-    g_autoptr(JsonBuilder) builder = json_builder_new ();
-    json_builder_begin_object (builder);
-    json_builder_set_member_name (builder, "appstream-id"); // FIXME: Move common fields into StoreApp
-    json_builder_add_string_value (builder, store_app_get_appstream_id (self));
-    if (store_app_get_banner (self) != NULL) {
-        json_builder_set_member_name (builder, "banner");
-        json_builder_add_value (builder, store_media_to_json (store_app_get_banner (self)));
-    }
-    GPtrArray *channels = store_app_get_channels (self);
-    if (channels->len > 0) {
-        json_builder_set_member_name (builder, "channels");
-        json_builder_begin_array (builder);
-        for (guint i = 0; i < channels->len; i++) {
-            StoreChannel *channel = g_ptr_array_index (channels, i);
-            json_builder_add_value (builder, store_channel_to_json (channel));
-        }
-        json_builder_end_array (builder);
-    }
-    if (store_app_get_contact (self) != NULL) {
-        json_builder_set_member_name (builder, "contact");
-        json_builder_add_string_value (builder, store_app_get_contact (self));
-    }
-    json_builder_set_member_name (builder, "description");
-    json_builder_add_string_value (builder, store_app_get_description (self));
-    if (store_app_get_icon (self) != NULL) {
-        json_builder_set_member_name (builder, "icon");
-        json_builder_add_value (builder, store_media_to_json (store_app_get_icon (self)));
-    }
-    if (store_app_get_license (self) != NULL) {
-        json_builder_set_member_name (builder, "license");
-        json_builder_add_string_value (builder, store_app_get_license (self));
-    }
-    json_builder_set_member_name (builder, "name");
-    json_builder_add_string_value (builder, store_app_get_name (self));
-    json_builder_set_member_name (builder, "publisher");
-    json_builder_add_string_value (builder, store_app_get_publisher (self));
-    json_builder_set_member_name (builder, "publisher-validated");
-    json_builder_add_boolean_value (builder, store_app_get_publisher_validated (self));
-    json_builder_set_member_name (builder, "review-key");
-    json_builder_add_string_value (builder, store_app_get_review_key (self));
-    json_builder_set_member_name (builder, "screenshots");
-    json_builder_begin_array (builder);
-    GPtrArray *screenshots = store_app_get_screenshots (self);
-    for (guint i = 0; i < screenshots->len; i++) {
-        StoreMedia *screenshot = g_ptr_array_index (screenshots, i);
-        json_builder_add_value (builder, store_media_to_json (screenshot));
-    }
-    json_builder_end_array (builder);
-    json_builder_set_member_name (builder, "summary");
-    json_builder_add_string_value (builder, store_app_get_summary (self));
-    json_builder_set_member_name (builder, "title");
-    json_builder_add_string_value (builder, store_app_get_title (self));
-    json_builder_set_member_name (builder, "version");
-    json_builder_add_string_value (builder, store_app_get_version (self));
-    json_builder_end_object (builder);
-
-    g_autoptr(JsonNode) node = json_builder_get_root (builder);
+    g_autoptr(JsonNode) node = store_snap_app_to_json (STORE_SNAP_APP (self));
     store_cache_insert_json (cache, "snaps", store_app_get_name (self), FALSE, node, NULL, NULL);
 }
 
 static void
 store_snap_app_update_from_cache (StoreApp *self, StoreCache *cache)
 {
-    const gchar *name = store_app_get_name (STORE_APP (self));
-    g_autoptr(JsonNode) node = store_cache_lookup_json (cache, "snaps", name, FALSE, NULL, NULL);
-    if (node == NULL)
-        return;
-
-    JsonObject *object = json_node_get_object (node);
-    store_app_set_appstream_id (STORE_APP (self), json_object_get_string_member (object, "appstream-id")); // FIXME: Move common fields into StoreApp
-    if (json_object_has_member (object, "banner")) {
-        g_autoptr(StoreMedia) banner = store_media_new_from_json (json_object_get_member (object, "banner"));
-        store_app_set_banner (STORE_APP (self), banner);
-    }
-    if (json_object_has_member (object, "channels")) {
-        g_autoptr(GPtrArray) channels = g_ptr_array_new_with_free_func (g_object_unref);
-        JsonArray *channels_array = json_object_get_array_member (object, "channels");
-        for (guint i = 0; i < json_array_get_length (channels_array); i++) {
-            JsonNode *node = json_array_get_element (channels_array, i);
-            g_autoptr(StoreChannel) channel = store_channel_new_from_json (node);
-            g_ptr_array_add (channels, g_steal_pointer (&channel));
-        }
-        store_app_set_channels (STORE_APP (self), channels);
-    }
-    if (json_object_has_member (object, "contact"))
-        store_app_set_contact (STORE_APP (self), json_object_get_string_member (object, "contact"));
-    store_app_set_description (STORE_APP (self), json_object_get_string_member (object, "description"));
-    if (json_object_has_member (object, "icon")) {
-        g_autoptr(StoreMedia) icon = store_media_new_from_json (json_object_get_member (object, "icon"));
-        store_app_set_icon (STORE_APP (self), icon);
-    }
-    if (json_object_has_member (object, "license"))
-        store_app_set_license (STORE_APP (self), json_object_get_string_member (object, "license"));
-    store_app_set_name (STORE_APP (self), json_object_get_string_member (object, "name"));
-    store_app_set_publisher (STORE_APP (self), json_object_get_string_member (object, "publisher"));
-    store_app_set_publisher_validated (STORE_APP (self), json_object_get_boolean_member (object, "publisher-validated"));
-    if (json_object_has_member (object, "review-key"))
-        store_app_set_review_key (STORE_APP (self), json_object_get_string_member (object, "review-key"));
-    g_autoptr(GPtrArray) screenshots = g_ptr_array_new_with_free_func (g_object_unref);
-    JsonArray *screenshots_array = json_object_get_array_member (object, "screenshots");
-    for (guint i = 0; i < json_array_get_length (screenshots_array); i++) {
-        JsonNode *node = json_array_get_element (screenshots_array, i);
-        g_autoptr(StoreMedia) screenshot = store_media_new_from_json (node);
-        g_ptr_array_add (screenshots, g_steal_pointer (&screenshot));
-    }
-    store_app_set_screenshots (STORE_APP (self), screenshots);
-    store_app_set_summary (STORE_APP (self), json_object_get_string_member (object, "summary"));
-    store_app_set_title (STORE_APP (self), json_object_get_string_member (object, "title"));
-    if (json_object_has_member (object, "version"))
-        store_app_set_version (STORE_APP (self), json_object_get_string_member (object, "version"));
+    g_autoptr(JsonNode) node = store_cache_lookup_json (cache, "snaps", store_app_get_name (self), FALSE, NULL, NULL);
+    if (node != NULL)
+        store_snap_app_update_from_json (STORE_SNAP_APP (self), node);
 }
 
 static void
@@ -229,6 +129,8 @@ store_snap_app_update_from_search (StoreSnapApp *self, SnapdSnap *snap)
 {
     g_return_if_fail (STORE_IS_SNAP_APP (self));
 
+    store_app_begin_update (STORE_APP (self));
+
     store_app_set_name (STORE_APP (self), snapd_snap_get_name (snap));
     if (snapd_snap_get_title (snap) != NULL)
         store_app_set_title (STORE_APP (self), snapd_snap_get_title (snap));
@@ -305,4 +207,124 @@ store_snap_app_update_from_search (StoreSnapApp *self, SnapdSnap *snap)
 
     g_autofree gchar *appstream_id = g_strdup_printf ("io.snapcraft.%s-%s", snapd_snap_get_name (snap), snapd_snap_get_id (snap));
     store_app_set_appstream_id (STORE_APP (self), appstream_id);
+
+    store_app_end_update (STORE_APP (self));
+}
+
+JsonNode *
+store_snap_app_to_json (StoreSnapApp *app)
+{
+    g_return_val_if_fail (STORE_IS_SNAP_APP (app), NULL);
+
+    StoreApp *self = STORE_APP (app);
+
+    g_autoptr(JsonBuilder) builder = json_builder_new ();
+    json_builder_begin_object (builder);
+    json_builder_set_member_name (builder, "appstream-id"); // FIXME: Move common fields into StoreApp
+    json_builder_add_string_value (builder, store_app_get_appstream_id (self));
+    if (store_app_get_banner (self) != NULL) {
+        json_builder_set_member_name (builder, "banner");
+        json_builder_add_value (builder, store_media_to_json (store_app_get_banner (self)));
+    }
+    GPtrArray *channels = store_app_get_channels (self);
+    if (channels->len > 0) {
+        json_builder_set_member_name (builder, "channels");
+        json_builder_begin_array (builder);
+        for (guint i = 0; i < channels->len; i++) {
+            StoreChannel *channel = g_ptr_array_index (channels, i);
+            json_builder_add_value (builder, store_channel_to_json (channel));
+        }
+        json_builder_end_array (builder);
+    }
+    if (store_app_get_contact (self) != NULL) {
+        json_builder_set_member_name (builder, "contact");
+        json_builder_add_string_value (builder, store_app_get_contact (self));
+    }
+    json_builder_set_member_name (builder, "description");
+    json_builder_add_string_value (builder, store_app_get_description (self));
+    if (store_app_get_icon (self) != NULL) {
+        json_builder_set_member_name (builder, "icon");
+        json_builder_add_value (builder, store_media_to_json (store_app_get_icon (self)));
+    }
+    if (store_app_get_license (self) != NULL) {
+        json_builder_set_member_name (builder, "license");
+        json_builder_add_string_value (builder, store_app_get_license (self));
+    }
+    json_builder_set_member_name (builder, "name");
+    json_builder_add_string_value (builder, store_app_get_name (self));
+    json_builder_set_member_name (builder, "publisher");
+    json_builder_add_string_value (builder, store_app_get_publisher (self));
+    json_builder_set_member_name (builder, "publisher-validated");
+    json_builder_add_boolean_value (builder, store_app_get_publisher_validated (self));
+    json_builder_set_member_name (builder, "review-key");
+    json_builder_add_string_value (builder, store_app_get_review_key (self));
+    json_builder_set_member_name (builder, "screenshots");
+    json_builder_begin_array (builder);
+    GPtrArray *screenshots = store_app_get_screenshots (self);
+    for (guint i = 0; i < screenshots->len; i++) {
+        StoreMedia *screenshot = g_ptr_array_index (screenshots, i);
+        json_builder_add_value (builder, store_media_to_json (screenshot));
+    }
+    json_builder_end_array (builder);
+    json_builder_set_member_name (builder, "summary");
+    json_builder_add_string_value (builder, store_app_get_summary (self));
+    json_builder_set_member_name (builder, "title");
+    json_builder_add_string_value (builder, store_app_get_title (self));
+    json_builder_set_member_name (builder, "version");
+    json_builder_add_string_value (builder, store_app_get_version (self));
+    json_builder_end_object (builder);
+
+    return json_builder_get_root (builder);
+}
+
+void
+store_snap_app_update_from_json (StoreSnapApp *self, JsonNode *node)
+{
+    g_return_if_fail (STORE_IS_SNAP_APP (self));
+
+    if (json_node_get_node_type (node) != JSON_NODE_OBJECT)
+        return;
+
+    JsonObject *object = json_node_get_object (node);
+    store_app_set_appstream_id (STORE_APP (self), json_object_get_string_member (object, "appstream-id")); // FIXME: Move common fields into StoreApp
+    if (json_object_has_member (object, "banner")) {
+        g_autoptr(StoreMedia) banner = store_media_new_from_json (json_object_get_member (object, "banner"));
+        store_app_set_banner (STORE_APP (self), banner);
+    }
+    if (json_object_has_member (object, "channels")) {
+        g_autoptr(GPtrArray) channels = g_ptr_array_new_with_free_func (g_object_unref);
+        JsonArray *channels_array = json_object_get_array_member (object, "channels");
+        for (guint i = 0; i < json_array_get_length (channels_array); i++) {
+            JsonNode *node = json_array_get_element (channels_array, i);
+            g_autoptr(StoreChannel) channel = store_channel_new_from_json (node);
+            g_ptr_array_add (channels, g_steal_pointer (&channel));
+        }
+        store_app_set_channels (STORE_APP (self), channels);
+    }
+    if (json_object_has_member (object, "contact"))
+        store_app_set_contact (STORE_APP (self), json_object_get_string_member (object, "contact"));
+    store_app_set_description (STORE_APP (self), json_object_get_string_member (object, "description"));
+    if (json_object_has_member (object, "icon")) {
+        g_autoptr(StoreMedia) icon = store_media_new_from_json (json_object_get_member (object, "icon"));
+        store_app_set_icon (STORE_APP (self), icon);
+    }
+    if (json_object_has_member (object, "license"))
+        store_app_set_license (STORE_APP (self), json_object_get_string_member (object, "license"));
+    store_app_set_name (STORE_APP (self), json_object_get_string_member (object, "name"));
+    store_app_set_publisher (STORE_APP (self), json_object_get_string_member (object, "publisher"));
+    store_app_set_publisher_validated (STORE_APP (self), json_object_get_boolean_member (object, "publisher-validated"));
+    if (json_object_has_member (object, "review-key"))
+        store_app_set_review_key (STORE_APP (self), json_object_get_string_member (object, "review-key"));
+    g_autoptr(GPtrArray) screenshots = g_ptr_array_new_with_free_func (g_object_unref);
+    JsonArray *screenshots_array = json_object_get_array_member (object, "screenshots");
+    for (guint i = 0; i < json_array_get_length (screenshots_array); i++) {
+        JsonNode *node = json_array_get_element (screenshots_array, i);
+        g_autoptr(StoreMedia) screenshot = store_media_new_from_json (node);
+        g_ptr_array_add (screenshots, g_steal_pointer (&screenshot));
+    }
+    store_app_set_screenshots (STORE_APP (self), screenshots);
+    store_app_set_summary (STORE_APP (self), json_object_get_string_member (object, "summary"));
+    store_app_set_title (STORE_APP (self), json_object_get_string_member (object, "title"));
+    if (json_object_has_member (object, "version"))
+        store_app_set_version (STORE_APP (self), json_object_get_string_member (object, "version"));
 }
@@ -21,4 +21,8 @@ StoreSnapApp *store_snap_app_new                (void);
 
 void          store_snap_app_update_from_search (StoreSnapApp *app, SnapdSnap *snap);
 
+JsonNode     *store_snap_app_to_json            (StoreSnapApp *app);
+
+void          store_snap_app_update_from_json   (StoreSnapApp *app, JsonNode *node);
+
 G_END_DECLS
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-stats.h"
+
+static const gint64 latency_bounds[STORE_STATS_N_LATENCY_BUCKETS - 1] = { 100, 1000, 10000, 100000, 1000000 };
+static const gchar *latency_names[STORE_STATS_N_LATENCY_BUCKETS] = {
+    "latency-le-100us", "latency-le-1ms", "latency-le-10ms", "latency-le-100ms", "latency-le-1s", "latency-gt-1s"
+};
+
+void
+store_stats_add_latency (StoreStats *stats, gint64 start)
+{
+    gint64 latency = g_get_monotonic_time () - start;
+
+    gint i = 0;
+    while (i < STORE_STATS_N_LATENCY_BUCKETS - 1 && latency > latency_bounds[i])
+        i++;
+    stats->latency[i]++;
+    stats->latency_total += latency;
+}
+
+void
+store_stats_add_to_builder (StoreStats *stats, const gchar *name, GVariantBuilder *builder)
+{
+    GVariantBuilder values;
+    g_variant_builder_init (&values, G_VARIANT_TYPE ("a{st}"));
+    g_variant_builder_add (&values, "{st}", "hits", stats->hits);
+    g_variant_builder_add (&values, "{st}", "misses", stats->misses);
+    g_variant_builder_add (&values, "{st}", "errors", stats->errors);
+    g_variant_builder_add (&values, "{st}", "writes", stats->writes);
+    g_variant_builder_add (&values, "{st}", "bytes-read", stats->bytes_read);
+    g_variant_builder_add (&values, "{st}", "bytes-written", stats->bytes_written);
+    g_variant_builder_add (&values, "{st}", "latency-total-us", (guint64) stats->latency_total);
+    for (int i = 0; i < STORE_STATS_N_LATENCY_BUCKETS; i++)
+        g_variant_builder_add (&values, "{st}", latency_names[i], stats->latency[i]);
+    g_variant_builder_add (builder, "{sa{st}}", name, &values);
+}
+
+gchar *
+store_stats_to_string (GVariant *stats)
+{
+    g_autoptr(GString) text = g_string_new ("");
+
+    GVariantIter iter;
+    g_variant_iter_init (&iter, stats);
+    const gchar *name;
+    GVariantIter *iter_values;
+    while (g_variant_iter_next (&iter, "{&sa{st}}", &name, &iter_values)) {
+        g_autoptr(GVariantIter) values = iter_values;
+        g_string_append_printf (text, "%s:\n", name);
+        const gchar *key;
+        guint64 value;
+        while (g_variant_iter_next (values, "{&st}", &key, &value))
+            g_string_append_printf (text, "  %-18s %" G_GUINT64_FORMAT "\n", key, value);
+    }
+
+    return g_string_free (g_steal_pointer (&text), FALSE);
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Upper bounds of the latency histogram buckets in microseconds, the last bucket is unbounded */
+#define STORE_STATS_N_LATENCY_BUCKETS 6
+
+typedef struct
+{
+    guint64 hits;
+    guint64 misses;
+    guint64 errors;
+    guint64 writes;
+    guint64 bytes_read;
+    guint64 bytes_written;
+    guint64 latency[STORE_STATS_N_LATENCY_BUCKETS];
+    gint64 latency_total;
+} StoreStats;
+
+void   store_stats_add_latency    (StoreStats *stats, gint64 start);
+
+void   store_stats_add_to_builder (StoreStats *stats, const gchar *name, GVariantBuilder *builder);
+
+gchar *store_stats_to_string      (GVariant *stats);
+
+G_END_DECLS
@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "store-trace.h"
+
+/* Spans are written in the Chrome trace event format (chrome://tracing, Perfetto, speedscope).
+ * When tracing is disabled each span costs a single check of trace_file */
+
+typedef struct
+{
+    gint64 start;
+    const gchar *category;
+    const gchar *name;
+    gchar *detail;
+} TaskSpan;
+
+static GMutex trace_lock;
+static FILE *trace_file = NULL;
+static guint64 next_async_id = 1;
+static gint next_thread_id = 1;
+static GPrivate thread_id;
+
+static guint
+get_thread_id (void)
+{
+    guint id = GPOINTER_TO_UINT (g_private_get (&thread_id));
+    if (id == 0) {
+        id = (guint) g_atomic_int_add (&next_thread_id, 1);
+        g_private_set (&thread_id, GUINT_TO_POINTER (id));
+    }
+    return id;
+}
+
+static void
+write_string (const gchar *value)
+{
+    fputc ('"', trace_file);
+    for (const gchar *c = value; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\')
+            fprintf (trace_file, "\\%c", *c);
+        else if ((guchar) *c < 0x20)
+            fprintf (trace_file, "\\u%04x", *c);
+        else
+            fputc (*c, trace_file);
+    }
+    fputc ('"', trace_file);
+}
+
+/* Must be called with trace_lock held */
+static void
+write_event (const gchar *phase, gint64 time, gint64 duration, guint64 id, const gchar *category, const gchar *name, const gchar *detail)
+{
+    fprintf (trace_file, "{\"ph\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%" G_GINT64_FORMAT, phase, getpid (), get_thread_id (), time);
+    if (duration >= 0)
+        fprintf (trace_file, ",\"dur\":%" G_GINT64_FORMAT, duration);
+    if (id != 0)
+        fprintf (trace_file, ",\"id\":\"0x%" G_GINT64_MODIFIER "x\"", id);
+    fputs (",\"cat\":", trace_file);
+    write_string (category);
+    fputs (",\"name\":", trace_file);
+    write_string (name);
+    if (detail != NULL) {
+        fputs (",\"args\":{\"detail\":", trace_file);
+        write_string (detail);
+        fputc ('}', trace_file);
+    }
+    fputs ("},\n", trace_file);
+}
+
+static void
+task_span_free (TaskSpan *span)
+{
+    g_free (span->detail);
+    g_free (span);
+}
+
+static void
+task_completed_cb (GTask *task, GParamSpec *pspec G_GNUC_UNUSED, TaskSpan *span)
+{
+    if (!g_task_get_completed (task))
+        return;
+
+    store_trace_end_async (span->start, span->category, span->name, span->detail);
+}
+
+gboolean
+store_trace_open (const gchar *path, GError **error)
+{
+    FILE *file = fopen (path, "w");
+    if (file == NULL) {
+        int errsv = errno;
+        g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv), "Failed to open trace file %s: %s", path, g_strerror (errsv));
+        return FALSE;
+    }
+
+    store_trace_close ();
+
+    g_mutex_lock (&trace_lock);
+    trace_file = file;
+    fputs ("[\n", trace_file);
+    g_mutex_unlock (&trace_lock);
+
+    return TRUE;
+}
+
+void
+store_trace_close (void)
+{
+    g_mutex_lock (&trace_lock);
+    if (trace_file != NULL) {
+        /* Trace viewers accept a missing closing bracket, but not a trailing comma */
+        fprintf (trace_file, "{\"ph\":\"M\",\"pid\":%d,\"name\":\"process_name\",\"args\":{\"name\":\"snap-store\"}}\n]\n", getpid ());
+        fclose (trace_file);
+        trace_file = NULL;
+    }
+    g_mutex_unlock (&trace_lock);
+}
+
+gboolean
+store_trace_enabled (void)
+{
+    return trace_file != NULL;
+}
+
+gint64
+store_trace_begin (void)
+{
+    if (trace_file == NULL)
+        return 0;
+
+    return g_get_monotonic_time ();
+}
+
+void
+store_trace_end (gint64 start, const gchar *category, const gchar *name, const gchar *detail)
+{
+    if (start == 0)
+        return;
+
+    gint64 end = g_get_monotonic_time ();
+
+    g_mutex_lock (&trace_lock);
+    if (trace_file != NULL)
+        write_event ("X", start, end - start, 0, category, name, detail);
+    g_mutex_unlock (&trace_lock);
+}
+
+void
+store_trace_end_async (gint64 start, const gchar *category, const gchar *name, const gchar *detail)
+{
+    if (start == 0)
+        return;
+
+    gint64 end = g_get_monotonic_time ();
+
+    g_mutex_lock (&trace_lock);
+    if (trace_file != NULL) {
+        /* Async operations overlap, so they are written as a begin/end pair rather than a nested span */
+        guint64 id = next_async_id++;
+        write_event ("b", start, -1, id, category, name, detail);
+        write_event ("e", end, -1, id, category, name, NULL);
+    }
+    g_mutex_unlock (&trace_lock);
+}
+
+void
+store_trace_task (GTask *task, const gchar *category, const gchar *name, const gchar *detail)
+{
+    if (trace_file == NULL)
+        return;
+
+    /* Category and name are expected to be string literals */
+    TaskSpan *span = g_new0 (TaskSpan, 1);
+    span->start = g_get_monotonic_time ();
+    span->category = category;
+    span->name = name;
+    span->detail = g_strdup (detail);
+    g_signal_connect_data (task, "notify::completed", G_CALLBACK (task_completed_cb), span, (GClosureNotify) task_span_free, 0);
+}
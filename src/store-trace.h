@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+gboolean store_trace_open      (const gchar *path, GError **error);
+
+void     store_trace_close     (void);
+
+gboolean store_trace_enabled   (void);
+
+gint64   store_trace_begin     (void);
+
+void     store_trace_end       (gint64 start, const gchar *category, const gchar *name, const gchar *detail);
+
+void     store_trace_end_async (gint64 start, const gchar *category, const gchar *name, const gchar *detail);
+
+void     store_trace_task      (GTask *task, const gchar *category, const gchar *name, const gchar *detail);
+
+G_END_DECLS
@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <glib/gi18n.h>
+
+#include "store-app.h"
+#include "store-app-installed-tile.h"
+#include "store-updates-page.h"
+
+struct _StoreUpdatesPage
+{
+    StorePage parent_instance;
+
+    GtkBox *app_box;
+    GtkLabel *count_label;
+    GtkSizeGroup *title_size_group;
+    GtkButton *update_all_button;
+
+    GCancellable *cancellable;
+};
+
+enum
+{
+    PROP_0,
+    PROP_APPS,
+    PROP_LAST
+};
+
+G_DEFINE_TYPE (StoreUpdatesPage, store_updates_page, store_page_get_type ())
+
+enum
+{
+    SIGNAL_APP_ACTIVATED,
+    SIGNAL_LAST
+};
+
+static guint signals[SIGNAL_LAST] = { 0, };
+
+static void
+tile_activated_cb (StoreUpdatesPage *self, StoreAppInstalledTile *tile)
+{
+    g_signal_emit (self, signals[SIGNAL_APP_ACTIVATED], 0, store_app_installed_tile_get_app (tile));
+}
+
+static void
+refresh_all_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    StoreUpdatesPage *self = user_data;
+
+    g_autoptr(GError) error = NULL;
+    if (!store_model_refresh_all_finish (STORE_MODEL (object), result, &error)) {
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            return;
+        g_warning ("Failed to update snaps: %s", error->message);
+    }
+
+    gtk_widget_set_sensitive (GTK_WIDGET (self->update_all_button), store_model_get_updates (STORE_MODEL (object))->len > 0);
+}
+
+static void
+update_all_button_clicked_cb (StoreUpdatesPage *self)
+{
+    gtk_widget_set_sensitive (GTK_WIDGET (self->update_all_button), FALSE);
+    store_model_refresh_all_async (store_page_get_model (STORE_PAGE (self)), self->cancellable, refresh_all_cb, self);
+}
+
+static gboolean
+updates_count_to_label (GBinding *binding G_GNUC_UNUSED, const GValue *from_value, GValue *to_value, gpointer user_data G_GNUC_UNUSED)
+{
+    GPtrArray *apps = g_value_get_boxed (from_value);
+
+    g_autofree gchar *text = NULL;
+    if (apps->len == 0)
+        text = g_strdup (/* Text shown above the list of updates when there are none */
+                         _("Your applications are up to date"));
+    else
+        text = g_strdup_printf (ngettext (/* Text shown above the list of applications with updates available */
+                                          "%d update available…",
+                                          "%d updates available…", apps->len), apps->len);
+
+    g_value_set_string (to_value, text);
+
+    return TRUE;
+}
+
+static void
+store_updates_page_dispose (GObject *object)
+{
+    StoreUpdatesPage *self = STORE_UPDATES_PAGE (object);
+
+    g_cancellable_cancel (self->cancellable);
+    g_clear_object (&self->cancellable);
+
+    G_OBJECT_CLASS (store_updates_page_parent_class)->dispose (object);
+}
+
+static void
+store_updates_page_get_property (GObject *object, guint prop_id, GValue *value G_GNUC_UNUSED, GParamSpec *pspec)
+{
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+}
+
+static void
+store_updates_page_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    StoreUpdatesPage *self = STORE_UPDATES_PAGE (object);
+
+    switch (prop_id)
+    {
+    case PROP_APPS:
+        store_updates_page_set_apps (self, g_value_get_boxed (value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+        break;
+    }
+}
+
+static void
+store_updates_page_set_model (StorePage *page, StoreModel *model)
+{
+    StoreUpdatesPage *self = STORE_UPDATES_PAGE (page);
+
+    g_object_bind_property (model, "updates", self, "apps", G_BINDING_SYNC_CREATE);
+    g_object_bind_property_full (model, "updates", self->count_label, "label", G_BINDING_SYNC_CREATE, updates_count_to_label, NULL, NULL, NULL);
+
+    STORE_PAGE_CLASS (store_updates_page_parent_class)->set_model (page, model);
+}
+
+static void
+store_updates_page_class_init (StoreUpdatesPageClass *klass)
+{
+    G_OBJECT_CLASS (klass)->dispose = store_updates_page_dispose;
+    G_OBJECT_CLASS (klass)->get_property = store_updates_page_get_property;
+    G_OBJECT_CLASS (klass)->set_property = store_updates_page_set_property;
+    STORE_PAGE_CLASS (klass)->set_model = store_updates_page_set_model;
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass),
+                                     PROP_APPS,
+                                     g_param_spec_boxed ("apps", NULL, NULL, G_TYPE_PTR_ARRAY, G_PARAM_WRITABLE));
+
+    gtk_widget_class_set_template_from_resource (GTK_WIDGET_CLASS (klass), "/io/snapcraft/Store/store-updates-page.ui");
+
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreUpdatesPage, app_box);
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreUpdatesPage, count_label);
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreUpdatesPage, title_size_group);
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreUpdatesPage, update_all_button);
+
+    gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), update_all_button_clicked_cb);
+
+    signals[SIGNAL_APP_ACTIVATED] = g_signal_new ("app-activated",
+                                                  G_TYPE_FROM_CLASS (G_OBJECT_CLASS (klass)),
+                                                  G_SIGNAL_RUN_LAST,
+                                                  0,
+                                                  NULL, NULL,
+                                                  NULL,
+                                                  G_TYPE_NONE,
+                                                  1, store_app_get_type ());
+}
+
+static void
+store_updates_page_init (StoreUpdatesPage *self)
+{
+    store_page_get_type ();
+    gtk_widget_init_template (GTK_WIDGET (self));
+
+    self->cancellable = g_cancellable_new ();
+}
+
+void
+store_updates_page_load (StoreUpdatesPage *self)
+{
+    g_return_if_fail (STORE_IS_UPDATES_PAGE (self));
+
+    store_model_update_updates_async (store_page_get_model (STORE_PAGE (self)), self->cancellable, NULL, NULL);
+}
+
+void
+store_updates_page_set_apps (StoreUpdatesPage *self, GPtrArray *apps)
+{
+    g_return_if_fail (STORE_IS_UPDATES_PAGE (self));
+
+    gtk_widget_set_sensitive (GTK_WIDGET (self->update_all_button), apps->len > 0);
+
+    /* Keep the tiles of apps that still have updates */
+    g_autoptr(GHashTable) tiles = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_autoptr(GList) children = gtk_container_get_children (GTK_CONTAINER (self->app_box));
+    for (GList *link = children; link != NULL; link = link->next) {
+        StoreAppInstalledTile *tile = link->data;
+        StoreApp *app = store_app_installed_tile_get_app (tile);
+        if (g_ptr_array_find (apps, app, NULL)) {
+            g_hash_table_insert (tiles, app, tile);
+            continue;
+        }
+
+        gtk_size_group_remove_widget (self->title_size_group, store_app_installed_tile_get_title_box (tile));
+        gtk_container_remove (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
+    }
+
+    for (guint i = 0; i < apps->len; i++) {
+        StoreApp *app = g_ptr_array_index (apps, i);
+        StoreAppInstalledTile *tile = g_hash_table_lookup (tiles, app);
+        if (tile == NULL) {
+            tile = store_app_installed_tile_new ();
+            gtk_widget_show (GTK_WIDGET (tile));
+            gtk_size_group_add_widget (self->title_size_group, store_app_installed_tile_get_title_box (tile));
+            g_signal_connect_object (tile, "activated", G_CALLBACK (tile_activated_cb), self, G_CONNECT_SWAPPED);
+            store_app_installed_tile_set_model (tile, store_page_get_model (STORE_PAGE (self)));
+            store_app_installed_tile_set_app (tile, app);
+            gtk_container_add (GTK_CONTAINER (self->app_box), GTK_WIDGET (tile));
+        }
+        gtk_box_reorder_child (self->app_box, GTK_WIDGET (tile), i);
+    }
+}
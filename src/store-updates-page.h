@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#pragma once
+
+#include "store-page.h"
+
+G_BEGIN_DECLS
+
+G_DECLARE_FINAL_TYPE (StoreUpdatesPage, store_updates_page, STORE, UPDATES_PAGE, StorePage)
+
+void store_updates_page_load     (StoreUpdatesPage *page);
+
+void store_updates_page_set_apps (StoreUpdatesPage *page, GPtrArray *apps);
+
+G_END_DECLS
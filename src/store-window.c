@@ -14,6 +14,7 @@
 #include "store-category-page.h"
 #include "store-home-page.h"
 #include "store-installed-page.h"
+#include "store-updates-page.h"
 
 struct _StoreWindow
 {
@@ -29,9 +30,15 @@ struct _StoreWindow
     GtkToggleButton *installed_button;
     StoreInstalledPage *installed_page;
     GtkStack *stack;
+    GtkToggleButton *updates_button;
+    StoreUpdatesPage *updates_page;
 
+    gulong first_draw_id;
     StoreModel *model;
     GList *page_stack;
+    gboolean prewarm_pages;
+    guint prewarm_source;
+    guint startup_source;
 };
 
 G_DEFINE_TYPE (StoreWindow, store_window, GTK_TYPE_APPLICATION_WINDOW)
@@ -48,6 +55,84 @@ category_activated_cb (StoreWindow *self, StoreCategory *category)
     store_window_show_category (self, category);
 }
 
+/* Only the home page is in the template, the others are built the first time they are shown */
+static gpointer
+add_page (StoreWindow *self, GType type)
+{
+    StorePage *page = g_object_new (type, "visible", TRUE, NULL);
+    if (g_signal_lookup ("app-activated", type) != 0)
+        g_signal_connect_object (page, "app-activated", G_CALLBACK (app_activated_cb), self, G_CONNECT_SWAPPED);
+    if (g_signal_lookup ("category-activated", type) != 0)
+        g_signal_connect_object (page, "category-activated", G_CALLBACK (category_activated_cb), self, G_CONNECT_SWAPPED);
+    if (self->model != NULL)
+        store_page_set_model (page, self->model);
+    gtk_container_add (GTK_CONTAINER (self->stack), GTK_WIDGET (page));
+
+    return page;
+}
+
+static StoreAppPage *
+get_app_page (StoreWindow *self)
+{
+    if (self->app_page == NULL)
+        self->app_page = add_page (self, store_app_page_get_type ());
+    return self->app_page;
+}
+
+static StoreCategoryHomePage *
+get_category_home_page (StoreWindow *self)
+{
+    if (self->category_home_page == NULL)
+        self->category_home_page = add_page (self, store_category_home_page_get_type ());
+    return self->category_home_page;
+}
+
+static StoreCategoryPage *
+get_category_page (StoreWindow *self)
+{
+    if (self->category_page == NULL)
+        self->category_page = add_page (self, store_category_page_get_type ());
+    return self->category_page;
+}
+
+static StoreInstalledPage *
+get_installed_page (StoreWindow *self)
+{
+    if (self->installed_page == NULL)
+        self->installed_page = add_page (self, store_installed_page_get_type ());
+    return self->installed_page;
+}
+
+static StoreUpdatesPage *
+get_updates_page (StoreWindow *self)
+{
+    if (self->updates_page == NULL)
+        self->updates_page = add_page (self, store_updates_page_get_type ());
+    return self->updates_page;
+}
+
+/* Builds one page per iteration so the main loop stays responsive */
+static gboolean
+prewarm_cb (StoreWindow *self)
+{
+    if (self->category_home_page == NULL)
+        get_category_home_page (self);
+    else if (self->installed_page == NULL)
+        get_installed_page (self);
+    else if (self->updates_page == NULL)
+        get_updates_page (self);
+    else if (self->app_page == NULL)
+        get_app_page (self);
+    else if (self->category_page == NULL)
+        get_category_page (self);
+    else {
+        self->prewarm_source = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
 static void
 back_button_clicked_cb (StoreWindow *self)
 {
@@ -59,6 +144,44 @@ back_button_clicked_cb (StoreWindow *self)
     gtk_widget_set_visible (GTK_WIDGET (self->back_button), self->page_stack != NULL);
 }
 
+/* Startup runs in stages so the first frame isn't delayed:
+ * the home page is shown from the cache, then refreshed from the network once painted,
+ * then the pages that aren't visible are loaded when nothing else is happening */
+static gboolean
+load_idle_cb (StoreWindow *self)
+{
+    self->startup_source = 0;
+
+    /* The pages may not exist yet, they pick up the results from the model when built */
+    store_model_update_installed_async (self->model, NULL, NULL, NULL);
+    store_model_update_updates_async (self->model, NULL, NULL, NULL);
+
+    if (self->prewarm_pages && self->prewarm_source == 0)
+        self->prewarm_source = g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) prewarm_cb, self, NULL);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+load_network_cb (StoreWindow *self)
+{
+    store_home_page_load (self->home_page);
+    store_model_update_ratings_async (self->model, NULL, NULL, NULL);
+
+    self->startup_source = g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) load_idle_cb, self, NULL);
+
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+first_draw_cb (StoreWindow *self)
+{
+    g_clear_signal_handler (&self->first_draw_id, self);
+    self->startup_source = g_idle_add ((GSourceFunc) load_network_cb, self);
+
+    return FALSE;
+}
+
 static void
 page_toggled_cb (StoreWindow *self, GtkToggleButton *button)
 {
@@ -68,9 +191,15 @@ page_toggled_cb (StoreWindow *self, GtkToggleButton *button)
     if (button == self->home_button)
         gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->home_page));
     else if (button == self->categories_button)
-        gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->category_home_page));
+        gtk_stack_set_visible_child (self->stack, GTK_WIDGET (get_category_home_page (self)));
     else if (button == self->installed_button)
-        gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->installed_page));
+        gtk_stack_set_visible_child (self->stack, GTK_WIDGET (get_installed_page (self)));
+    else if (button == self->updates_button) {
+        StoreUpdatesPage *updates_page = get_updates_page (self);
+        /* Cheap if recently checked */
+        store_updates_page_load (updates_page);
+        gtk_stack_set_visible_child (self->stack, GTK_WIDGET (updates_page));
+    }
     g_clear_pointer (&self->page_stack, g_list_free);
     gtk_widget_hide (GTK_WIDGET (self->back_button));
 
@@ -80,6 +209,8 @@ page_toggled_cb (StoreWindow *self, GtkToggleButton *button)
         gtk_toggle_button_set_active (self->categories_button, FALSE);
     if (button != self->installed_button)
         gtk_toggle_button_set_active (self->installed_button, FALSE);
+    if (button != self->updates_button)
+        gtk_toggle_button_set_active (self->updates_button, FALSE);
 }
 
 static void
@@ -87,6 +218,9 @@ store_window_dispose (GObject *object)
 {
     StoreWindow *self = STORE_WINDOW (object);
 
+    g_clear_signal_handler (&self->first_draw_id, self);
+    g_clear_handle_id (&self->prewarm_source, g_source_remove);
+    g_clear_handle_id (&self->startup_source, g_source_remove);
     g_clear_object (&self->model);
     g_clear_pointer (&self->page_stack, g_list_free);
 
@@ -100,16 +234,13 @@ store_window_class_init (StoreWindowClass *klass)
 
     gtk_widget_class_set_template_from_resource (GTK_WIDGET_CLASS (klass), "/io/snapcraft/Store/store-window.ui");
 
-    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, app_page);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, back_button);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, categories_button);
-    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, category_home_page);
-    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, category_page);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, home_button);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, home_page);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, installed_button);
-    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, installed_page);
     gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, stack);
+    gtk_widget_class_bind_template_child (GTK_WIDGET_CLASS (klass), StoreWindow, updates_button);
 
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), app_activated_cb);
     gtk_widget_class_bind_template_callback (GTK_WIDGET_CLASS (klass), back_button_clicked_cb);
@@ -120,11 +251,7 @@ store_window_class_init (StoreWindowClass *klass)
 static void
 store_window_init (StoreWindow *self)
 {
-    store_app_page_get_type ();
-    store_category_home_page_get_type ();
-    store_category_page_get_type ();
     store_home_page_get_type ();
-    store_installed_page_get_type ();
     gtk_widget_init_template (GTK_WIDGET (self));
 
     gtk_window_set_default_size (GTK_WINDOW (self), 800, 600); // FIXME: Temp
@@ -145,11 +272,25 @@ store_window_set_model (StoreWindow *self, StoreModel *model)
 
     g_set_object (&self->model, model);
 
-    store_page_set_model (STORE_PAGE (self->app_page), model);
-    store_page_set_model (STORE_PAGE (self->category_home_page), model);
-    store_page_set_model (STORE_PAGE (self->category_page), model);
     store_page_set_model (STORE_PAGE (self->home_page), model);
-    store_page_set_model (STORE_PAGE (self->installed_page), model);
+    if (self->app_page != NULL)
+        store_page_set_model (STORE_PAGE (self->app_page), model);
+    if (self->category_home_page != NULL)
+        store_page_set_model (STORE_PAGE (self->category_home_page), model);
+    if (self->category_page != NULL)
+        store_page_set_model (STORE_PAGE (self->category_page), model);
+    if (self->installed_page != NULL)
+        store_page_set_model (STORE_PAGE (self->installed_page), model);
+    if (self->updates_page != NULL)
+        store_page_set_model (STORE_PAGE (self->updates_page), model);
+}
+
+void
+store_window_set_prewarm_pages (StoreWindow *self, gboolean prewarm_pages)
+{
+    g_return_if_fail (STORE_IS_WINDOW (self));
+
+    self->prewarm_pages = prewarm_pages;
 }
 
 void
@@ -157,8 +298,10 @@ store_window_load (StoreWindow *self)
 {
     g_return_if_fail (STORE_IS_WINDOW (self));
 
-    store_home_page_load (self->home_page);
-    store_installed_page_load (self->installed_page);
+    if (self->first_draw_id != 0 || self->startup_source != 0)
+        return;
+
+    self->first_draw_id = g_signal_connect_data (self, "draw", G_CALLBACK (first_draw_cb), NULL, NULL, G_CONNECT_SWAPPED | G_CONNECT_AFTER);
 }
 
 void
@@ -168,8 +311,9 @@ store_window_show_app (StoreWindow *self, StoreApp *app)
 
     self->page_stack = g_list_prepend (self->page_stack, gtk_stack_get_visible_child (self->stack));
 
-    store_app_page_set_app (self->app_page, app);
-    gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->app_page)); // FIXME: Buttons
+    StoreAppPage *app_page = get_app_page (self);
+    store_app_page_set_app (app_page, app);
+    gtk_stack_set_visible_child (self->stack, GTK_WIDGET (app_page)); // FIXME: Buttons
     gtk_widget_show (GTK_WIDGET (self->back_button));
 }
 
@@ -180,7 +324,18 @@ store_window_show_category (StoreWindow *self, StoreCategory *category)
 
     self->page_stack = g_list_prepend (self->page_stack, gtk_stack_get_visible_child (self->stack));
 
-    store_category_page_set_category (self->category_page, category);
-    gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->category_page)); // FIXME: Buttons
+    StoreCategoryPage *category_page = get_category_page (self);
+    store_category_page_set_category (category_page, category);
+    gtk_stack_set_visible_child (self->stack, GTK_WIDGET (category_page)); // FIXME: Buttons
     gtk_widget_show (GTK_WIDGET (self->back_button));
 }
+
+void
+store_window_search (StoreWindow *self, const gchar *query)
+{
+    g_return_if_fail (STORE_IS_WINDOW (self));
+
+    gtk_toggle_button_set_active (self->home_button, TRUE);
+    gtk_stack_set_visible_child (self->stack, GTK_WIDGET (self->home_page));
+    store_home_page_search (self->home_page, query);
+}
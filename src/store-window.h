@@ -20,14 +20,18 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (StoreWindow, store_window, STORE, WINDOW, GtkApplicationWindow)
 
-StoreWindow *store_window_new           (StoreApplication *application);
+StoreWindow *store_window_new               (StoreApplication *application);
 
-void         store_window_set_model     (StoreWindow *window, StoreModel *model);
+void         store_window_set_model         (StoreWindow *window, StoreModel *model);
 
-void         store_window_load          (StoreWindow *self);
+void         store_window_set_prewarm_pages (StoreWindow *self, gboolean prewarm_pages);
 
-void         store_window_show_app      (StoreWindow *self, StoreApp *app);
+void         store_window_load              (StoreWindow *self);
 
-void         store_window_show_category (StoreWindow *self, StoreCategory *category);
+void         store_window_show_app          (StoreWindow *self, StoreApp *app);
+
+void         store_window_show_category     (StoreWindow *self, StoreCategory *category);
+
+void         store_window_search            (StoreWindow *self, const gchar *query);
 
 G_END_DECLS
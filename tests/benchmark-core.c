@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "store-cache.h"
+#include "store-model.h"
+#include "store-snap-app.h"
+
+/* Times the hot paths in the core library in isolation, reporting the average time per call */
+
+static gint n_items = 1000;
+static gint n_iterations = 5;
+
+typedef void (*BenchmarkFunc) (StoreModel *model, GPtrArray *apps);
+
+/* Temporary directory that is removed along with its contents when it goes out of scope */
+typedef gchar TempDir;
+
+static void
+remove_directory (GFile *dir)
+{
+    g_autoptr(GFileEnumerator) enumerator = g_file_enumerate_children (dir, G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+    while (enumerator != NULL) {
+        GFileInfo *info;
+        GFile *child;
+        if (!g_file_enumerator_iterate (enumerator, &info, &child, NULL, NULL) || info == NULL)
+            break;
+        if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+            remove_directory (child);
+        else
+            g_file_delete (child, NULL, NULL);
+    }
+    g_file_delete (dir, NULL, NULL);
+}
+
+static void
+temp_dir_free (TempDir *path)
+{
+    g_autoptr(GFile) dir = g_file_new_for_path (path);
+    remove_directory (dir);
+    g_free (path);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (TempDir, temp_dir_free)
+
+static GPtrArray *
+make_apps (void)
+{
+    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    for (gint i = 0; i < n_items; i++) {
+        g_autoptr(StoreSnapApp) app = store_snap_app_new ();
+        g_autofree gchar *name = g_strdup_printf ("snap%d", i);
+        g_autofree gchar *appstream_id = g_strdup_printf ("io.snapcraft.snap%d-ID%d", i, i);
+        g_autofree gchar *title = g_strdup_printf ("Snap %d", i);
+        store_app_set_name (STORE_APP (app), name);
+        store_app_set_appstream_id (STORE_APP (app), appstream_id);
+        store_app_set_title (STORE_APP (app), title);
+        store_app_set_summary (STORE_APP (app), "A synthetic snap used for benchmarking");
+        store_app_set_description (STORE_APP (app), "This snap doesn't exist, it is generated to measure how the store performs with a large catalog.");
+        store_app_set_publisher (STORE_APP (app), "Benchmark");
+        store_app_set_version (STORE_APP (app), "1.0");
+        g_ptr_array_add (apps, g_steal_pointer (&app));
+    }
+
+    return g_steal_pointer (&apps);
+}
+
+static void
+benchmark_save_to_cache (StoreModel *model, GPtrArray *apps)
+{
+    for (guint i = 0; i < apps->len; i++)
+        store_app_save_to_cache (g_ptr_array_index (apps, i), store_model_get_cache (model));
+}
+
+static void
+benchmark_update_from_cache (StoreModel *model, GPtrArray *apps)
+{
+    for (guint i = 0; i < apps->len; i++)
+        store_app_update_from_cache (g_ptr_array_index (apps, i), store_model_get_cache (model));
+}
+
+static void
+benchmark_lookup_json (StoreModel *model, GPtrArray *apps)
+{
+    for (guint i = 0; i < apps->len; i++) {
+        g_autoptr(JsonNode) node = store_cache_lookup_json (store_model_get_cache (model), "snaps", store_app_get_name (g_ptr_array_index (apps, i)), FALSE, NULL, NULL);
+    }
+}
+
+static void
+benchmark_get_snap (StoreModel *model, GPtrArray *apps)
+{
+    for (guint i = 0; i < apps->len; i++) {
+        g_autoptr(StoreSnapApp) app = store_model_get_snap (model, store_app_get_name (g_ptr_array_index (apps, i)));
+    }
+}
+
+static void
+run (const gchar *name, BenchmarkFunc func, StoreModel *model, GPtrArray *apps)
+{
+    gdouble best = G_MAXDOUBLE, total = 0;
+    for (gint i = 0; i < n_iterations; i++) {
+        gint64 start = g_get_monotonic_time ();
+        func (model, apps);
+        gdouble us = (gdouble) (g_get_monotonic_time () - start) / MAX (apps->len, 1);
+        best = MIN (best, us);
+        total += us;
+    }
+
+    g_print ("%-20s %10.2f %10.2f\n", name, best, total / n_iterations);
+}
+
+int
+main (int argc, char **argv)
+{
+    const GOptionEntry options[] = {
+        { "items", 0, 0, G_OPTION_ARG_INT, &n_items, "Number of items to use in each benchmark", "N" },
+        { "iterations", 0, 0, G_OPTION_ARG_INT, &n_iterations, "Number of times to run each benchmark", "N" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new ("- benchmark the store core library");
+    g_option_context_add_main_entries (context, options, NULL);
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    /* Keep the cache away from the user's one */
+    g_autoptr(TempDir) cache_dir = g_dir_make_tmp ("snap-store-benchmark-XXXXXX", &error);
+    if (cache_dir == NULL) {
+        g_printerr ("Failed to make cache directory: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    g_autoptr(GPtrArray) apps = make_apps ();
+
+    g_print ("%-20s %10s %10s\n", "operation (µs)", "best", "mean");
+    run ("save-to-cache", benchmark_save_to_cache, model, apps);
+    run ("lookup-json", benchmark_lookup_json, model, apps);
+    run ("update-from-cache", benchmark_update_from_cache, model, apps);
+    run ("get-snap", benchmark_get_snap, model, apps);
+
+    return EXIT_SUCCESS;
+}
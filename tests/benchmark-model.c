@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include <glib/gstdio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#include "mock-snapd.h"
+#include "mock-odrs-server.h"
+#include "store-model.h"
+#include "store-trace.h"
+
+/* Runs StoreModel against MockSnapd and MockOdrsServer populated with a synthetic catalog and
+ * reports how long each operation takes. No window is created, so this runs on machines without a display */
+
+static gint n_snaps = 2000;
+static gint n_sections = 20;
+static gint n_reviews = 5;
+static gint n_images = 50;
+static gint n_iterations = 5;
+static gint seed = 1;
+static gint snapd_latency = 0;
+static gint snapd_jitter = 0;
+static gint snapd_bandwidth = 0;
+static gint odrs_apps = 0;
+static gint odrs_latency = 0;
+static gint odrs_bandwidth = 0;
+static gchar *trace_path = NULL;
+
+static GMainLoop *loop = NULL;
+static guint n_pending = 0;
+static guint n_errors = 0;
+
+static GBytes *image_data = NULL;
+
+typedef struct
+{
+    const gchar *name;
+    GArray *times;
+} Stage;
+
+/* Temporary directory that is removed along with its contents when it goes out of scope */
+typedef gchar TempDir;
+
+static void
+remove_directory (GFile *dir)
+{
+    g_autoptr(GFileEnumerator) enumerator = g_file_enumerate_children (dir, G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
+                                                                       G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+    while (enumerator != NULL) {
+        GFileInfo *info;
+        GFile *child;
+        if (!g_file_enumerator_iterate (enumerator, &info, &child, NULL, NULL) || info == NULL)
+            break;
+        if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY)
+            remove_directory (child);
+        else
+            g_file_delete (child, NULL, NULL);
+    }
+    g_file_delete (dir, NULL, NULL);
+}
+
+static void
+temp_dir_free (TempDir *path)
+{
+    g_autoptr(GFile) dir = g_file_new_for_path (path);
+    remove_directory (dir);
+    g_free (path);
+}
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (TempDir, temp_dir_free)
+
+static void
+complete (void)
+{
+    n_pending--;
+    if (n_pending == 0)
+        g_main_loop_quit (loop);
+}
+
+static void
+check_error (const gchar *operation, GError *error)
+{
+    if (error == NULL)
+        return;
+    g_printerr ("%s failed: %s\n", operation, error->message);
+    n_errors++;
+}
+
+static gint64
+wait (void)
+{
+    if (n_pending > 0)
+        g_main_loop_run (loop);
+    return g_get_monotonic_time ();
+}
+
+static void
+add_time (Stage *stage, gint64 start, gint64 end)
+{
+    gdouble ms = (end - start) / 1000.0;
+    g_array_append_val (stage->times, ms);
+}
+
+static gint
+compare_times (gconstpointer a, gconstpointer b)
+{
+    gdouble time_a = *(const gdouble *) a, time_b = *(const gdouble *) b;
+    return time_a < time_b ? -1 : time_a > time_b ? 1 : 0;
+}
+
+static void
+report (Stage *stage)
+{
+    if (stage->times->len == 0)
+        return;
+
+    g_array_sort (stage->times, compare_times);
+    gdouble total = 0;
+    for (guint i = 0; i < stage->times->len; i++)
+        total += g_array_index (stage->times, gdouble, i);
+    g_print ("%-20s %10.2f %10.2f %10.2f %10.2f\n",
+             stage->name,
+             g_array_index (stage->times, gdouble, 0),
+             g_array_index (stage->times, gdouble, stage->times->len / 2),
+             total / stage->times->len,
+             g_array_index (stage->times, gdouble, stage->times->len - 1));
+}
+
+static void
+image_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *path G_GNUC_UNUSED, GHashTable *query G_GNUC_UNUSED, SoupClientContext *context G_GNUC_UNUSED, gpointer user_data G_GNUC_UNUSED)
+{
+    if (msg->method != SOUP_METHOD_GET) {
+        soup_message_set_status (msg, SOUP_STATUS_NOT_IMPLEMENTED);
+        return;
+    }
+
+    soup_message_set_status (msg, SOUP_STATUS_OK);
+    soup_message_set_response (msg, "image/png", SOUP_MEMORY_COPY, g_bytes_get_data (image_data, NULL), g_bytes_get_size (image_data));
+}
+
+static GBytes *
+make_image (GError **error)
+{
+    g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 1280, 720);
+    gdk_pixbuf_fill (pixbuf, 0xe95420ff);
+
+    g_autofree gchar *buffer = NULL;
+    gsize buffer_length;
+    if (!gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_length, "png", error, NULL))
+        return NULL;
+
+    return g_bytes_new_take (g_steal_pointer (&buffer), buffer_length);
+}
+
+static void
+populate (MockSnapd *snapd, MockOdrsServer *server)
+{
+    g_autoptr(GRand) rand = g_rand_new_with_seed (seed);
+
+    for (gint i = 0; i < n_sections; i++) {
+        g_autofree gchar *name = g_strdup_printf ("section%d", i);
+        mock_snapd_add_store_section (snapd, name);
+    }
+
+    for (gint i = 0; i < n_snaps; i++) {
+        g_autofree gchar *name = g_strdup_printf ("snap%d", i);
+        g_autofree gchar *id = g_strdup_printf ("ID%d", i);
+        g_autofree gchar *title = g_strdup_printf ("Snap %d", i);
+        g_autofree gchar *icon_url = g_strdup_printf ("http://localhost:%u/images/icon%d.png", mock_odrs_server_get_port (server), i);
+        g_autofree gchar *screenshot_url = g_strdup_printf ("http://localhost:%u/images/screenshot%d.png", mock_odrs_server_get_port (server), i);
+        g_autofree gchar *section = g_strdup_printf ("section%d", g_rand_int_range (rand, 0, MAX (n_sections, 1)));
+
+        MockSnap *snap = mock_snapd_add_store_snap (snapd, name);
+        mock_snap_set_id (snap, id);
+        mock_snap_set_title (snap, title);
+        mock_snap_set_summary (snap, "A synthetic snap used for benchmarking");
+        mock_snap_set_description (snap, "This snap doesn't exist, it is generated to measure how the store performs with a large catalog.");
+        mock_snap_add_media (snap, "icon", icon_url, 256, 256);
+        mock_snap_add_media (snap, "screenshot", screenshot_url, 1280, 720);
+        if (n_sections > 0)
+            mock_snap_add_store_section (snap, section);
+
+        g_autofree gchar *appstream_id = g_strdup_printf ("io.snapcraft.%s-%s", name, id);
+        MockOdrsApp *app = mock_odrs_server_add_app (server, appstream_id);
+        mock_app_generate_reviews (app, n_reviews, g_rand_int (rand));
+    }
+}
+
+static void
+update_categories_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    store_model_update_categories_finish (STORE_MODEL (object), result, &error);
+    check_error ("Updating categories", error);
+    complete ();
+}
+
+static void
+search_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GPtrArray) apps = store_model_search_finish (STORE_MODEL (object), result, &error);
+    check_error ("Searching", error);
+    complete ();
+}
+
+static void
+ratings_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    store_model_update_ratings_finish (STORE_MODEL (object), result, &error);
+    check_error ("Updating ratings", error);
+    complete ();
+}
+
+static void
+image_fetch_cb (GObject *object, GAsyncResult *result, gpointer user_data G_GNUC_UNUSED)
+{
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GdkPixbuf) pixbuf = store_model_get_image_finish (STORE_MODEL (object), result, &error);
+    check_error ("Fetching image", error);
+    complete ();
+}
+
+static void
+run_iteration (StoreModel *model, MockOdrsServer *server, gint iteration, Stage *stages)
+{
+    /* Refresh categories, this completes once every section has its snaps */
+    gint64 start = g_get_monotonic_time ();
+    n_pending++;
+    store_model_update_categories_async (model, NULL, update_categories_cb, NULL);
+    add_time (&stages[1], start, wait ());
+
+    /* Load from the cache written above */
+    start = g_get_monotonic_time ();
+    store_model_load (model);
+    add_time (&stages[0], start, g_get_monotonic_time ());
+
+    start = g_get_monotonic_time ();
+    n_pending++;
+    store_model_search_async (model, "snap", NULL, search_cb, NULL);
+    add_time (&stages[2], start, wait ());
+
+    start = g_get_monotonic_time ();
+    n_pending++;
+    store_model_update_ratings_async (model, NULL, ratings_cb, NULL);
+    add_time (&stages[3], start, wait ());
+
+    /* Use new URIs each time so the images are downloaded and decoded, not read from the cache */
+    start = g_get_monotonic_time ();
+    for (gint i = 0; i < n_images; i++) {
+        g_autofree gchar *uri = g_strdup_printf ("http://localhost:%u/images/%d/screenshot%d.png", mock_odrs_server_get_port (server), iteration, i);
+        n_pending++;
+        store_model_get_image_async (model, uri, NULL, 480, 270, STORE_IMAGE_PRIORITY_SCREENSHOT, NULL, image_fetch_cb, NULL);
+    }
+    add_time (&stages[4], start, wait ());
+}
+
+int
+main (int argc, char **argv)
+{
+    const GOptionEntry options[] = {
+        { "snaps", 0, 0, G_OPTION_ARG_INT, &n_snaps, "Number of snaps in the store", "N" },
+        { "sections", 0, 0, G_OPTION_ARG_INT, &n_sections, "Number of store sections", "N" },
+        { "reviews", 0, 0, G_OPTION_ARG_INT, &n_reviews, "Number of reviews for each snap", "N" },
+        { "images", 0, 0, G_OPTION_ARG_INT, &n_images, "Number of images to fetch in each iteration", "N" },
+        { "iterations", 0, 0, G_OPTION_ARG_INT, &n_iterations, "Number of times to run each operation", "N" },
+        { "seed", 0, 0, G_OPTION_ARG_INT, &seed, "Seed for generating the catalog", "SEED" },
+        { "snapd-latency", 0, 0, G_OPTION_ARG_INT, &snapd_latency, "Time snapd takes to respond in milliseconds", "MS" },
+        { "snapd-jitter", 0, 0, G_OPTION_ARG_INT, &snapd_jitter, "Random variation in snapd response time in milliseconds", "MS" },
+        { "snapd-bandwidth", 0, 0, G_OPTION_ARG_INT, &snapd_bandwidth, "Rate snapd sends responses in bytes per second", "BYTES" },
+        { "odrs-apps", 0, 0, G_OPTION_ARG_INT, &odrs_apps, "Number of extra apps with ratings on the ODRS server", "N" },
+        { "odrs-latency", 0, 0, G_OPTION_ARG_INT, &odrs_latency, "Time the ODRS server takes to respond in milliseconds", "MS" },
+        { "odrs-bandwidth", 0, 0, G_OPTION_ARG_INT, &odrs_bandwidth, "Rate the ODRS server sends responses in bytes per second", "BYTES" },
+        { "trace", 0, 0, G_OPTION_ARG_FILENAME, &trace_path, "Write a trace of the operations to a file", "FILE" },
+        { NULL }
+    };
+    g_autoptr(GOptionContext) context = g_option_context_new ("- benchmark the store model");
+    g_option_context_add_main_entries (context, options, NULL);
+    g_autoptr(GError) error = NULL;
+    if (!g_option_context_parse (context, &argc, &argv, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    /* Keep the cache away from the user's one */
+    g_autoptr(TempDir) cache_dir = g_dir_make_tmp ("snap-store-benchmark-XXXXXX", &error);
+    if (cache_dir == NULL) {
+        g_printerr ("Failed to make cache directory: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+    g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+    if (trace_path != NULL && !store_trace_open (trace_path, &error)) {
+        g_printerr ("%s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    loop = g_main_loop_new (NULL, FALSE);
+
+    image_data = make_image (&error);
+    if (image_data == NULL) {
+        g_printerr ("Failed to make image: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr(MockSnapd) snapd = mock_snapd_new ();
+    mock_snapd_set_random_seed (snapd, seed);
+    mock_snapd_set_latency (snapd, NULL, MAX (snapd_latency, 0), MAX (snapd_jitter, 0));
+    mock_snapd_set_bandwidth (snapd, MAX (snapd_bandwidth, 0));
+    if (!mock_snapd_start (snapd, &error)) {
+        g_printerr ("Failed to start mock snapd server: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    g_autoptr(MockOdrsServer) server = mock_odrs_server_new ();
+    soup_server_add_handler (SOUP_SERVER (server), "/images", image_cb, NULL, NULL);
+    mock_odrs_server_set_latency (server, MAX (odrs_latency, 0));
+    mock_odrs_server_set_bandwidth (server, MAX (odrs_bandwidth, 0));
+    mock_odrs_server_generate_ratings (server, MAX (odrs_apps, 0), seed);
+    if (!mock_odrs_server_start (server, &error)) {
+        g_printerr ("Failed to start mock ODRS server: %s\n", error->message);
+        return EXIT_FAILURE;
+    }
+
+    gint64 start = g_get_monotonic_time ();
+    populate (snapd, server);
+    g_print ("Generated %d snaps in %d sections with %d reviews each in %.2fms\n",
+             n_snaps, n_sections, n_reviews, (g_get_monotonic_time () - start) / 1000.0);
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    /* Pin the media policy so the throttled mock servers don't make the automatic policy defer screenshots */
+    store_model_set_media_policy (model, STORE_MEDIA_POLICY_FULL);
+    g_autofree gchar *odrs_server_uri = g_strdup_printf ("http://localhost:%u", mock_odrs_server_get_port (server));
+    store_model_set_odrs_server_uri (model, odrs_server_uri);
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+
+    Stage stages[] = {
+        { "load", g_array_new (FALSE, FALSE, sizeof (gdouble)) },
+        { "update-categories", g_array_new (FALSE, FALSE, sizeof (gdouble)) },
+        { "search", g_array_new (FALSE, FALSE, sizeof (gdouble)) },
+        { "ratings", g_array_new (FALSE, FALSE, sizeof (gdouble)) },
+        { "image-fetch", g_array_new (FALSE, FALSE, sizeof (gdouble)) },
+    };
+    for (gint i = 0; i < n_iterations; i++)
+        run_iteration (model, server, i, stages);
+
+    g_print ("%-20s %10s %10s %10s %10s\n", "operation (ms)", "min", "median", "mean", "max");
+    for (gsize i = 0; i < G_N_ELEMENTS (stages); i++) {
+        report (&stages[i]);
+        g_array_unref (stages[i].times);
+    }
+    g_print ("ODRS requests: %u ratings, %u fetch, %u total\n",
+             mock_odrs_server_get_request_count (server, "/1.0/reviews/api/ratings"),
+             mock_odrs_server_get_request_count (server, "/1.0/reviews/api/fetch"),
+             mock_odrs_server_get_request_count (server, NULL));
+
+    mock_snapd_stop (snapd);
+    g_clear_pointer (&image_data, g_bytes_unref);
+    store_trace_close ();
+
+    if (n_errors > 0) {
+        g_printerr ("%u operations failed\n", n_errors);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -16,7 +16,11 @@ struct _MockOdrsServer
     SoupServer parent_instance;
 
     GPtrArray *apps;
+    GHashTable *apps_by_id;
+    gsize bandwidth;
+    guint latency;
     guint port;
+    GHashTable *request_counts;
 };
 
 G_DEFINE_TYPE (MockOdrsServer, mock_odrs_server, SOUP_TYPE_SERVER)
@@ -63,6 +67,7 @@ mock_review_free (MockReview *review)
 struct _MockOdrsApp
 {
     gchar *id;
+    gint64 ratings[6];
     GPtrArray *reviews;
 };
 
@@ -95,6 +100,109 @@ calculate_user_skey (const gchar *user_hash)
     return g_strdup (user_hash); // FIXME
 }
 
+/* Responses are sent in chunks this often when the bandwidth is limited */
+#define CHUNK_INTERVAL 100
+
+typedef struct
+{
+    SoupServer *server;
+    SoupMessage *msg;
+    GBytes *data;
+    gsize offset;
+    gsize chunk_size;
+    gboolean finished;
+    gulong finished_id;
+} ThrottleData;
+
+static void
+throttle_data_free (ThrottleData *data)
+{
+    g_signal_handler_disconnect (data->msg, data->finished_id);
+    g_clear_object (&data->server);
+    g_clear_object (&data->msg);
+    g_clear_pointer (&data->data, g_bytes_unref);
+    g_free (data);
+}
+
+static void
+throttle_finished_cb (ThrottleData *data)
+{
+    data->finished = TRUE;
+}
+
+static gboolean
+throttle_cb (ThrottleData *data)
+{
+    if (data->finished)
+        return G_SOURCE_REMOVE;
+
+    gsize length;
+    const guint8 *contents = g_bytes_get_data (data->data, &length);
+    gsize chunk_length = MIN (data->chunk_size, length - data->offset);
+    if (chunk_length > 0)
+        soup_message_body_append (data->msg->response_body, SOUP_MEMORY_COPY, contents + data->offset, chunk_length);
+    data->offset += chunk_length;
+    if (data->offset >= length)
+        soup_message_body_complete (data->msg->response_body);
+    soup_server_unpause_message (data->server, data->msg);
+
+    return data->offset < length ? G_SOURCE_CONTINUE : G_SOURCE_REMOVE;
+}
+
+static gboolean
+throttle_start_cb (ThrottleData *data)
+{
+    if (throttle_cb (data))
+        g_timeout_add_full (G_PRIORITY_DEFAULT, CHUNK_INTERVAL, (GSourceFunc) throttle_cb, data, (GDestroyNotify) throttle_data_free);
+    else
+        throttle_data_free (data);
+    return G_SOURCE_REMOVE;
+}
+
+static void
+send_response (MockOdrsServer *self, SoupMessage *msg, guint status_code, const gchar *content_type, GBytes *data)
+{
+    soup_message_set_status (msg, status_code);
+
+    if (self->latency == 0 && self->bandwidth == 0) {
+        soup_message_set_response (msg, content_type, SOUP_MEMORY_COPY, g_bytes_get_data (data, NULL), g_bytes_get_size (data));
+        return;
+    }
+
+    /* Simulate a slow connection by sending the response in chunks after a delay */
+    soup_message_headers_set_content_type (msg->response_headers, content_type, NULL);
+    soup_message_headers_set_encoding (msg->response_headers, SOUP_ENCODING_CHUNKED);
+    soup_server_pause_message (SOUP_SERVER (self), msg);
+
+    ThrottleData *throttle_data = g_new0 (ThrottleData, 1);
+    throttle_data->server = g_object_ref (SOUP_SERVER (self));
+    throttle_data->msg = g_object_ref (msg);
+    throttle_data->data = g_bytes_ref (data);
+    throttle_data->chunk_size = self->bandwidth > 0 ? MAX (self->bandwidth * CHUNK_INTERVAL / 1000, 1) : G_MAXSIZE;
+    throttle_data->finished_id = g_signal_connect_swapped (msg, "finished", G_CALLBACK (throttle_finished_cb), throttle_data);
+    g_timeout_add (self->latency, (GSourceFunc) throttle_start_cb, throttle_data);
+}
+
+static void
+send_json_response (MockOdrsServer *self, SoupMessage *msg, guint status_code, JsonNode *root)
+{
+    g_autoptr(JsonGenerator) generator = json_generator_new ();
+    json_generator_set_root (generator, root);
+    gsize json_text_length;
+    g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
+
+    g_autoptr(GBytes) data = g_bytes_new_take (g_steal_pointer (&json_text), json_text_length);
+    send_response (self, msg, status_code, "application/json; charset=utf-8", data);
+}
+
+static void
+request_read_cb (MockOdrsServer *self, SoupMessage *msg)
+{
+    const gchar *path = soup_uri_get_path (soup_message_get_uri (msg));
+    guint count = GPOINTER_TO_UINT (g_hash_table_lookup (self->request_counts, path));
+    g_hash_table_insert (self->request_counts, g_strdup (path), GUINT_TO_POINTER (count + 1));
+}
+
 static void
 ratings_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *path G_GNUC_UNUSED, GHashTable *query G_GNUC_UNUSED, SoupClientContext *context G_GNUC_UNUSED, gpointer user_data)
 {
@@ -110,7 +218,7 @@ ratings_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *pat
     for (guint i = 0; i < self->apps->len; i++) {
         MockOdrsApp *app = g_ptr_array_index (self->apps, i);
 
-        gint64 count0 = 0, count1 = 0, count2 = 0, count3 = 0, count4 = 0, count5 = 0;
+        gint64 count0 = app->ratings[0], count1 = app->ratings[1], count2 = app->ratings[2], count3 = app->ratings[3], count4 = app->ratings[4], count5 = app->ratings[5];
         for (guint j = 0; j < app->reviews->len; j++) {
             MockReview *review = g_ptr_array_index (app->reviews, j);
             if (review->rating == 0)
@@ -153,10 +261,17 @@ ratings_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *pat
     gsize json_text_length;
     g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
 
-    soup_message_set_status (msg, SOUP_STATUS_OK);
-    soup_message_set_response (msg, "application/json; charset=utf-8", SOUP_MEMORY_TAKE, g_steal_pointer (&json_text), json_text_length);
+    /* Let clients skip downloading the ratings again if they haven't changed */
+    g_autofree gchar *checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, (const guchar *) json_text, json_text_length);
+    g_autofree gchar *etag = g_strdup_printf ("\"%s\"", checksum);
+    soup_message_headers_replace (msg->response_headers, "ETag", etag);
+    if (g_strcmp0 (soup_message_headers_get_one (msg->request_headers, "If-None-Match"), etag) == 0) {
+        soup_message_set_status (msg, SOUP_STATUS_NOT_MODIFIED);
+        return;
+    }
 
-    g_printerr ("RATINGS\n");
+    g_autoptr(GBytes) data = g_bytes_new_take (g_steal_pointer (&json_text), json_text_length);
+    send_response (self, msg, SOUP_STATUS_OK, "application/json; charset=utf-8", data);
 }
 
 static JsonNode *
@@ -281,16 +396,8 @@ fetch_cb (SoupServer *server G_GNUC_UNUSED, SoupMessage *msg, const gchar *path
     }
     json_builder_end_array (builder);
 
-    g_autoptr(JsonGenerator) generator = json_generator_new ();
     g_autoptr(JsonNode) response_root = json_builder_get_root (builder);
-    json_generator_set_root (generator, response_root);
-    gsize json_text_length;
-    g_autofree gchar *json_text = json_generator_to_data (generator, &json_text_length);
-
-    soup_message_set_status (msg, SOUP_STATUS_OK);
-    soup_message_set_response (msg, "application/json; charset=utf-8", SOUP_MEMORY_TAKE, g_steal_pointer (&json_text), json_text_length);
-
-    g_printerr ("FETCH %s\n", app_id);
+    send_json_response (self, msg, SOUP_STATUS_OK, response_root);
 }
 
 static void
@@ -435,6 +542,8 @@ mock_odrs_server_dispose (GObject *object)
     MockOdrsServer *self = MOCK_ODRS_SERVER (object);
 
     g_clear_pointer (&self->apps, g_ptr_array_unref);
+    g_clear_pointer (&self->apps_by_id, g_hash_table_unref);
+    g_clear_pointer (&self->request_counts, g_hash_table_unref);
 
     G_OBJECT_CLASS (mock_odrs_server_parent_class)->dispose (object);
 }
@@ -449,8 +558,11 @@ static void
 mock_odrs_server_init (MockOdrsServer *self)
 {
     self->apps = g_ptr_array_new_with_free_func ((GDestroyNotify) mock_app_free);
+    self->apps_by_id = g_hash_table_new (g_str_hash, g_str_equal);
+    self->request_counts = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
 
     g_object_set (self, "server-header", "mock-odrs", NULL);
+    g_signal_connect (self, "request-read", G_CALLBACK (request_read_cb), NULL);
     soup_server_add_handler (SOUP_SERVER (self), "/1.0/reviews/api/ratings", ratings_cb, self, NULL);
     soup_server_add_handler (SOUP_SERVER (self), "/1.0/reviews/api/fetch", fetch_cb, self, NULL);
     soup_server_add_handler (SOUP_SERVER (self), "/1.0/reviews/api/submit", submit_cb, self, NULL);
@@ -494,6 +606,48 @@ mock_odrs_server_get_port (MockOdrsServer *self)
     return port;
 }
 
+void
+mock_odrs_server_set_latency (MockOdrsServer *self, guint latency)
+{
+    g_return_if_fail (MOCK_IS_ODRS_SERVER (self));
+
+    self->latency = latency;
+}
+
+void
+mock_odrs_server_set_bandwidth (MockOdrsServer *self, gsize bytes_per_second)
+{
+    g_return_if_fail (MOCK_IS_ODRS_SERVER (self));
+
+    self->bandwidth = bytes_per_second;
+}
+
+guint
+mock_odrs_server_get_request_count (MockOdrsServer *self, const gchar *path)
+{
+    g_return_val_if_fail (MOCK_IS_ODRS_SERVER (self), 0);
+
+    if (path != NULL)
+        return GPOINTER_TO_UINT (g_hash_table_lookup (self->request_counts, path));
+
+    guint count = 0;
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, self->request_counts);
+    gpointer value;
+    while (g_hash_table_iter_next (&iter, NULL, &value))
+        count += GPOINTER_TO_UINT (value);
+
+    return count;
+}
+
+void
+mock_odrs_server_reset_request_counts (MockOdrsServer *self)
+{
+    g_return_if_fail (MOCK_IS_ODRS_SERVER (self));
+
+    g_hash_table_remove_all (self->request_counts);
+}
+
 gboolean
 mock_odrs_server_start (MockOdrsServer *self, GError **error)
 {
@@ -511,6 +665,7 @@ mock_odrs_server_add_app (MockOdrsServer *self, const gchar *id)
     if (app == NULL) {
         app = mock_app_new (id);
         g_ptr_array_add (self->apps, app);
+        g_hash_table_insert (self->apps_by_id, app->id, app);
     }
 
     return app;
@@ -521,13 +676,36 @@ mock_odrs_server_find_app (MockOdrsServer *self, const gchar *id)
 {
     g_return_val_if_fail (MOCK_IS_ODRS_SERVER (self), NULL);
 
-    for (guint i = 0; i < self->apps->len; i++) {
-        MockOdrsApp *app = g_ptr_array_index (self->apps, i);
-        if (g_strcmp0 (app->id, id) == 0)
-            return app;
+    if (id == NULL)
+        return NULL;
+
+    return g_hash_table_lookup (self->apps_by_id, id);
+}
+
+void
+mock_odrs_server_generate_ratings (MockOdrsServer *self, guint n_apps, guint32 seed)
+{
+    g_return_if_fail (MOCK_IS_ODRS_SERVER (self));
+
+    g_autoptr(GRand) rand = g_rand_new_with_seed (seed);
+    for (guint i = 0; i < n_apps; i++) {
+        g_autofree gchar *id = g_strdup_printf ("io.snapcraft.generated%u-GENERATED%u", i, i);
+        MockOdrsApp *app = mock_odrs_server_add_app (self, id);
+
+        /* Most apps have a few ratings, a few have many */
+        gint64 counts[6] = { 0 };
+        gint64 total = g_rand_double (rand) < 0.9 ? g_rand_int_range (rand, 0, 20) : g_rand_int_range (rand, 20, 5000);
+        for (gint64 j = 0; j < total; j++)
+            counts[g_rand_int_range (rand, 1, 6)]++;
+        mock_app_set_ratings (app, counts);
     }
+}
 
-    return NULL;
+void
+mock_app_set_ratings (MockOdrsApp *app, const gint64 *counts)
+{
+    for (int i = 0; i < 6; i++)
+        app->ratings[i] = counts[i];
 }
 
 MockReview *
@@ -538,6 +716,27 @@ mock_app_add_review (MockOdrsApp *app)
     return review;
 }
 
+void
+mock_app_generate_reviews (MockOdrsApp *app, guint n_reviews, guint32 seed)
+{
+    const gchar *summaries[] = { "Great app", "Does what it says", "Crashes on start", "Could be better", "Love it" };
+
+    g_autoptr(GRand) rand = g_rand_new_with_seed (seed);
+    for (guint i = 0; i < n_reviews; i++) {
+        MockReview *review = mock_app_add_review (app);
+        review->id = app->reviews->len;
+        mock_review_set_rating (review, g_rand_int_range (rand, 1, 6));
+        mock_review_set_summary (review, summaries[g_rand_int_range (rand, 0, G_N_ELEMENTS (summaries))]);
+        g_autofree gchar *description = g_strnfill (g_rand_int_range (rand, 20, 2000), 'x');
+        mock_review_set_description (review, description);
+        g_autofree gchar *user_display = g_strdup_printf ("User %u", g_rand_int (rand));
+        mock_review_set_user_display (review, user_display);
+        mock_review_set_locale (review, "en_US");
+        mock_review_set_version (review, "1.0");
+        mock_review_set_date_created (review, 1546300800 + g_rand_int_range (rand, 0, 31536000));
+    }
+}
+
 MockReview *
 mock_app_find_review (MockOdrsApp *app, gint64 id)
 {
@@ -24,12 +24,26 @@ void            mock_odrs_server_set_port    (MockOdrsServer *server, guint port
 
 guint           mock_odrs_server_get_port    (MockOdrsServer *server);
 
+void            mock_odrs_server_set_latency (MockOdrsServer *server, guint latency);
+
+void            mock_odrs_server_set_bandwidth (MockOdrsServer *server, gsize bytes_per_second);
+
+guint           mock_odrs_server_get_request_count (MockOdrsServer *server, const gchar *path);
+
+void            mock_odrs_server_reset_request_counts (MockOdrsServer *server);
+
 gboolean        mock_odrs_server_start       (MockOdrsServer *self, GError **error);
 
 MockOdrsApp    *mock_odrs_server_add_app     (MockOdrsServer *server, const gchar *id);
 
 MockOdrsApp    *mock_odrs_server_find_app    (MockOdrsServer *server, const gchar *id);
 
+void            mock_odrs_server_generate_ratings (MockOdrsServer *server, guint n_apps, guint32 seed);
+
+void            mock_app_set_ratings         (MockOdrsApp *app, const gint64 *counts);
+
+void            mock_app_generate_reviews    (MockOdrsApp *app, guint n_reviews, guint32 seed);
+
 MockReview     *mock_app_add_review          (MockOdrsApp *app);
 
 MockReview     *mock_app_find_review         (MockOdrsApp *app, gint64 id);
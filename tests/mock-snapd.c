@@ -36,8 +36,12 @@ struct _MockSnapd
     gchar *socket_path;
     gboolean close_on_request;
     gboolean decline_auth;
+    GHashTable *endpoints;
+    gsize bandwidth;
+    GRand *rand;
     GList *interfaces;
     GList *snaps;
+    GHashTable *snaps_by_name;
     gchar *build_id;
     gchar *confinement;
     GHashTable *sandbox_features;
@@ -53,6 +57,7 @@ struct _MockSnapd
     gchar *refresh_timer;
     GList *store_sections;
     GList *store_snaps;
+    GHashTable *store_snaps_by_name;
     GList *established_connections;
     GList *undesired_connections;
     GList *assertions;
@@ -65,6 +70,14 @@ struct _MockSnapd
 
 G_DEFINE_TYPE (MockSnapd, mock_snapd, G_TYPE_OBJECT)
 
+/* Simulated conditions for requests to paths starting with a given prefix */
+typedef struct
+{
+    guint latency;
+    guint jitter;
+    gdouble failure_rate;
+} MockEndpoint;
+
 struct _MockApp
 {
     gchar *name;
@@ -352,6 +365,59 @@ mock_snapd_set_decline_auth (MockSnapd *snapd, gboolean decline_auth)
     snapd->decline_auth = decline_auth;
 }
 
+static MockEndpoint *
+get_endpoint (MockSnapd *snapd, const gchar *path)
+{
+    if (path == NULL)
+        path = "/";
+
+    MockEndpoint *endpoint = g_hash_table_lookup (snapd->endpoints, path);
+    if (endpoint == NULL) {
+        endpoint = g_new0 (MockEndpoint, 1);
+        g_hash_table_insert (snapd->endpoints, g_strdup (path), endpoint);
+    }
+
+    return endpoint;
+}
+
+void
+mock_snapd_set_latency (MockSnapd *snapd, const gchar *path, guint latency, guint jitter)
+{
+    g_return_if_fail (MOCK_IS_SNAPD (snapd));
+
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&snapd->mutex);
+    MockEndpoint *endpoint = get_endpoint (snapd, path);
+    endpoint->latency = latency;
+    endpoint->jitter = jitter;
+}
+
+void
+mock_snapd_set_failure_rate (MockSnapd *snapd, const gchar *path, gdouble failure_rate)
+{
+    g_return_if_fail (MOCK_IS_SNAPD (snapd));
+
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&snapd->mutex);
+    get_endpoint (snapd, path)->failure_rate = failure_rate;
+}
+
+void
+mock_snapd_set_bandwidth (MockSnapd *snapd, gsize bytes_per_second)
+{
+    g_return_if_fail (MOCK_IS_SNAPD (snapd));
+
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&snapd->mutex);
+    snapd->bandwidth = bytes_per_second;
+}
+
+void
+mock_snapd_set_random_seed (MockSnapd *snapd, guint32 seed)
+{
+    g_return_if_fail (MOCK_IS_SNAPD (snapd));
+
+    g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&snapd->mutex);
+    g_rand_set_seed (snapd->rand, seed);
+}
+
 void
 mock_snapd_set_maintenance (MockSnapd *snapd, const gchar *kind, const gchar *message)
 {
@@ -641,6 +707,33 @@ mock_interface_set_doc_url (MockInterface *interface, const gchar *url)
     interface->doc_url = g_strdup (url);
 }
 
+static void
+add_installed_snap (MockSnapd *snapd, MockSnap *snap)
+{
+    snapd->snaps = g_list_append (snapd->snaps, snap);
+
+    /* Lookups return the first snap with a given name */
+    if (!g_hash_table_contains (snapd->snaps_by_name, snap->name))
+        g_hash_table_insert (snapd->snaps_by_name, snap->name, snap);
+}
+
+static void
+remove_installed_snap (MockSnapd *snapd, MockSnap *snap)
+{
+    snapd->snaps = g_list_remove (snapd->snaps, snap);
+
+    if (g_hash_table_lookup (snapd->snaps_by_name, snap->name) != snap)
+        return;
+    g_hash_table_remove (snapd->snaps_by_name, snap->name);
+    for (GList *link = snapd->snaps; link; link = link->next) {
+        MockSnap *s = link->data;
+        if (strcmp (s->name, snap->name) == 0) {
+            g_hash_table_insert (snapd->snaps_by_name, s->name, s);
+            break;
+        }
+    }
+}
+
 MockSnap *
 mock_snapd_add_snap (MockSnapd *snapd, const gchar *name)
 {
@@ -649,7 +742,7 @@ mock_snapd_add_snap (MockSnapd *snapd, const gchar *name)
     g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&snapd->mutex);
 
     MockSnap *snap = mock_snap_new (name);
-    snapd->snaps = g_list_append (snapd->snaps, snap);
+    add_installed_snap (snapd, snap);
 
     return snap;
 }
@@ -657,13 +750,7 @@ mock_snapd_add_snap (MockSnapd *snapd, const gchar *name)
 static MockSnap *
 find_snap (MockSnapd *snapd, const gchar *name)
 {
-    for (GList *link = snapd->snaps; link; link = link->next) {
-        MockSnap *snap = link->data;
-        if (strcmp (snap->name, name) == 0)
-            return snap;
-    }
-
-    return NULL;
+    return g_hash_table_lookup (snapd->snaps_by_name, name);
 }
 
 MockSnap *
@@ -695,6 +782,13 @@ mock_snapd_add_store_snap (MockSnapd *snapd, const gchar *name)
     snap->download_size = 65535;
     snapd->store_snaps = g_list_append (snapd->store_snaps, snap);
 
+    GPtrArray *snaps = g_hash_table_lookup (snapd->store_snaps_by_name, name);
+    if (snaps == NULL) {
+        snaps = g_ptr_array_new ();
+        g_hash_table_insert (snapd->store_snaps_by_name, g_strdup (name), snaps);
+    }
+    g_ptr_array_add (snaps, snap);
+
     mock_snap_add_track (snap, "latest");
 
     return snap;
@@ -703,10 +797,13 @@ mock_snapd_add_store_snap (MockSnapd *snapd, const gchar *name)
 static MockSnap *
 find_store_snap_by_name (MockSnapd *snapd, const gchar *name, const gchar *channel,  const gchar *revision)
 {
-    for (GList *link = snapd->store_snaps; link; link = link->next) {
-        MockSnap *snap = link->data;
-        if (strcmp (snap->name, name) == 0 &&
-            (channel == NULL || g_strcmp0 (snap->channel, channel) == 0) &&
+    GPtrArray *snaps = g_hash_table_lookup (snapd->store_snaps_by_name, name);
+    if (snaps == NULL)
+        return NULL;
+
+    for (guint i = 0; i < snaps->len; i++) {
+        MockSnap *snap = g_ptr_array_index (snaps, i);
+        if ((channel == NULL || g_strcmp0 (snap->channel, channel) == 0) &&
             (revision == NULL || g_strcmp0 (snap->revision, revision) == 0))
             return snap;
     }
@@ -1883,10 +1980,10 @@ get_refreshable_snaps (MockSnapd *snapd)
 
         snap = find_snap (snapd, store_snap->name);
         if (snap != NULL && strcmp (store_snap->revision, snap->revision) > 0)
-            refreshable_snaps = g_list_append (refreshable_snaps, store_snap);
+            refreshable_snaps = g_list_prepend (refreshable_snaps, store_snap);
     }
 
-    return g_steal_pointer (&refreshable_snaps);
+    return g_list_reverse (g_steal_pointer (&refreshable_snaps));
 }
 
 static gboolean
@@ -3050,11 +3147,13 @@ static void
 mock_task_complete (MockSnapd *snapd, MockTask *task)
 {
     if (strcmp (task->kind, "install") == 0 || strcmp (task->kind, "try") == 0)
-        snapd->snaps = g_list_append (snapd->snaps, g_steal_pointer (&task->snap));
+        add_installed_snap (snapd, g_steal_pointer (&task->snap));
     else if (strcmp (task->kind, "remove") == 0) {
         MockSnap *snap = find_snap (snapd, task->snap_name);
-        snapd->snaps = g_list_remove (snapd->snaps, snap);
-        mock_snap_free (snap);
+        if (snap != NULL) {
+            remove_installed_snap (snapd, snap);
+            mock_snap_free (snap);
+        }
     }
     mock_task_set_status (task, "Done");
 }
@@ -3258,9 +3357,17 @@ handle_find (MockSnapd *snapd, SoupMessage *message, GHashTable *query)
         }
     }
 
+    /* Name searches only need to check snaps with that name */
+    g_autoptr(GList) candidates = NULL;
+    if (name_param != NULL) {
+        GPtrArray *snaps = g_hash_table_lookup (snapd->store_snaps_by_name, name_param);
+        for (guint i = snaps != NULL ? snaps->len : 0; i > 0; i--)
+            candidates = g_list_prepend (candidates, g_ptr_array_index (snaps, i - 1));
+    }
+
     g_autoptr(JsonBuilder) builder = json_builder_new ();
     json_builder_begin_array (builder);
-    for (GList *link = snapd->store_snaps; link; link = link->next) {
+    for (GList *link = name_param != NULL ? candidates : snapd->store_snaps; link; link = link->next) {
         MockSnap *snap = link->data;
 
         if (!has_common_id (snap, common_id_param))
@@ -3302,8 +3409,55 @@ handle_sections (MockSnapd *snapd, SoupMessage *message)
     send_sync_response (snapd, message, 200, json_builder_get_root (builder));
 }
 
+static MockEndpoint *
+find_endpoint (MockSnapd *snapd, const gchar *path)
+{
+    /* Use the longest matching prefix, falling back to the defaults for all paths */
+    MockEndpoint *endpoint = NULL;
+    gsize prefix_length = 0;
+    GHashTableIter iter;
+    g_hash_table_iter_init (&iter, snapd->endpoints);
+    gpointer key, value;
+    while (g_hash_table_iter_next (&iter, &key, &value)) {
+        const gchar *prefix = key;
+        gsize length = strlen (prefix);
+        if (g_str_has_prefix (path, prefix) && (endpoint == NULL || length > prefix_length)) {
+            endpoint = value;
+            prefix_length = length;
+        }
+    }
+
+    return endpoint;
+}
+
+static guint
+get_response_delay (MockSnapd *snapd, MockEndpoint *endpoint, SoupMessage *message)
+{
+    gint64 delay = 0;
+
+    if (endpoint != NULL) {
+        delay = endpoint->latency;
+        if (endpoint->jitter > 0)
+            delay += g_rand_int_range (snapd->rand, -(gint32) endpoint->jitter, (gint32) endpoint->jitter + 1);
+    }
+
+    if (snapd->bandwidth > 0)
+        delay += message->response_body->length * 1000 / snapd->bandwidth;
+
+    return MAX (delay, 0);
+}
+
+static gboolean
+unpause_cb (gpointer user_data)
+{
+    SoupMessage *message = user_data;
+    SoupServer *server = g_object_get_data (G_OBJECT (message), "mock-snapd-server");
+    soup_server_unpause_message (server, message);
+    return G_SOURCE_REMOVE;
+}
+
 static void
-handle_request (SoupServer *server G_GNUC_UNUSED, SoupMessage *message, const gchar *path, GHashTable *query, SoupClientContext *client, gpointer user_data)
+handle_request (SoupServer *server, SoupMessage *message, const gchar *path, GHashTable *query, SoupClientContext *client, gpointer user_data)
 {
     MockSnapd *snapd = MOCK_SNAPD (user_data);
 
@@ -3321,7 +3475,10 @@ handle_request (SoupServer *server G_GNUC_UNUSED, SoupMessage *message, const gc
     g_clear_pointer (&snapd->last_request_headers, soup_message_headers_free);
     snapd->last_request_headers = g_boxed_copy (SOUP_TYPE_MESSAGE_HEADERS, message->request_headers);
 
-    if (strcmp (path, "/v2/system-info") == 0)
+    MockEndpoint *endpoint = find_endpoint (snapd, path);
+    if (endpoint != NULL && endpoint->failure_rate > 0 && g_rand_double (snapd->rand) < endpoint->failure_rate)
+        send_error_response (snapd, message, 500, "simulated failure", "internal-error");
+    else if (strcmp (path, "/v2/system-info") == 0)
         handle_system_info (snapd, message);
     else if (strcmp (path, "/v2/snaps") == 0)
         handle_snaps (snapd, message, query);
@@ -3349,6 +3506,18 @@ handle_request (SoupServer *server G_GNUC_UNUSED, SoupMessage *message, const gc
         handle_sections (snapd, message);
     else
         send_error_not_found (snapd, message, "not found", NULL);
+
+    /* Hold back the response to simulate a slow snapd or store connection */
+    if (message->status_code == SOUP_STATUS_NONE)
+        return;
+    guint delay = get_response_delay (snapd, endpoint, message);
+    if (delay == 0)
+        return;
+    soup_server_pause_message (server, message);
+    g_object_set_data_full (G_OBJECT (message), "mock-snapd-server", g_object_ref (server), g_object_unref);
+    g_autoptr(GSource) source = g_timeout_source_new (delay);
+    g_source_set_callback (source, unpause_cb, g_object_ref (message), g_object_unref);
+    g_source_attach (source, snapd->context);
 }
 
 static gboolean
@@ -3378,6 +3547,9 @@ mock_snapd_finalize (GObject *object)
     g_clear_pointer (&snapd->socket_path, g_free);
     g_list_free_full (snapd->interfaces, (GDestroyNotify) mock_interface_free);
     snapd->interfaces = NULL;
+    g_clear_pointer (&snapd->endpoints, g_hash_table_unref);
+    g_clear_pointer (&snapd->rand, g_rand_free);
+    g_clear_pointer (&snapd->snaps_by_name, g_hash_table_unref);
     g_list_free_full (snapd->snaps, (GDestroyNotify) mock_snap_free);
     snapd->snaps = NULL;
     g_free (snapd->build_id);
@@ -3393,6 +3565,7 @@ mock_snapd_finalize (GObject *object)
     g_free (snapd->refresh_timer);
     g_list_free_full (snapd->store_sections, g_free);
     snapd->store_sections = NULL;
+    g_clear_pointer (&snapd->store_snaps_by_name, g_hash_table_unref);
     g_list_free_full (snapd->store_snaps, (GDestroyNotify) mock_snap_free);
     snapd->store_snaps = NULL;
     g_list_free_full (snapd->established_connections, (GDestroyNotify) mock_connection_free);
@@ -3542,7 +3715,11 @@ mock_snapd_init (MockSnapd *snapd)
     g_mutex_init (&snapd->mutex);
     g_cond_init (&snapd->condition);
 
+    snapd->endpoints = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    snapd->rand = g_rand_new_with_seed (0);
     snapd->sandbox_features = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+    snapd->snaps_by_name = g_hash_table_new (g_str_hash, g_str_equal);
+    snapd->store_snaps_by_name = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
     g_autoptr(GError) error = NULL;
     snapd->dir_path = g_dir_make_tmp ("mock-snapd-XXXXXX", &error);
     if (snapd->dir_path == NULL)
@@ -44,6 +44,14 @@ void           mock_snapd_set_close_on_request       (MockSnapd *snapd, gboolean
 
 void           mock_snapd_set_decline_auth           (MockSnapd *snapd, gboolean decline_auth);
 
+void           mock_snapd_set_latency                (MockSnapd *snapd, const gchar *path, guint latency, guint jitter);
+
+void           mock_snapd_set_failure_rate           (MockSnapd *snapd, const gchar *path, gdouble failure_rate);
+
+void           mock_snapd_set_bandwidth              (MockSnapd *snapd, gsize bytes_per_second);
+
+void           mock_snapd_set_random_seed            (MockSnapd *snapd, guint32 seed);
+
 gboolean       mock_snapd_start                      (MockSnapd *snapd, GError **error);
 
 void           mock_snapd_stop                       (MockSnapd *snapd);
@@ -0,0 +1,1028 @@
+/*
+ * Copyright (C) 2019 Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "mock-odrs-server.h"
+#include "mock-snapd.h"
+#include "store-cache.h"
+#include "store-category.h"
+#include "store-model.h"
+#include "store-progress.h"
+#include "store-snap-app.h"
+#include "store-trace.h"
+
+static void
+notify_cb (GObject *object G_GNUC_UNUSED, GParamSpec *pspec G_GNUC_UNUSED, guint *count)
+{
+    (*count)++;
+}
+
+static void
+test_cache_insert (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+
+    g_autoptr(GBytes) data = g_bytes_new_static ("DATA", 4);
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_cache_insert (cache, "test", "insert", FALSE, data, NULL, &error));
+    g_assert_no_error (error);
+
+    g_autoptr(GBytes) cached_data = store_cache_lookup_sync (cache, "test", "insert", FALSE, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_nonnull (cached_data);
+    g_assert_true (g_bytes_equal (data, cached_data));
+}
+
+static void
+test_cache_hash (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+
+    g_autoptr(GBytes) data = g_bytes_new_static ("DATA", 4);
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_cache_insert (cache, "test", "http://example.com/image.png", TRUE, data, NULL, &error));
+    g_assert_no_error (error);
+
+    g_autoptr(GBytes) cached_data = store_cache_lookup_sync (cache, "test", "http://example.com/image.png", TRUE, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_true (g_bytes_equal (data, cached_data));
+}
+
+static void
+test_cache_missing (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GBytes) cached_data = store_cache_lookup_sync (cache, "test", "missing", FALSE, NULL, &error);
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+    g_assert_null (cached_data);
+}
+
+static void
+test_cache_json (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+
+    g_autoptr(JsonNode) node = json_from_string ("{\"name\": \"alpha\", \"count\": 42}", NULL);
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_cache_insert_json (cache, "test", "json", FALSE, node, NULL, &error));
+    g_assert_no_error (error);
+
+    g_autoptr(JsonNode) cached_node = store_cache_lookup_json (cache, "test", "json", FALSE, NULL, &error);
+    g_assert_no_error (error);
+    g_assert_true (json_node_equal (node, cached_node));
+}
+
+static guint64
+get_stat (GVariant *stats, const gchar *type, const gchar *name)
+{
+    g_autoptr(GVariant) values = g_variant_lookup_value (stats, type, G_VARIANT_TYPE ("a{st}"));
+    g_assert_nonnull (values);
+    guint64 value = 0;
+    g_assert_true (g_variant_lookup (values, name, "t", &value));
+    return value;
+}
+
+static void
+test_cache_stats (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+
+    g_autoptr(GBytes) data = g_bytes_new_static ("DATA", 4);
+    store_cache_insert (cache, "stats", "present", FALSE, data, NULL, NULL);
+    g_autoptr(GBytes) cached_data = store_cache_lookup_sync (cache, "stats", "present", FALSE, NULL, NULL);
+    g_autoptr(GBytes) missing_data = store_cache_lookup_sync (cache, "stats", "missing", FALSE, NULL, NULL);
+
+    g_autoptr(GVariant) stats = store_cache_get_stats (cache);
+    g_assert_cmpint (get_stat (stats, "stats", "writes"), ==, 1);
+    g_assert_cmpint (get_stat (stats, "stats", "bytes-written"), ==, 4);
+    g_assert_cmpint (get_stat (stats, "stats", "hits"), ==, 1);
+    g_assert_cmpint (get_stat (stats, "stats", "misses"), ==, 1);
+    g_assert_cmpint (get_stat (stats, "stats", "bytes-read"), ==, 4);
+    g_assert_cmpint (get_stat (stats, "stats", "errors"), ==, 0);
+}
+
+static void
+test_app_cache (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+
+    g_autoptr(StoreSnapApp) app = store_snap_app_new ();
+    store_app_set_name (STORE_APP (app), "cached");
+    store_app_set_appstream_id (STORE_APP (app), "io.snapcraft.cached-ID");
+    store_app_set_title (STORE_APP (app), "Cached");
+    store_app_set_summary (STORE_APP (app), "SUMMARY");
+    store_app_set_description (STORE_APP (app), "DESCRIPTION");
+    store_app_set_publisher (STORE_APP (app), "PUBLISHER");
+    store_app_set_publisher_validated (STORE_APP (app), TRUE);
+    store_app_set_license (STORE_APP (app), "GPL-3.0");
+    store_app_set_version (STORE_APP (app), "1.2");
+    store_app_save_to_cache (STORE_APP (app), cache);
+
+    g_autoptr(StoreSnapApp) cached_app = store_snap_app_new ();
+    store_app_set_name (STORE_APP (cached_app), "cached");
+    store_app_update_from_cache (STORE_APP (cached_app), cache);
+    g_assert_cmpstr (store_app_get_appstream_id (STORE_APP (cached_app)), ==, "io.snapcraft.cached-ID");
+    g_assert_cmpstr (store_app_get_title (STORE_APP (cached_app)), ==, "Cached");
+    g_assert_cmpstr (store_app_get_summary (STORE_APP (cached_app)), ==, "SUMMARY");
+    g_assert_cmpstr (store_app_get_description (STORE_APP (cached_app)), ==, "DESCRIPTION");
+    g_assert_cmpstr (store_app_get_publisher (STORE_APP (cached_app)), ==, "PUBLISHER");
+    g_assert_true (store_app_get_publisher_validated (STORE_APP (cached_app)));
+    g_assert_cmpstr (store_app_get_license (STORE_APP (cached_app)), ==, "GPL-3.0");
+    g_assert_cmpstr (store_app_get_version (STORE_APP (cached_app)), ==, "1.2");
+}
+
+static void
+test_app_update_notify (void)
+{
+    g_autoptr(StoreSnapApp) app = store_snap_app_new ();
+    guint n_notifies = 0;
+    g_signal_connect (app, "notify::title", G_CALLBACK (notify_cb), &n_notifies);
+
+    /* Multiple changes in an update only notify once */
+    store_app_begin_update (STORE_APP (app));
+    store_app_set_title (STORE_APP (app), "ONE");
+    store_app_set_title (STORE_APP (app), "TWO");
+    store_app_end_update (STORE_APP (app));
+    g_assert_cmpint (n_notifies, ==, 1);
+
+    /* Setting the same value doesn't notify */
+    store_app_set_title (STORE_APP (app), "TWO");
+    g_assert_cmpint (n_notifies, ==, 1);
+}
+
+static void
+test_category_apps (void)
+{
+    g_autoptr(StoreCategory) category = store_category_new ();
+    guint n_notifies = 0;
+    g_signal_connect (category, "notify::apps", G_CALLBACK (notify_cb), &n_notifies);
+
+    g_autoptr(GPtrArray) apps = g_ptr_array_new_with_free_func (g_object_unref);
+    g_ptr_array_add (apps, store_snap_app_new ());
+    store_category_set_apps (category, apps);
+    g_assert_cmpint (n_notifies, ==, 1);
+    g_assert_cmpint (store_category_get_apps (category)->len, ==, 1);
+}
+
+static void
+test_progress_update (void)
+{
+    g_autoptr(StoreProgress) progress = store_progress_new ();
+    guint n_notifies = 0;
+    g_signal_connect (progress, "notify", G_CALLBACK (notify_cb), &n_notifies);
+
+    store_progress_update (progress, 10, 100, "Downloading");
+    g_assert_cmpint (store_progress_get_done (progress), ==, 10);
+    g_assert_cmpint (store_progress_get_total (progress), ==, 100);
+    g_assert_cmpstr (store_progress_get_label (progress), ==, "Downloading");
+    g_assert_cmpint (n_notifies, ==, 3);
+
+    /* Only changed values notify */
+    store_progress_update (progress, 20, 100, "Downloading");
+    g_assert_cmpint (n_notifies, ==, 4);
+}
+
+static void
+test_model_get_snap (void)
+{
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    g_autoptr(StoreSnapApp) app1 = store_model_get_snap (model, "alpha");
+    g_autoptr(StoreSnapApp) app2 = store_model_get_snap (model, "alpha");
+    g_autoptr(StoreSnapApp) app3 = store_model_get_snap (model, "bravo");
+    g_assert_true (app1 == app2);
+    g_assert_true (app1 != app3);
+    g_assert_cmpstr (store_app_get_name (STORE_APP (app1)), ==, "alpha");
+    g_assert_cmpstr (store_app_get_name (STORE_APP (app3)), ==, "bravo");
+}
+
+static void
+test_model_get_snap_cached (void)
+{
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    g_autoptr(StoreSnapApp) app = store_snap_app_new ();
+    store_app_set_name (STORE_APP (app), "charlie");
+    store_app_set_title (STORE_APP (app), "Charlie");
+    store_app_save_to_cache (STORE_APP (app), store_model_get_cache (model));
+
+    g_autoptr(StoreSnapApp) model_app = store_model_get_snap (model, "charlie");
+    g_assert_cmpstr (store_app_get_title (STORE_APP (model_app)), ==, "Charlie");
+}
+
+static void
+test_model_media_policy (void)
+{
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    store_model_set_media_policy (model, STORE_MEDIA_POLICY_ICONS_ONLY);
+    g_assert_cmpint (store_model_get_media_policy (model), ==, STORE_MEDIA_POLICY_ICONS_ONLY);
+
+    /* Automatic always resolves to a concrete policy */
+    store_model_set_media_policy (model, STORE_MEDIA_POLICY_AUTOMATIC);
+    g_assert_cmpint (store_model_get_media_policy (model), !=, STORE_MEDIA_POLICY_AUTOMATIC);
+}
+
+static void
+test_media_policy_for_network (void)
+{
+    /* Unmeasured networks are assumed to be fast */
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_FULL, FALSE, 0), ==, STORE_MEDIA_POLICY_FULL);
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_FULL, FALSE, 1000000), ==, STORE_MEDIA_POLICY_FULL);
+
+    /* Metered or slow delays screenshots, both only gets icons */
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_FULL, TRUE, 0), ==, STORE_MEDIA_POLICY_DEFER_SCREENSHOTS);
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_FULL, FALSE, 50000), ==, STORE_MEDIA_POLICY_DEFER_SCREENSHOTS);
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_FULL, TRUE, 50000), ==, STORE_MEDIA_POLICY_ICONS_ONLY);
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_FULL, TRUE, 1000000), ==, STORE_MEDIA_POLICY_DEFER_SCREENSHOTS);
+
+    /* Without full connectivity only icons, however fast */
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_LOCAL, FALSE, 1000000), ==, STORE_MEDIA_POLICY_ICONS_ONLY);
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_LIMITED, FALSE, 0), ==, STORE_MEDIA_POLICY_ICONS_ONLY);
+    g_assert_cmpint (store_media_policy_for_network (G_NETWORK_CONNECTIVITY_PORTAL, FALSE, 0), ==, STORE_MEDIA_POLICY_ICONS_ONLY);
+}
+
+/* Image requests are held by the server until released, so the order they are sent in can be checked */
+typedef struct
+{
+    GPtrArray *paths;
+    GQueue *held;
+    guint max_held;
+    guint n_done;
+    guint n_requests;
+} ImageRequests;
+
+static void
+image_requests_clear (ImageRequests *requests)
+{
+    g_clear_pointer (&requests->paths, g_ptr_array_unref);
+    if (requests->held != NULL)
+        g_queue_free_full (g_steal_pointer (&requests->held), g_object_unref);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC (ImageRequests, image_requests_clear)
+
+static void
+held_image_cb (SoupServer *server, SoupMessage *msg, const gchar *path, GHashTable *query G_GNUC_UNUSED, SoupClientContext *context G_GNUC_UNUSED, gpointer user_data)
+{
+    ImageRequests *requests = user_data;
+
+    g_ptr_array_add (requests->paths, g_strdup (path));
+    g_queue_push_tail (requests->held, g_object_ref (msg));
+    requests->max_held = MAX (requests->max_held, g_queue_get_length (requests->held));
+    requests->n_requests++;
+    soup_server_pause_message (server, msg);
+}
+
+static MockOdrsServer *
+start_image_server (ImageRequests *requests)
+{
+    requests->paths = g_ptr_array_new_with_free_func (g_free);
+    requests->held = g_queue_new ();
+
+    MockOdrsServer *server = mock_odrs_server_new ();
+    soup_server_add_handler (SOUP_SERVER (server), "/images", held_image_cb, requests, NULL);
+    g_autoptr(GError) error = NULL;
+    g_assert_true (mock_odrs_server_start (server, &error));
+    g_assert_no_error (error);
+
+    return server;
+}
+
+static void
+release_image (MockOdrsServer *server, ImageRequests *requests)
+{
+    g_autoptr(SoupMessage) msg = g_queue_pop_head (requests->held);
+    g_assert_nonnull (msg);
+    soup_message_set_status (msg, SOUP_STATUS_NOT_FOUND);
+    soup_server_unpause_message (SOUP_SERVER (server), msg);
+}
+
+static gboolean
+wait_timeout_cb (gboolean *timed_out)
+{
+    *timed_out = TRUE;
+    return G_SOURCE_REMOVE;
+}
+
+/* Iterate until a counter reaches a value, the timeout only catches it never doing so */
+static void
+wait_for_count (const guint *count, guint value)
+{
+    gboolean timed_out = FALSE;
+    guint timeout_id = g_timeout_add_seconds (10, (GSourceFunc) wait_timeout_cb, &timed_out);
+    while (*count < value && !timed_out)
+        g_main_context_iteration (NULL, TRUE);
+    g_assert_false (timed_out);
+    g_source_remove (timeout_id);
+}
+
+static void
+download_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    ImageRequests *requests = user_data;
+
+    store_model_download_image_finish (STORE_MODEL (object), result, NULL);
+    requests->n_done++;
+}
+
+static void
+download_image (StoreModel *model, MockOdrsServer *server, ImageRequests *requests, const gchar *name, StoreImagePriority priority, GCancellable *cancellable)
+{
+    g_autofree gchar *uri = g_strdup_printf ("http://localhost:%u/images/%s", mock_odrs_server_get_port (server), name);
+    store_model_download_image_async (model, uri, NULL, priority, cancellable, download_cb, requests);
+}
+
+static void
+finish_images (MockOdrsServer *server, ImageRequests *requests, guint n_requests)
+{
+    while (requests->n_done < n_requests) {
+        if (!g_queue_is_empty (requests->held))
+            release_image (server, requests);
+        g_main_context_iteration (NULL, TRUE);
+    }
+}
+
+static void
+test_model_image_host_limit (void)
+{
+    g_auto(ImageRequests) requests = { NULL };
+    g_autoptr(MockOdrsServer) server = start_image_server (&requests);
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    /* Only six requests are sent to a host at once, the server holds them so the most in flight is what it has held */
+    for (int i = 0; i < 8; i++) {
+        g_autofree gchar *name = g_strdup_printf ("screenshot%d", i);
+        download_image (model, server, &requests, name, STORE_IMAGE_PRIORITY_SCREENSHOT, NULL);
+    }
+    wait_for_count (&requests.n_requests, 6);
+
+    /* Each one finishing lets the next start */
+    release_image (server, &requests);
+    wait_for_count (&requests.n_requests, 7);
+    finish_images (server, &requests, 8);
+    g_assert_cmpint (requests.n_requests, ==, 8);
+    g_assert_cmpint (requests.max_held, ==, 6);
+
+    /* Prefetches only get two */
+    requests.max_held = 0;
+    for (int i = 0; i < 3; i++) {
+        g_autofree gchar *name = g_strdup_printf ("prefetch%d", i);
+        download_image (model, server, &requests, name, STORE_IMAGE_PRIORITY_PREFETCH, NULL);
+    }
+    wait_for_count (&requests.n_requests, 10);
+    finish_images (server, &requests, 11);
+    g_assert_cmpint (requests.max_held, ==, 2);
+}
+
+static void
+test_model_image_priority (void)
+{
+    g_auto(ImageRequests) requests = { NULL };
+    g_autoptr(MockOdrsServer) server = start_image_server (&requests);
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    for (int i = 0; i < 6; i++) {
+        g_autofree gchar *name = g_strdup_printf ("block%d", i);
+        download_image (model, server, &requests, name, STORE_IMAGE_PRIORITY_ICON, NULL);
+    }
+    wait_for_count (&requests.n_requests, 6);
+
+    /* Only the request with the given cancellable is raised, not others for the same image */
+    g_autoptr(GCancellable) shared_cancellable = g_cancellable_new ();
+    g_autoptr(GCancellable) raised_cancellable = g_cancellable_new ();
+    download_image (model, server, &requests, "shared", STORE_IMAGE_PRIORITY_PREFETCH, shared_cancellable);
+    download_image (model, server, &requests, "screenshot", STORE_IMAGE_PRIORITY_SCREENSHOT, NULL);
+    download_image (model, server, &requests, "shared", STORE_IMAGE_PRIORITY_PREFETCH, raised_cancellable);
+    download_image (model, server, &requests, "banner", STORE_IMAGE_PRIORITY_BANNER, NULL);
+    download_image (model, server, &requests, "icon", STORE_IMAGE_PRIORITY_ICON, NULL);
+    store_model_set_image_priority (model, raised_cancellable, STORE_IMAGE_PRIORITY_BANNER);
+
+    /* Highest priority first, oldest first within a priority. Only one connection is freed at a time, so each is sent in turn */
+    while (requests.n_requests < 11) {
+        release_image (server, &requests);
+        wait_for_count (&requests.n_requests, requests.n_requests + 1);
+    }
+    g_assert_cmpstr (g_ptr_array_index (requests.paths, 6), ==, "/images/icon");
+    g_assert_cmpstr (g_ptr_array_index (requests.paths, 7), ==, "/images/shared");
+    g_assert_cmpstr (g_ptr_array_index (requests.paths, 8), ==, "/images/banner");
+    g_assert_cmpstr (g_ptr_array_index (requests.paths, 9), ==, "/images/screenshot");
+    g_assert_cmpstr (g_ptr_array_index (requests.paths, 10), ==, "/images/shared");
+    finish_images (server, &requests, 11);
+}
+
+static void
+cancelled_download_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    GError **error = user_data;
+
+    g_assert_false (store_model_download_image_finish (STORE_MODEL (object), result, error));
+}
+
+static void
+test_model_image_cancel (void)
+{
+    g_auto(ImageRequests) requests = { NULL };
+    g_autoptr(MockOdrsServer) server = start_image_server (&requests);
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    for (int i = 0; i < 6; i++) {
+        g_autofree gchar *name = g_strdup_printf ("block%d", i);
+        download_image (model, server, &requests, name, STORE_IMAGE_PRIORITY_ICON, NULL);
+    }
+    wait_for_count (&requests.n_requests, 6);
+
+    /* Queued requests complete as soon as they are cancelled, without waiting for a connection */
+    g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+    g_autofree gchar *uri = g_strdup_printf ("http://localhost:%u/images/cancelled", mock_odrs_server_get_port (server));
+    g_autoptr(GError) error = NULL;
+    store_model_download_image_async (model, uri, NULL, STORE_IMAGE_PRIORITY_ICON, cancellable, cancelled_download_cb, &error);
+    g_cancellable_cancel (cancellable);
+    while (error == NULL)
+        g_main_context_iteration (NULL, TRUE);
+    g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+    /* Including ones cancelled before they are queued */
+    g_autoptr(GError) early_error = NULL;
+    store_model_download_image_async (model, uri, NULL, STORE_IMAGE_PRIORITY_ICON, cancellable, cancelled_download_cb, &early_error);
+    while (early_error == NULL)
+        g_main_context_iteration (NULL, TRUE);
+    g_assert_error (early_error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+    /* And are never sent, a request queued after them is the next to reach the server */
+    download_image (model, server, &requests, "after", STORE_IMAGE_PRIORITY_ICON, NULL);
+    finish_images (server, &requests, 7);
+    g_assert_cmpint (requests.n_requests, ==, 7);
+    g_assert_cmpstr (g_ptr_array_index (requests.paths, 6), ==, "/images/after");
+}
+
+static void
+count_request_cb (guint *n_requests)
+{
+    (*n_requests)++;
+}
+
+typedef struct
+{
+    guint n_done;
+    GError *error;
+} ReviewsResult;
+
+static void
+update_reviews_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    ReviewsResult *reviews_result = user_data;
+
+    g_assert_false (store_model_update_reviews_finish (STORE_MODEL (object), result, &reviews_result->error));
+    reviews_result->n_done++;
+}
+
+static void
+test_model_reviews_cancel (void)
+{
+    /* Slow enough that the request would time out the test if the transfer carried on after being cancelled */
+    g_autoptr(MockOdrsServer) server = mock_odrs_server_new ();
+    mock_odrs_server_add_app (server, "io.snapcraft.one-ID");
+    mock_odrs_server_set_latency (server, 30000);
+    guint n_requests = 0;
+    g_signal_connect_swapped (server, "request-read", G_CALLBACK (count_request_cb), &n_requests);
+    g_autoptr(GError) error = NULL;
+    g_assert_true (mock_odrs_server_start (server, &error));
+    g_assert_no_error (error);
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    g_autofree gchar *odrs_server_uri = g_strdup_printf ("http://localhost:%u", mock_odrs_server_get_port (server));
+    store_model_set_odrs_server_uri (model, odrs_server_uri);
+    g_autoptr(StoreSnapApp) app = store_model_get_snap (model, "one");
+    store_app_set_appstream_id (STORE_APP (app), "io.snapcraft.one-ID");
+
+    /* Cancelled once the server has the request */
+    g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+    ReviewsResult result = { 0 };
+    store_model_update_reviews_async (model, STORE_APP (app), cancellable, update_reviews_cb, &result);
+    wait_for_count (&n_requests, 1);
+    g_cancellable_cancel (cancellable);
+    wait_for_count (&result.n_done, 1);
+    g_assert_error (result.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_clear_error (&result.error);
+}
+
+static MockSnapd *
+start_snapd (void)
+{
+    MockSnapd *snapd = mock_snapd_new ();
+    g_autoptr(GError) error = NULL;
+    g_assert_true (mock_snapd_start (snapd, &error));
+    g_assert_no_error (error);
+    return snapd;
+}
+
+/* Operations record the order they complete in */
+typedef struct
+{
+    GPtrArray *completed;
+    guint n_completed;
+} OperationLog;
+
+typedef struct
+{
+    OperationLog *log;
+    const gchar *name;
+    GError *error;
+} OperationResult;
+
+static void
+operation_completed (OperationResult *result)
+{
+    g_ptr_array_add (result->log->completed, (gpointer) result->name);
+    result->log->n_completed++;
+}
+
+static void
+install_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    OperationResult *operation_result = user_data;
+
+    store_model_install_finish (STORE_MODEL (object), result, &operation_result->error);
+    operation_completed (operation_result);
+}
+
+static void
+remove_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    OperationResult *operation_result = user_data;
+
+    store_model_remove_finish (STORE_MODEL (object), result, &operation_result->error);
+    operation_completed (operation_result);
+}
+
+static void
+refresh_all_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    OperationResult *operation_result = user_data;
+
+    store_model_refresh_all_finish (STORE_MODEL (object), result, &operation_result->error);
+    operation_completed (operation_result);
+}
+
+static void
+update_updates_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    guint *n_done = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_model_update_updates_finish (STORE_MODEL (object), result, &error));
+    g_assert_no_error (error);
+    (*n_done)++;
+}
+
+static void
+test_model_refresh_all_conflict (void)
+{
+    g_autoptr(MockSnapd) snapd = start_snapd ();
+    mock_snap_set_revision (mock_snapd_add_snap (snapd, "alpha"), "1");
+    mock_snap_set_revision (mock_snapd_add_store_snap (snapd, "alpha"), "2");
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+    guint n_updates_done = 0;
+    store_model_update_updates_async (model, NULL, update_updates_cb, &n_updates_done);
+    wait_for_count (&n_updates_done, 1);
+    g_assert_cmpint (store_model_get_updates (model)->len, ==, 1);
+
+    /* Removing a snap a refresh-all is updating would conflict in snapd */
+    g_autoptr(GPtrArray) completed = g_ptr_array_new ();
+    OperationLog log = { completed, 0 };
+    OperationResult refresh_result = { &log, "refresh-all", NULL };
+    store_model_refresh_all_async (model, NULL, refresh_all_cb, &refresh_result);
+    g_autoptr(StoreSnapApp) app = store_model_get_snap (model, "alpha");
+    OperationResult remove_result = { &log, "remove", NULL };
+    store_model_remove_async (model, STORE_APP (app), NULL, remove_cb, &remove_result);
+
+    wait_for_count (&log.n_completed, 2);
+    g_assert_cmpstr (g_ptr_array_index (completed, 0), ==, "remove");
+    g_assert_error (remove_result.error, G_IO_ERROR, G_IO_ERROR_PENDING);
+    g_assert_no_error (refresh_result.error);
+    g_assert_nonnull (mock_snapd_find_snap (snapd, "alpha"));
+    g_clear_error (&remove_result.error);
+}
+
+static void
+cache_solid_image (StoreCache *cache, const gchar *uri, guint32 color)
+{
+    g_autoptr(GdkPixbuf) pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 100, 100);
+    gdk_pixbuf_fill (pixbuf, color);
+    gchar *buffer;
+    gsize buffer_length;
+    g_autoptr(GError) error = NULL;
+    g_assert_true (gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &buffer_length, "png", &error, NULL));
+    g_assert_no_error (error);
+    g_autoptr(GBytes) data = g_bytes_new_take (buffer, buffer_length);
+    store_cache_insert (cache, "images", uri, TRUE, data, NULL, NULL);
+}
+
+static void
+cached_image_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    GdkPixbuf **pixbuf = user_data;
+
+    g_autoptr(GError) error = NULL;
+    *pixbuf = store_model_get_cached_image_finish (STORE_MODEL (object), result, &error);
+    g_assert_no_error (error);
+}
+
+/* Returns the red component of the image */
+static guint8
+get_cached_image_red (StoreModel *model, const gchar *uri, const gchar *etag)
+{
+    g_autoptr(GdkPixbuf) pixbuf = NULL;
+    store_model_get_cached_image_async (model, uri, etag, 20, 20, NULL, cached_image_cb, &pixbuf);
+    while (pixbuf == NULL)
+        g_main_context_iteration (NULL, TRUE);
+    g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, 20);
+    return gdk_pixbuf_get_pixels (pixbuf)[0];
+}
+
+static gboolean
+has_thumbnail (StoreCache *cache, const gchar *name, const gchar *etag)
+{
+    g_autoptr(JsonNode) metadata = store_cache_lookup_json (cache, "thumbnail-metadata", name, TRUE, NULL, NULL);
+    return metadata != NULL && g_strcmp0 (json_object_get_string_member (json_node_get_object (metadata), "etag"), etag) == 0;
+}
+
+/* Thumbnails are encoded in a thread and saved once done */
+static void
+wait_for_thumbnail (StoreCache *cache, const gchar *name, const gchar *etag)
+{
+    gboolean timed_out = FALSE;
+    guint timeout_id = g_timeout_add_seconds (10, (GSourceFunc) wait_timeout_cb, &timed_out);
+    while (!has_thumbnail (cache, name, etag) && !timed_out)
+        g_main_context_iteration (NULL, TRUE);
+    g_assert_false (timed_out);
+    g_source_remove (timeout_id);
+}
+
+static void
+test_model_thumbnail_replaced (void)
+{
+    const gchar *uri = "http://localhost/images/screenshot.png";
+    g_autoptr(StoreCache) cache = store_cache_new ();
+    g_autoptr(StoreModel) model = store_model_new ();
+
+    /* Decoding the original at a small size saves a thumbnail */
+    cache_solid_image (cache, uri, 0xff0000ff);
+    g_assert_cmpint (get_cached_image_red (model, uri, "\"one\""), ==, 0xff);
+    wait_for_thumbnail (cache, "http://localhost/images/screenshot.png@20x20", "\"one\"");
+
+    /* A new copy of the original doesn't use the old thumbnail, and its thumbnail replaces it */
+    cache_solid_image (cache, uri, 0x0000ffff);
+    g_assert_cmpint (get_cached_image_red (model, uri, "\"two\""), ==, 0x00);
+    wait_for_thumbnail (cache, "http://localhost/images/screenshot.png@20x20", "\"two\"");
+    g_auto(GStrv) thumbnails = store_cache_list_sync (cache, "thumbnails", NULL, NULL);
+    g_assert_cmpint (g_strv_length (thumbnails), ==, 1);
+
+    /* Which is then used */
+    g_assert_cmpint (get_cached_image_red (model, uri, "\"two\""), ==, 0x00);
+}
+
+static void
+test_model_operation_order (void)
+{
+    g_autoptr(MockSnapd) snapd = start_snapd ();
+    mock_snapd_add_store_snap (snapd, "alpha");
+    mock_snapd_add_store_snap (snapd, "charlie");
+    mock_snapd_add_snap (snapd, "bravo");
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+    g_autoptr(StoreSnapApp) alpha = store_model_get_snap (model, "alpha");
+    g_autoptr(StoreSnapApp) bravo = store_model_get_snap (model, "bravo");
+    g_autoptr(StoreSnapApp) charlie = store_model_get_snap (model, "charlie");
+
+    /* The first starts straight away, the others wait in the order they were made */
+    g_autoptr(GPtrArray) completed = g_ptr_array_new ();
+    OperationLog log = { completed, 0 };
+    OperationResult alpha_result = { &log, "alpha", NULL };
+    OperationResult bravo_result = { &log, "bravo", NULL };
+    OperationResult charlie_result = { &log, "charlie", NULL };
+    store_model_install_async (model, STORE_APP (alpha), NULL, NULL, install_cb, &alpha_result);
+    store_model_remove_async (model, STORE_APP (bravo), NULL, remove_cb, &bravo_result);
+    store_model_install_async (model, STORE_APP (charlie), NULL, NULL, install_cb, &charlie_result);
+    g_assert_cmpint (store_app_get_state (STORE_APP (bravo)), ==, STORE_APP_STATE_QUEUED);
+    g_assert_cmpint (store_app_get_queue_position (STORE_APP (bravo)), ==, 1);
+    g_assert_cmpint (store_app_get_queue_position (STORE_APP (charlie)), ==, 2);
+
+    /* The installs aren't grouped past the remove between them */
+    wait_for_count (&log.n_completed, 3);
+    g_assert_no_error (alpha_result.error);
+    g_assert_no_error (bravo_result.error);
+    g_assert_no_error (charlie_result.error);
+    g_assert_cmpstr (g_ptr_array_index (completed, 0), ==, "alpha");
+    g_assert_cmpstr (g_ptr_array_index (completed, 1), ==, "bravo");
+    g_assert_cmpstr (g_ptr_array_index (completed, 2), ==, "charlie");
+    g_assert_nonnull (mock_snapd_find_snap (snapd, "alpha"));
+    g_assert_null (mock_snapd_find_snap (snapd, "bravo"));
+    g_assert_nonnull (mock_snapd_find_snap (snapd, "charlie"));
+}
+
+static void
+test_model_operation_cancel_queued (void)
+{
+    g_autoptr(MockSnapd) snapd = start_snapd ();
+    mock_snapd_add_store_snap (snapd, "alpha");
+    mock_snapd_add_snap (snapd, "bravo");
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+    g_autoptr(StoreSnapApp) alpha = store_model_get_snap (model, "alpha");
+    g_autoptr(StoreSnapApp) bravo = store_model_get_snap (model, "bravo");
+
+    g_autoptr(GPtrArray) completed = g_ptr_array_new ();
+    OperationLog log = { completed, 0 };
+    OperationResult alpha_result = { &log, "alpha", NULL };
+    OperationResult bravo_result = { &log, "bravo", NULL };
+    store_model_install_async (model, STORE_APP (alpha), NULL, NULL, install_cb, &alpha_result);
+    g_autoptr(GCancellable) cancellable = g_cancellable_new ();
+    store_model_remove_async (model, STORE_APP (bravo), cancellable, remove_cb, &bravo_result);
+
+    /* Cancelling before it starts takes it out of the queue without affecting the running one */
+    g_cancellable_cancel (cancellable);
+    g_assert_cmpint (store_app_get_state (STORE_APP (bravo)), ==, STORE_APP_STATE_IDLE);
+    g_assert_cmpint (store_app_get_queue_position (STORE_APP (bravo)), ==, 0);
+    wait_for_count (&log.n_completed, 2);
+    g_assert_cmpstr (g_ptr_array_index (completed, 0), ==, "bravo");
+    g_assert_error (bravo_result.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_assert_no_error (alpha_result.error);
+    g_assert_nonnull (mock_snapd_find_snap (snapd, "alpha"));
+    g_assert_nonnull (mock_snapd_find_snap (snapd, "bravo"));
+    g_clear_error (&bravo_result.error);
+}
+
+static void
+test_model_prefetch (void)
+{
+    g_autoptr(MockSnapd) snapd = start_snapd ();
+    mock_snap_set_summary (mock_snapd_add_store_snap (snapd, "alpha"), "SUMMARY");
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+    g_autoptr(StoreSnapApp) app = store_model_get_snap (model, "alpha");
+    guint n_summary_changes = 0;
+    g_signal_connect (app, "notify::summary", G_CALLBACK (notify_cb), &n_summary_changes);
+
+    store_model_prefetch_app (model, STORE_APP (app));
+    wait_for_count (&n_summary_changes, 1);
+    g_assert_cmpstr (store_app_get_summary (STORE_APP (app)), ==, "SUMMARY");
+}
+
+static void
+test_model_prefetch_requeue (void)
+{
+    g_autoptr(MockSnapd) snapd = start_snapd ();
+    mock_snap_set_summary (mock_snapd_add_store_snap (snapd, "alpha"), "SUMMARY");
+    mock_snapd_set_latency (snapd, "/v2/find", 500, 0);
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+    g_autoptr(StoreSnapApp) app = store_model_get_snap (model, "alpha");
+    guint n_summary_changes = 0;
+    g_signal_connect (app, "notify::summary", G_CALLBACK (notify_cb), &n_summary_changes);
+
+    /* Let the prefetch start, then leave and hover the tile again while the cancelled request is finishing */
+    store_model_prefetch_app (model, STORE_APP (app));
+    while (g_main_context_iteration (NULL, FALSE));
+    store_model_cancel_prefetch_app (model, STORE_APP (app));
+    store_model_prefetch_app (model, STORE_APP (app));
+
+    wait_for_count (&n_summary_changes, 1);
+    g_assert_cmpstr (store_app_get_summary (STORE_APP (app)), ==, "SUMMARY");
+}
+
+static void
+update_installed_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    guint *n_done = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_model_update_installed_finish (STORE_MODEL (object), result, &error));
+    g_assert_no_error (error);
+    (*n_done)++;
+}
+
+static void
+update_installed_snaps_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    guint *n_done = user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_model_update_installed_snaps_finish (STORE_MODEL (object), result, &error));
+    g_assert_no_error (error);
+    (*n_done)++;
+}
+
+static void
+test_model_update_installed_snaps (void)
+{
+    g_autoptr(MockSnapd) snapd = start_snapd ();
+    MockSnap *alpha = mock_snapd_add_snap (snapd, "alpha");
+    mock_snap_set_version (alpha, "1");
+    MockSnap *bravo = mock_snapd_add_snap (snapd, "bravo");
+
+    g_autoptr(StoreModel) model = store_model_new ();
+    store_model_set_snapd_socket_path (model, mock_snapd_get_socket_path (snapd));
+    guint n_installed_changes = 0;
+    g_signal_connect (model, "notify::installed", G_CALLBACK (notify_cb), &n_installed_changes);
+    guint n_done = 0;
+    store_model_update_installed_async (model, NULL, update_installed_cb, &n_done);
+    wait_for_count (&n_done, 1);
+    g_assert_cmpint (store_model_get_installed (model)->len, ==, 2);
+    g_assert_cmpint (n_installed_changes, ==, 1);
+
+    /* Only the requested snaps are updated, unrequested ones are left as they were */
+    mock_snap_set_version (alpha, "2");
+    mock_snap_set_status (bravo, "installed");
+    mock_snapd_add_snap (snapd, "charlie");
+    g_auto(GStrv) names = g_strsplit ("bravo,charlie,delta", ",", -1);
+    store_model_update_installed_snaps_async (model, names, NULL, update_installed_snaps_cb, &n_done);
+    wait_for_count (&n_done, 2);
+    g_assert_cmpint (n_installed_changes, ==, 2);
+    GPtrArray *installed = store_model_get_installed (model);
+    g_assert_cmpint (installed->len, ==, 2);
+    g_assert_cmpstr (store_app_get_name (g_ptr_array_index (installed, 0)), ==, "alpha");
+    g_assert_cmpstr (store_app_get_version (g_ptr_array_index (installed, 0)), ==, "1");
+    g_assert_cmpstr (store_app_get_name (g_ptr_array_index (installed, 1)), ==, "charlie");
+    g_autoptr(StoreSnapApp) bravo_app = store_model_get_snap (model, "bravo");
+    g_assert_false (store_app_get_installed (STORE_APP (bravo_app)));
+
+    /* Nothing changed, so no notification */
+    store_model_update_installed_snaps_async (model, names, NULL, update_installed_snaps_cb, &n_done);
+    wait_for_count (&n_done, 3);
+    g_assert_cmpint (n_installed_changes, ==, 2);
+}
+
+static void
+test_trace_write (void)
+{
+    g_autofree gchar *path = g_build_filename (g_get_user_cache_dir (), "trace.json", NULL);
+    g_autoptr(GError) error = NULL;
+    g_assert_true (store_trace_open (path, &error));
+    g_assert_no_error (error);
+    g_assert_true (store_trace_enabled ());
+
+    store_trace_end (store_trace_begin (), "test", "sync", "\"quoted\"");
+    store_trace_end_async (store_trace_begin (), "test", "async", NULL);
+    store_trace_close ();
+    g_assert_false (store_trace_enabled ());
+
+    /* Spans are ignored once tracing is disabled */
+    g_assert_cmpint (store_trace_begin (), ==, 0);
+
+    g_autoptr(JsonParser) parser = json_parser_new ();
+    g_assert_true (json_parser_load_from_file (parser, path, &error));
+    g_assert_no_error (error);
+    JsonArray *events = json_node_get_array (json_parser_get_root (parser));
+    g_assert_cmpint (json_array_get_length (events), ==, 4);
+    JsonObject *event = json_array_get_object_element (events, 0);
+    g_assert_cmpstr (json_object_get_string_member (event, "ph"), ==, "X");
+    g_assert_cmpstr (json_object_get_string_member (event, "name"), ==, "sync");
+    g_assert_cmpstr (json_object_get_string_member (json_object_get_object_member (event, "args"), "detail"), ==, "\"quoted\"");
+    g_assert_cmpstr (json_object_get_string_member (json_array_get_object_element (events, 1), "ph"), ==, "b");
+    g_assert_cmpstr (json_object_get_string_member (json_array_get_object_element (events, 2), "ph"), ==, "e");
+}
+
+static void
+test_model_snapshot (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+    g_autoptr(JsonNode) index = json_from_string ("[\"snapshot\"]", NULL);
+    store_cache_insert_json (cache, "sections", "_index", FALSE, index, NULL, NULL);
+    g_autoptr(JsonNode) section = json_from_string ("[\"delta\"]", NULL);
+    store_cache_insert_json (cache, "sections", "snapshot", FALSE, section, NULL, NULL);
+    g_autoptr(StoreSnapApp) app = store_snap_app_new ();
+    store_app_set_name (STORE_APP (app), "delta");
+    store_app_set_title (STORE_APP (app), "Delta");
+    store_app_save_to_cache (STORE_APP (app), cache);
+
+    /* The first load reads the individual files and saves a snapshot */
+    StoreModel *model = store_model_new ();
+    store_model_load (model);
+    g_assert_cmpint (store_model_get_categories (model)->len, ==, 1);
+    g_object_unref (model);
+
+    g_autoptr(JsonNode) snapshot = store_cache_lookup_json (cache, "snapshot", "home", FALSE, NULL, NULL);
+    g_assert_nonnull (snapshot);
+
+    /* Later loads restore from the snapshot */
+    g_autoptr(StoreModel) restored_model = store_model_new ();
+    store_model_load (restored_model);
+    GPtrArray *categories = store_model_get_categories (restored_model);
+    g_assert_cmpint (categories->len, ==, 1);
+    GPtrArray *apps = store_category_get_apps (g_ptr_array_index (categories, 0));
+    g_assert_cmpint (apps->len, ==, 1);
+    g_assert_cmpstr (store_app_get_title (g_ptr_array_index (apps, 0)), ==, "Delta");
+}
+
+static void
+search_cached_cb (GObject *object, GAsyncResult *result, gpointer user_data)
+{
+    GPtrArray **apps = user_data;
+
+    g_autoptr(GError) error = NULL;
+    *apps = store_model_search_cached_finish (STORE_MODEL (object), result, &error);
+    g_assert_no_error (error);
+}
+
+static GPtrArray *
+search_cached (StoreModel *model, GStrv terms)
+{
+    GPtrArray *apps = NULL;
+    store_model_search_cached_async (model, terms, NULL, search_cached_cb, &apps);
+    while (apps == NULL)
+        g_main_context_iteration (NULL, TRUE);
+    return apps;
+}
+
+static void
+test_model_search_cached (void)
+{
+    g_autoptr(StoreCache) cache = store_cache_new ();
+    g_autoptr(StoreSnapApp) app1 = store_snap_app_new ();
+    store_app_set_name (STORE_APP (app1), "search-one");
+    store_app_set_title (STORE_APP (app1), "Frobnicator");
+    store_app_save_to_cache (STORE_APP (app1), cache);
+    g_autoptr(StoreSnapApp) app2 = store_snap_app_new ();
+    store_app_set_name (STORE_APP (app2), "search-two");
+    store_app_set_summary (STORE_APP (app2), "Frobnicates things");
+    store_app_save_to_cache (STORE_APP (app2), cache);
+
+    /* The first search builds the index from the cached snaps */
+    StoreModel *model = store_model_new ();
+
+    /* Terms are matched case-insensitively against the name, title and summary */
+    gchar *terms[] = { "FROB", NULL };
+    g_autoptr(GPtrArray) apps = search_cached (model, terms);
+    g_assert_cmpint (apps->len, ==, 2);
+    g_assert_cmpstr (store_app_get_name (g_ptr_array_index (apps, 0)), ==, "search-one");
+    g_assert_cmpstr (store_app_get_title (g_ptr_array_index (apps, 0)), ==, "Frobnicator");
+    g_assert_cmpstr (store_app_get_name (g_ptr_array_index (apps, 1)), ==, "search-two");
+
+    /* All terms have to match */
+    gchar *narrow_terms[] = { "frob", "two", NULL };
+    g_autoptr(GPtrArray) narrow_apps = search_cached (model, narrow_terms);
+    g_assert_cmpint (narrow_apps->len, ==, 1);
+    g_assert_cmpstr (store_app_get_name (g_ptr_array_index (narrow_apps, 0)), ==, "search-two");
+    g_object_unref (model);
+
+    /* Later searches only read the saved index */
+    g_autoptr(JsonNode) index = store_cache_lookup_json (cache, "search-index", "snaps", FALSE, NULL, NULL);
+    g_assert_nonnull (index);
+    g_autoptr(GFile) snap_file = store_cache_get_file (cache, "snaps", "search-one", FALSE);
+    g_assert_true (g_file_delete (snap_file, NULL, NULL));
+    g_autoptr(StoreModel) indexed_model = store_model_new ();
+    g_autoptr(GPtrArray) indexed_apps = search_cached (indexed_model, terms);
+    g_assert_cmpint (indexed_apps->len, ==, 2);
+}
+
+int
+main (int argc, char **argv)
+{
+    /* Each test gets its own cache away from the user's one, removed when it finishes */
+    g_test_init (&argc, &argv, G_TEST_OPTION_ISOLATE_DIRS, NULL);
+
+    g_test_add_func ("/cache/insert", test_cache_insert);
+    g_test_add_func ("/cache/hash", test_cache_hash);
+    g_test_add_func ("/cache/missing", test_cache_missing);
+    g_test_add_func ("/cache/json", test_cache_json);
+    g_test_add_func ("/cache/stats", test_cache_stats);
+    g_test_add_func ("/app/cache", test_app_cache);
+    g_test_add_func ("/app/update-notify", test_app_update_notify);
+    g_test_add_func ("/category/apps", test_category_apps);
+    g_test_add_func ("/progress/update", test_progress_update);
+    g_test_add_func ("/model/get-snap", test_model_get_snap);
+    g_test_add_func ("/model/get-snap-cached", test_model_get_snap_cached);
+    g_test_add_func ("/model/snapshot", test_model_snapshot);
+    g_test_add_func ("/model/search-cached", test_model_search_cached);
+    g_test_add_func ("/model/media-policy", test_model_media_policy);
+    g_test_add_func ("/model/media-policy-for-network", test_media_policy_for_network);
+    g_test_add_func ("/model/image-host-limit", test_model_image_host_limit);
+    g_test_add_func ("/model/image-priority", test_model_image_priority);
+    g_test_add_func ("/model/image-cancel", test_model_image_cancel);
+    g_test_add_func ("/model/thumbnail-replaced", test_model_thumbnail_replaced);
+    g_test_add_func ("/model/reviews-cancel", test_model_reviews_cancel);
+    g_test_add_func ("/model/update-installed-snaps", test_model_update_installed_snaps);
+    g_test_add_func ("/model/prefetch", test_model_prefetch);
+    g_test_add_func ("/model/prefetch-requeue", test_model_prefetch_requeue);
+    g_test_add_func ("/model/operation-order", test_model_operation_order);
+    g_test_add_func ("/model/operation-cancel-queued", test_model_operation_cancel_queued);
+    g_test_add_func ("/model/refresh-all-conflict", test_model_refresh_all_conflict);
+    g_test_add_func ("/trace/write", test_trace_write);
+
+    return g_test_run ();
+}